@@ -1,884 +1,1219 @@
-#include "raylib.h"
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
-#include <math.h>
-
-#if defined(PLATFORM_WEB)
-    #include <emscripten/emscripten.h>
-#endif
-
-//----------------------------------------------------------------------------------
-// Some Defines
-//----------------------------------------------------------------------------------
-#define SQUARE_SIZE             30
-
-#define GRID_HORIZONTAL_SIZE    12
-#define GRID_VERTICAL_SIZE      20
-
-#define LATERAL_SPEED           15
-#define TURNING_SPEED           12
-#define FAST_FALL_AWAIT_COUNTER 30
-
-#define FADING_TIME             33
-
-//----------------------------------------------------------------------------------
-// Types and Structures Definition
-//----------------------------------------------------------------------------------
-typedef enum GridSquare { EMPTY, MOVING, FULL, BLOCK, FADING } GridSquare;
-typedef enum GameState { TITLE_SCREEN, TUTORIAL, PLAYING, GAME_OVER } GameState;
-
-//------------------------------------------------------------------------------------
-// Global Variables Declaration
-//------------------------------------------------------------------------------------
-static const int screenWidth = 840;
-static const int screenHeight = 620;
-
-static Texture2D Titull;
-static Texture2D GameScreen;
-static Texture2D GameOvers;
-static Texture2D TLC;
-
-static bool gameOver = false;
-static bool pause = false;
-
-static int gameOverTimer = 0;
-static bool gameOverTriggered = false;
-
-static GameState currentGameState = TITLE_SCREEN;
-
-//Block Sprites
-Texture2D RedTexture;
-Texture2D BlueTexture;
-Texture2D YellowTexture;
-
-// Matrices
-static GridSquare grid [GRID_HORIZONTAL_SIZE][GRID_VERTICAL_SIZE];
-static GridSquare piece [4][4];
-static GridSquare incomingPiece [4][4];
-Color boardColors[GRID_HORIZONTAL_SIZE][GRID_VERTICAL_SIZE] = {0};
-
-// Theese variables keep track of the active piece position
-static int piecePositionX = 0;
-static int piecePositionY = 0;
-
-// Game parameters
-static Color fadingColor;
-static bool beginPlay = true;      
-static bool pieceActive = false;
-static bool detection = false;
-static bool lineToDelete = false;
-static Color pieceColor;
-static Color gridColors[GRID_HORIZONTAL_SIZE][GRID_VERTICAL_SIZE]; 
-
-
-// Statistics
-static int level = 1;
-static int lines = 0;
-static int score = 0;
-static int hiscore = 0;
-
-//music
-static Music music;
-
-// Counters
-static int gravityMovementCounter = 0;
-static int lateralMovementCounter = 0;
-static int turnMovementCounter = 0;
-static int fastFallMovementCounter = 0;
-
-static int fadeLineCounter = 0;
-
-static int gravitySpeed = 15;
-
-//------------------------------------------------------------------------------------
-// Module Functions Declaration (local)
-//------------------------------------------------------------------------------------
-static void InitGame(void);         // Initialize game
-static void UpdateGame(void);       // Update game (one frame)
-static void DrawGame(void);         // Draw game (one frame)
-static void UnloadGame(void);       // Unload game
-static void UpdateDrawFrame(void);  // Update and Draw (one frame)
-
-// Additional module functions
-static bool Createpiece();
-static void GetRandompiece();
-static void ResolveFallingMovement(bool *detection, bool *pieceActive);
-static bool ResolveLateralMovement();
-static bool ResolveTurnMovement();
-static void CheckDetection(bool *detection);
-static void CheckCompletion(bool *lineToDelete);
-static int DeleteCompleteLines();
-
-//------------------------------------------------------------------------------------
-// Program main entry point
-//------------------------------------------------------------------------------------
-int main(void)
-{
-    // Initialization (Note windowTitle is unused on Android)
-    //---------------------------------------------------------
-    InitWindow(screenWidth, screenHeight, "Mega's Nuclear Waste Dump");
-    InitAudioDevice(); 
-
-    
-    InitGame();
-
-#if defined(PLATFORM_WEB)
-    emscripten_set_main_loop(UpdateDrawFrame, 60, 1);
-#else
-    SetTargetFPS(60);
-    //--------------------------------------------------------------------------------------
-
-    // Main game loop
-    while (!WindowShouldClose())    // Detect window close button or ESC key
-    {
-        
-        // Update and Draw
-        //----------------------------------------------------------------------------------
-        UpdateDrawFrame();
-        //----------------------------------------------------------------------------------
-    }
-#endif
-    // De-Initialization
-    //--------------------------------------------------------------------------------------
-    UnloadGame();         // Unload loaded data (textures, sounds, models...)
-
-    CloseWindow();        // Close window and OpenGL context
-    //--------------------------------------------------------------------------------------
-
-    return 0;
-}
-
-//--------------------------------------------------------------------------------------
-// Game Module Functions Definition
-//--------------------------------------------------------------------------------------
-
-// Initialize game variables
-void InitGame(void)
-{
-    // Initialize game statistics
-    level = 1;
-    lines = 0;
-    score = 0;
-
-    // Initialize the audio system
-    music = LoadMusicStream("theme.mp3"); 
-    
-    fadingColor = GRAY;
-
-    piecePositionX = 0;
-    piecePositionY = 0;
-
-    pause = false;
-
-    beginPlay = true;
-    pieceActive = false;
-    detection = false;
-    lineToDelete = false;
-
-    RedTexture = LoadTexture("RedBarrell.png");
-    BlueTexture = LoadTexture("BlueBarrell.png");
-    YellowTexture = LoadTexture("YellowBarrell.png");
-    GameScreen = LoadTexture("GameScreen.png");
-    GameOvers = LoadTexture("GameOver.png");
-    TLC = LoadTexture("Tut.png");
-    Titull = LoadTexture("TitleProbably.png");
-
-
-    // Counters
-    gravityMovementCounter = 0;
-    lateralMovementCounter = 0;
-    turnMovementCounter = 0;
-    fastFallMovementCounter = 0;
-
-    fadeLineCounter = 0;
-    gravitySpeed = 15;
-
-    // Initialize grid matrices
-    for (int i = 0; i < GRID_HORIZONTAL_SIZE; i++)
-    {
-        for (int j = 0; j < GRID_VERTICAL_SIZE; j++)
-        {
-            if ((j == GRID_VERTICAL_SIZE - 1) || (i == 0) || (i == GRID_HORIZONTAL_SIZE - 1)) grid[i][j] = BLOCK;
-            else grid[i][j] = EMPTY;
-        }
-    }
-    
-    
-    // Initialize incoming piece matrices
-    for (int i = 0; i < 4; i++)
-    {
-        for (int j = 0; j< 4; j++)
-        {
-            incomingPiece[i][j] = EMPTY;
-        }
-    }
-    
-
-}
-
-// Update game (one frame)
-void UpdateGame(void)
-{
-    
-    if (currentGameState == TITLE_SCREEN)
-    {
-        if (IsKeyPressed(KEY_ENTER)) 
-        {
-            currentGameState = TUTORIAL;
-        }
-    }
-    
-    else if (currentGameState == TUTORIAL)
-    {
-        if (IsKeyPressed(KEY_ENTER)) 
-        {
-            currentGameState = PLAYING;
-            InitGame();
-        }
-    }
-    
-
-    else if (currentGameState == PLAYING)
-    {
-
-        UpdateMusicStream(music);
-            PlayMusicStream(music);
-        
-            if (gameOverTriggered)
-            {
-                gameOverTimer--;
-                if (gameOverTimer <= 0)
-                {
-                    
-                    currentGameState = GAME_OVER;
-                }
-            }
-            else
-            {
-
-                if (!pause)
-                {
-                    if (!lineToDelete)
-                    {
-                        if (!pieceActive)
-                        {
-                            pieceActive = Createpiece();
-                            fastFallMovementCounter = 0;
-                        }
-                        else
-                        {
-                            fastFallMovementCounter++;
-                            gravityMovementCounter++;
-                            lateralMovementCounter++;
-                            turnMovementCounter++;
-
-                            if (IsKeyPressed(KEY_LEFT) || IsKeyPressed(KEY_RIGHT)) lateralMovementCounter = LATERAL_SPEED;
-                            if (IsKeyPressed(KEY_UP)) turnMovementCounter = TURNING_SPEED;
-
-                            if (IsKeyDown(KEY_DOWN) && (fastFallMovementCounter >= FAST_FALL_AWAIT_COUNTER))
-                            {
-                                gravityMovementCounter += gravitySpeed;
-                            }
-
-                            if (gravityMovementCounter >= gravitySpeed)
-                            {
-                                CheckDetection(&detection);
-                                ResolveFallingMovement(&detection, &pieceActive);
-                                CheckCompletion(&lineToDelete);
-                                gravityMovementCounter = 0;
-                            }
-
-                            if (lateralMovementCounter >= LATERAL_SPEED)
-                            {
-                                if (!ResolveLateralMovement()) lateralMovementCounter = 0;
-                            }
-
-                            if (turnMovementCounter >= TURNING_SPEED)
-                            {
-                                if (ResolveTurnMovement()) turnMovementCounter = 0;
-                            }
-                        }
-
-                        for (int j = 0; j < 2; j++)
-                        {
-                            for (int i = 1; i < GRID_HORIZONTAL_SIZE - 1; i++)
-                            {
-                                if (grid[i][j] == FULL)
-                                {
-                                    gameOver = true;
-                                    currentGameState = GAME_OVER;
-                                }
-                            }
-                        }
-                    }
-                    else
-                    {
-                        fadeLineCounter++;
-
-                        if (fadeLineCounter % 8 < 4) fadingColor = WHITE;
-                        else fadingColor = GRAY;
-
-                        if (fadeLineCounter >= FADING_TIME)
-                        {
-                            int deletedLines = DeleteCompleteLines();
-                            fadeLineCounter = 0;
-                            lineToDelete = false;
-                            lines += deletedLines;
-                            score += (56 + (lines * 98));
-                        }
-                    }
-                }
-            }
-        }
-        
-    else if (currentGameState == GAME_OVER)
-    {
-    
-        if (IsKeyPressed(KEY_ENTER))
-        {
-            if (score > hiscore){hiscore = score;}
-            gameOverTimer = 120;
-            gameOverTriggered = false;
-            gameOver = false;
-            currentGameState = TITLE_SCREEN;
-            
-            StopMusicStream(music);   
-           
-        }
-    }
-}
-
-// Draw game (one frame)
-void DrawGame(void)
-{
-    BeginDrawing();
-    ClearBackground(RAYWHITE);
-
-    if (currentGameState == TITLE_SCREEN)
-    {
-        DrawTexture(Titull, 0, 0, WHITE);
-        DrawText("High Score", screenWidth/2 - MeasureText("High Score", 20)/2, 5, 20, RED);
-        DrawText(TextFormat("%05i", hiscore), screenWidth/2 - MeasureText("00000", 20)/2, 25, 20, WHITE);        
-        DrawText("Press [Enter] to Start", screenWidth/2 - MeasureText("Press [Enter] to Start", 30)/2, screenHeight/2 + 62, 30, WHITE);
-        DrawText("© 2025 MegaKoopa255", screenWidth/2 - MeasureText("© 2025 MegaKoopa255", 20)/2, screenHeight-20, 20, WHITE);
-
-    }
-    
-    else if (currentGameState == TUTORIAL)
-    {
-        DrawTexture(TLC, 0, 0, WHITE);
-        DrawText("After 39 long years, Uncle Henry has retired from his job at the", 35, 30, 20, WHITE);
-        DrawText("nuclear waste dump and has sold the land to me!", 35, 50, 20, WHITE);
-        DrawText("As my newest employee, you are now tasked with taking up the duties", 35, 70, 20, WHITE);
-        DrawText("of handling the toxic waste.", 35, 90, 20, WHITE);
-        DrawText("Basically, you must dispose of the waste by making rows, but avoid", 35, 110, 20, WHITE);
-        DrawText("matching the same colors. If you try to stack a container of waste on", 35, 130, 20, WHITE);
-        DrawText("top of another, it will fall to the side (it prioritizes the left, then,", 35, 150, 20, WHITE);
-        DrawText("the right) so be mindful of that! Additionally, clearing a row can sometimes", 35, 170, 20, WHITE);
-        DrawText("mutate the remaining containers on the board into different types.", 35, 190, 20, WHITE);
-        DrawText("I hope you've got insurance!", 35, 210, 20, WHITE);
-        
-
-    }
-    
-    else if (currentGameState == PLAYING)
-    {
-
-        
-        DrawTexture(GameScreen, 0, 0, WHITE);
-        
-            // Draw gameplay area
-            Vector2 offset;
-            offset.x = screenWidth/2 - (GRID_HORIZONTAL_SIZE*SQUARE_SIZE/2) - 50;
-            offset.y = screenHeight/2 - ((GRID_VERTICAL_SIZE - 1)*SQUARE_SIZE/2) + SQUARE_SIZE*2;
-
-            offset.y -= 50;     
-
-            int controller = offset.x; 
-
-            for (int j = 0; j < GRID_VERTICAL_SIZE; j++)
-            {
-                for (int i = 0; i < GRID_HORIZONTAL_SIZE; i++)
-                {
-                    // Draw each square of the grid
-                    if (grid[i][j] == EMPTY)
-                    {
-                        DrawLine(offset.x, offset.y, offset.x + SQUARE_SIZE, offset.y, GRAY );
-                        DrawLine(offset.x, offset.y, offset.x, offset.y + SQUARE_SIZE, GRAY );
-                        DrawLine(offset.x + SQUARE_SIZE, offset.y, offset.x + SQUARE_SIZE, offset.y + SQUARE_SIZE, GRAY );
-                        DrawLine(offset.x, offset.y + SQUARE_SIZE, offset.x + SQUARE_SIZE, offset.y + SQUARE_SIZE, GRAY );
-                        offset.x += SQUARE_SIZE;
-                    }
-                    else if (grid[i][j] == FULL)
-                    {
-                        if (grid[i][j] == FULL)
-                        {
-                            if (gridColors[i][j].r == RED.r && gridColors[i][j].g == RED.g && gridColors[i][j].b == RED.b)
-                            {
-                                DrawTexture(RedTexture, offset.x, offset.y, WHITE);
-                            }
-                            else if (gridColors[i][j].r == BLUE.r && gridColors[i][j].g == BLUE.g && gridColors[i][j].b == BLUE.b)
-                            {
-                                DrawTexture(BlueTexture, offset.x, offset.y, WHITE);
-                            }
-                            else if (gridColors[i][j].r == YELLOW.r && gridColors[i][j].g == YELLOW.g && gridColors[i][j].b == YELLOW.b)
-                            {
-                                DrawTexture(YellowTexture, offset.x, offset.y, WHITE);
-                            }
-                        }
-                        offset.x += SQUARE_SIZE;
-                    }
-                    else if (grid[i][j] == MOVING)
-                    {
-                        
-                        Color movingColor = pieceColor; 
-
-                        if (movingColor.r == RED.r && movingColor.g == RED.g && movingColor.b == RED.b)
-                        {
-                            DrawTexture(RedTexture, offset.x, offset.y, WHITE);
-                        }
-                        else if (movingColor.r == BLUE.r && movingColor.g == BLUE.g && movingColor.b == BLUE.b)
-                        {
-                            DrawTexture(BlueTexture, offset.x, offset.y, WHITE);
-                        }
-                        else if (movingColor.r == YELLOW.r && movingColor.g == YELLOW.g && movingColor.b == YELLOW.b)
-                        {
-                            DrawTexture(YellowTexture, offset.x, offset.y, WHITE);
-                        }
-                        else
-                        {
-                            DrawRectangle(offset.x, offset.y, SQUARE_SIZE, SQUARE_SIZE, GRAY);
-                        }
-
-                        offset.x += SQUARE_SIZE;
-                    }
-                    else if (grid[i][j] == BLOCK)
-                    {
-                        
-                        offset.x += SQUARE_SIZE;
-                    }
-                    else if (grid[i][j] == FADING)
-                    {
-                        DrawRectangle(offset.x, offset.y, SQUARE_SIZE, SQUARE_SIZE, fadingColor);
-                        offset.x += SQUARE_SIZE;
-                    }
-                }
-
-                offset.x = controller;
-                offset.y += SQUARE_SIZE;
-            }
-
-            // Draw incoming piece (hardcoded)
-            offset.x = 600;
-            offset.y = 45;
-
-            int controler = offset.x;
-
-            for (int j = 0; j < 4; j++)
-            {
-                for (int i = 0; i < 4; i++)
-                {
-                    if (incomingPiece[i][j] == EMPTY)
-                    {
-
-                    }
-                    else if (incomingPiece[i][j] == MOVING)
-                    {
-                     
-                        offset.x += SQUARE_SIZE;
-                    }
-                }
-
-                offset.x = controler;
-                offset.y += SQUARE_SIZE;
-            }
-
-            DrawText("!!!  DANGER  !!!", offset.x-20, offset.y - 100, 30, BLACK);
-            DrawText(TextFormat("  Lines:   %04i", lines), offset.x-25, offset.y + 0, 30, WHITE);
-            DrawText(TextFormat(" Score:   %05i", score), offset.x-25, offset.y + 40, 30, WHITE);
-            DrawText(TextFormat("Hi Score: %05i", hiscore), offset.x-25, offset.y + 80, 30, WHITE);           
-            
-
-            if (pause) DrawText("GAME PAUSED", screenWidth/2 - MeasureText("GAME PAUSED", 40)/2, screenHeight/2 - 40, 40, WHITE);
-        }
-        else if (currentGameState == GAME_OVER) {         DrawTexture(GameOvers, 0, 0, WHITE);
-        DrawText("Good help is so hard to find...", GetScreenWidth()/2 - MeasureText("Good help is so hard to find...", 50)/2, GetScreenHeight()/2 - 130, 50, RED);
-             DrawText(TextFormat("Final Score:   %05i", score), GetScreenWidth()/2 - MeasureText("Final Score:   00000", 30)/2, GetScreenHeight()/2 - 70, 30, WHITE);
-             DrawText(TextFormat("Previous High Score:   %05i", hiscore), GetScreenWidth()/2 - MeasureText("Previous High Score:   00000", 30)/2, GetScreenHeight()/2 - 30, 30, WHITE);
-        DrawText("Press [Enter] to Play Again", GetScreenWidth()/2 - MeasureText("Press [Enter] to Play Again", 30)/2, GetScreenHeight()/2 + 10, 30, WHITE); }
-
-    
-
-    EndDrawing();
-}
-
-// Unload game variables
-void UnloadGame(void)
-{
-    // TODO: Unload all dynamic loaded data (textures, sounds, models...)
-}
-
-// Update and Draw (one frame)
-void UpdateDrawFrame(void)
-{
-    UpdateGame();
-    DrawGame();
-}
-
-//--------------------------------------------------------------------------------------
-// Additional module functions
-//--------------------------------------------------------------------------------------
-static bool Createpiece()
-{
-    piecePositionX = (int)((GRID_HORIZONTAL_SIZE - 4)/2);
-    piecePositionY = -4;
-
-    // If the game is starting and you are going to create the first piece, we create an extra one
-    if (beginPlay)
-    {
-        GetRandompiece();
-        beginPlay = false;
-    }
-
-    // We assign the incoming piece to the actual piece
-    for (int i = 0; i < 4; i++)
-    {
-        for (int j = 0; j< 4; j++)
-        {
-            piece[i][j] = incomingPiece[i][j];
-        }
-    }
-
-    // We assign a random piece to the incoming one
-    GetRandompiece();
-
-    // Assign the piece to the grid
-    for (int i = piecePositionX; i < piecePositionX + 4; i++)
-    {
-        for (int j = 0; j < 4; j++)
-        {
-            if (piece[i - (int)piecePositionX][j] == MOVING) grid[i][j] = MOVING;
-        }
-    }
-
-    return true;
-}
-
-static void GetRandompiece()
-{
-    int random = GetRandomValue(0, 6);
-
-    for (int i = 0; i < 4; i++)
-    {
-        for (int j = 0; j < 4; j++)
-        {
-            incomingPiece[i][j] = EMPTY;
-        }
-    }
-
-    for (int i = 0; i < 4; i++)
-    {
-        for (int j = 0; j < 4; j++)
-        {
-            incomingPiece[i][j] = EMPTY;
-        }
-    }
-
-    // Generate a single block in a random position within the 4x4 grid
-    int x = GetRandomValue(0, 3);
-    int y = GetRandomValue(0, 3);
-    incomingPiece[x][y] = MOVING;
-    
-    int colorChoice = GetRandomValue(0, 2);
-    switch (colorChoice)
-{
-    case 0: pieceColor = RED; break;
-    case 1: pieceColor = BLUE; break;
-    case 2: pieceColor = YELLOW; break;
-}
-
-}
-
-static void ResolveFallingMovement(bool *detection, bool *pieceActive)
-{
-    // If we finished moving this piece, we stop it
-    if (*detection)
-    {
-        for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
-        {
-            for (int i = 1; i < GRID_HORIZONTAL_SIZE - 1; i++)
-            {                
-                if (grid[i][j] == MOVING)
-                    {
-                        grid[i][j] = FULL;
-                        score += (1+(abs(19-((2*lines)+1)))/4);;
-                        *detection = false;
-                        *pieceActive = false;
-                        boardColors[i][j] = pieceColor;
-                        gridColors[i][j] = pieceColor;
-
-                        // Variables to check if movement is possible
-                        bool canMoveDownLeft = false;
-                        bool canMoveDownRight = false;
-
-                        // Check if the block can move diagonally down-left
-                        if (i < GRID_HORIZONTAL_SIZE - 1 && j < GRID_VERTICAL_SIZE - 1 && grid[i-1][j+1] == EMPTY) 
-                        {
-                            canMoveDownLeft = true;
-                        }
-
-                        // Check if the block can move diagonally down-right
-                        if (i < GRID_HORIZONTAL_SIZE - 1 && j < GRID_VERTICAL_SIZE - 1 && grid[i+1][j+1] == EMPTY) 
-                        {
-                            canMoveDownRight = true;
-                        }
-
-                        // Move Down-Left continuously
-                        while (canMoveDownLeft)
-                        {
-                            grid[i][j] = EMPTY;  
-                            grid[i-1][j+1] = FULL; 
-                            gridColors[i-1][j+1] = pieceColor;
-
-                            j++;   
-                            i--;
-                            score++;
-                         
-                            if (j >= GRID_VERTICAL_SIZE - 1 || i <= 0 || grid[i-1][j+1] != EMPTY)
-                                break;
-                        }
-
-                        // Move Down-Right continuously 
-                        while (!canMoveDownLeft && canMoveDownRight)
-                        {
-                            grid[i][j] = EMPTY;  
-                            grid[i+1][j+1] = FULL; 
-                            gridColors[i+1][j+1] = pieceColor;
-
-                            j++;   
-                            i++;  
-                            score++;
-
-                            if (j >= GRID_VERTICAL_SIZE - 1 || i >= GRID_HORIZONTAL_SIZE - 1 || grid[i+1][j+1] != EMPTY)
-                                break;
-                        }
-
-
-                        // Game Over Condition: Check for adjacent same-color blocks
-                        if ((i > 0 && grid[i-1][j] == FULL && gridColors[i-1][j].r == pieceColor.r &&
-                                       gridColors[i-1][j].g == pieceColor.g &&
-                                       gridColors[i-1][j].b == pieceColor.b) ||
-                            (i < GRID_HORIZONTAL_SIZE - 1 && grid[i+1][j] == FULL && gridColors[i+1][j].r == pieceColor.r &&
-                                                           gridColors[i+1][j].g == pieceColor.g &&
-                                                           gridColors[i+1][j].b == pieceColor.b) ||
-                            (j > 0 && grid[i][j-1] == FULL && gridColors[i][j-1].r == pieceColor.r &&
-                                                         gridColors[i][j-1].g == pieceColor.g &&
-                                                         gridColors[i][j-1].b == pieceColor.b) ||
-                            (j < GRID_VERTICAL_SIZE - 1 && grid[i][j+1] == FULL && gridColors[i][j+1].r == pieceColor.r &&
-                                                                   gridColors[i][j+1].g == pieceColor.g &&
-                                                                   gridColors[i][j+1].b == pieceColor.b))
-                        {
-
-                            if (!gameOverTriggered)  
-                            {  
-                                gameOverTriggered = true;
-                                    score -= 200;
-                                
-                                gameOverTimer = 120;   
-                            }
-                        }
-                    }
-            }
-        }
-    }
-    else    
-    {
-        for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
-        {
-            for (int i = 1; i < GRID_HORIZONTAL_SIZE - 1; i++)
-            {
-                if (grid[i][j] == MOVING)
-                {
-                    grid[i][j+1] = MOVING;
-                    grid[i][j] = EMPTY;
-                }
-            }
-        }
-
-        piecePositionY++;
-    }
-}
-
-static bool ResolveLateralMovement()
-{
-    bool collision = false;
-
-    // Piece movement
-    if (IsKeyDown(KEY_LEFT))        // Move left
-    {
-        // Check if is possible to move to left
-        for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
-        {
-            for (int i = 1; i < GRID_HORIZONTAL_SIZE - 1; i++)
-            {
-                if (grid[i][j] == MOVING)
-                {
-                    // Check if we are touching the left wall or we have a full square at the left
-                    if ((i-1 == 0) || (grid[i-1][j] == FULL)) collision = true;
-                }
-            }
-        }
-
-        // If able, move left
-        if (!collision)
-        {
-            for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
-            {
-                for (int i = 1; i < GRID_HORIZONTAL_SIZE - 1; i++)            
-                {
-                    
-                    if (grid[i][j] == MOVING)
-                    {
-                        grid[i-1][j] = MOVING;
-                        grid[i][j] = EMPTY;
-                    }
-                }
-            }
-
-            piecePositionX--;
-        }
-    }
-    else if (IsKeyDown(KEY_RIGHT))  // Move right
-    {
-        // Check if is possible to move to right
-        for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
-        {
-            for (int i = 1; i < GRID_HORIZONTAL_SIZE - 1; i++)
-            {
-                if (grid[i][j] == MOVING)
-                {
-                    // Check if we are touching the right wall or we have a full square at the right
-                    if ((i+1 == GRID_HORIZONTAL_SIZE - 1) || (grid[i+1][j] == FULL))
-                    {
-                        collision = true;
-
-                    }
-                }
-            }
-        }
-
-        // If able move right
-        if (!collision)
-        {
-            for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
-            {
-                for (int i = GRID_HORIZONTAL_SIZE - 1; i >= 1; i--)             // We check the matrix from right to left
-                {
-                    // Move everything to the right
-                    if (grid[i][j] == MOVING)
-                    {
-                        grid[i+1][j] = MOVING;
-                        grid[i][j] = EMPTY;
-                    }
-                }
-            }
-
-            piecePositionX++;
-        }
-    }
-
-    return collision;
-}
-
-static bool ResolveTurnMovement()
-{
-    // Input for turning the piece
-
-    return false;
-}
-
-static void CheckDetection(bool *detection)
-{
-    for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
-    {
-        for (int i = 1; i < GRID_HORIZONTAL_SIZE - 1; i++)
-        {
-            if ((grid[i][j] == MOVING) && ((grid[i][j+1] == FULL) || (grid[i][j+1] == BLOCK))) *detection = true;
-        }
-    }
-}
-
-static void CheckCompletion(bool *lineToDelete)
-{
-    int calculator = 0;
-
-    for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
-    {
-        calculator = 0;
-        for (int i = 1; i < GRID_HORIZONTAL_SIZE - 1; i++)
-        {
-            // Count each square of the line
-            if (grid[i][j] == FULL)
-            {
-                calculator++;
-            }
-
-            // Check if we completed the whole line
-            if (calculator == GRID_HORIZONTAL_SIZE - 2)
-            {
-                *lineToDelete = true;
-                calculator = 0;
-                
-
-                // Mark the completed line
-                for (int z = 1; z < GRID_HORIZONTAL_SIZE - 1; z++)
-                {
-                    grid[z][j] = FADING;
-                }
-            }
-        }
-    }
-}
-
-static int DeleteCompleteLines()
-{
-    int deletedLines = 0;
-
-    // Erase the completed line
-    for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
-    {
-        while (grid[1][j] == FADING)
-        {
-            for (int i = 1; i < GRID_HORIZONTAL_SIZE - 1; i++)
-            {
-                grid[i][j] = EMPTY;
-            }
-            for (int j2 = j-1; j2 >= 0; j2--)
-            {
-                for (int i2 = 1; i2 < GRID_HORIZONTAL_SIZE - 1; i2++)
-                {
-                    if (grid[i2][j2] == FULL)
-                    {
-                        grid[i2][j2+1] = FULL;
-                        grid[i2][j2] = EMPTY;
-                    }
-                    else if (grid[i2][j2] == FADING)
-                    {
-                        grid[i2][j2+1] = FADING;
-                        grid[i2][j2] = EMPTY;
-                    }
-                }
-            }
-             deletedLines++;
-        }
-    }
-    
-    if (deletedLines > 0) { 
-        gravitySpeed -= deletedLines;
-        
-    if (gravitySpeed < 4) gravitySpeed = 4; 
-}
-    return deletedLines;
-}
\ No newline at end of file
+#include "raylib.h"
+#include "NukeleerCore.h"
+#include "NukeleerReplay.h"
+#include "NukeleerRender.h"
+#include "NukeleerAssets.h"
+#include "NukeleerPack.h"
+#include "NukeleerAudio.h"
+#include "NukeleerInput.h"
+#include "NukeleerProfile.h"
+#include "NukeleerAutoplay.h"
+#include "NukeleerScores.h"
+#include "NukeleerNet.h"
+#include "NukeleerSnapshot.h"
+#include "NukeleerBroadcast.h"
+#include "NukeleerTelemetry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#if defined(PLATFORM_WEB)
+    #include <emscripten/emscripten.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define MAX_REPLAY_SPEED        16
+#define SIM_TICK_TIME           (1.0/60.0)  // The rules count ticks, one tick is always this long
+#define MAX_TICKS_PER_FRAME     8           // After a longer stall the backlog is dropped instead of fast-forwarded
+#define LOAD_BUDGET             0.004       // Seconds per frame spent on gameplay assets behind the title screens
+#define ATTRACT_DELAY           20.0        // Seconds on the title screen before a demo game starts
+#define BOARD_SCROLL_SPEED      8.0f        // How fast a board larger than the playfield pans after the piece
+#define SPECTATOR_RECONNECT     2.0         // Seconds without a snapshot before the spectator looks for a new broadcast
+#define IDLE_POLL_TIME          (1.0/30.0)  // Input check interval while a static screen is up, the most a key press waits
+#define THROTTLED_FRAME_TIME    (1.0/15.0)  // Frame interval of a game nobody is looking at, ticks still keep real time
+
+// Statistics panel, the area of the cached HUD layer
+#define HUD_X                   560
+#define HUD_Y                   165
+#define HUD_WIDTH               280
+#define HUD_HEIGHT              110
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum GameState { TITLE_SCREEN, TUTORIAL, LOADING, PLAYING, GAME_OVER } GameState;
+
+// How often frames are run: static screens (title, tutorial, game over, pause) are drawn
+// again only for input or a timer, a game in an unfocused or minimized window at a
+// reduced rate. Audio plays from its own thread either way.
+typedef enum FramePace { PACE_ACTIVE, PACE_THROTTLED, PACE_IDLE, PACE_HIDDEN, PACE_COUNT } FramePace;
+
+// Gameplay assets, loaded a step at a time while the title and tutorial are up
+typedef enum LoadStep { LOAD_MUSIC, LOAD_ATLAS, LOAD_GAME_SCREEN, LOAD_GAME_OVER, LOAD_PLAYFIELD_LAYERS, LOAD_DONE } LoadStep;
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+static const int screenWidth = 840;
+static const int screenHeight = 620;
+
+// Asset handles, loaded once per run and freed in UnloadGame()
+static AssetHandle Titull;
+static AssetHandle GameScreen;
+static AssetHandle GameOvers;
+static AssetHandle TLC;
+
+static bool pause = false;
+static bool exitRequested = false;  // Not even a default board fits in memory, the main loop ends
+
+static GameState currentGameState = TITLE_SCREEN;
+
+// Rules state of the game being played
+static GameContext game = { 0 };
+static RuleSet gameRules = { 0 };   // Default rules, the board size can be set on the command line
+static Vector2 boardScroll = { 0 }; // Board pixel at the playfield's top-left corner
+
+// Replays: every played game is recorded, a replay file given on the command line is played back
+static Replay replay = { 0 };
+static ReplayPlayer replayPlayer = { 0 };
+static bool replayMode = false;
+static int replaySpeed = 1;         // Rule ticks per simulation tick while watching a replay (1, 4 or 16)
+
+// Attract mode: left alone on the title screen, the autoplayer plays a demo game
+static Autoplayer autoplayer = { 0 };
+static bool demoMode = false;
+static double titleIdleTime = 0.0;
+
+// Online match: the game runs here as usual, the server follows its inputs and sends garbage
+static NetClient netClient = { 0 };
+static bool netMode = false;
+
+// Event screens: one game mirrors every tick as a snapshot into shared memory, any number
+// of spectator windows on the same machine draw it
+static Broadcaster broadcaster = { 0 };
+static SnapshotEncoder snapshotEncoder = { 0 };
+static bool broadcastMode = false;
+static Spectator spectator = { 0 };
+static SnapshotDecoder snapshotDecoder = { 0 };
+static bool spectateMode = false;
+static double spectatorIdleTime = 0.0;
+
+// Gameplay events of the games played here, written to telemetry.nkt by a background thread
+static TelemetryRing *gameTelemetry = NULL;
+
+// Fixed-step simulation clock, rendering runs at whatever rate the display allows
+static double tickAccumulator = 0.0;
+static int tickPieceX = 0;          // Piece position before the last tick, for interpolation
+static int tickPieceY = 0;
+static bool tickPieceMoved = false;
+
+// Frame scheduler: frames are timed here rather than by GetFrameTime(), which only
+// covers the last drawn frame and would miss the time spent waiting on a static screen
+static FramePace framePace = PACE_ACTIVE;
+static double frameStart = 0.0;
+static double frameDelta = 0.0;     // Seconds since the previous frame's update
+static double paceClock = 0.0;
+static double paceTime[PACE_COUNT] = { 0 };
+static int paceFrames[PACE_COUNT] = { 0 };
+
+static bool showDebugOverlay = false;   // F3
+
+#if defined(NUKELEER_PROFILE)
+static bool showProfiler = false;       // F2, F4 saves a trace
+#endif
+
+// Statistics
+static int hiscore = 0;
+static ScoreEntry todayScores[5] = { 0 };  // Best of the day, refreshed when a game ends
+static int todayScoreCount = 0;
+static ScoreEntry lastScore = { 0 };
+
+//music
+static AssetHandle music;
+
+// Startup timing, reported once the first frame is on screen
+static double startTime = 0.0;
+static bool firstFrameShown = false;
+
+static LoadStep loadStep = LOAD_MUSIC;
+
+// Cached render layers, only re-rendered when what they show changes
+static RenderTexture2D titleLayer = { 0 };
+static RenderTexture2D tutorialLayer = { 0 };
+static RenderTexture2D backgroundLayer = { 0 };     // GameScreen.png and static labels
+static RenderTexture2D hudLayer = { 0 };            // Lines, score and high score
+static int titleHiscore = -1;
+static int hudLines = -1;
+static int hudScore = -1;
+static int hudHiscore = -1;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void LoadResources(void);    // Load the title screens and start loading the rest (once)
+static void InitGame(void);         // Initialize game
+static void UpdateGame(void);       // Update game (one frame)
+static void DrawGame(void);         // Draw game (one frame)
+static void UnloadGame(void);       // Unload game
+static void UpdateDrawFrame(void);  // Update and Draw (one frame)
+
+// Additional module functions
+static void UpdateGameTick(void);
+static void UpdateReplayPlayback(void);
+static void EndDemo(void);
+static void ConnectOnline(const char *address);
+static void DrawOnlineStatus(void);
+static void BroadcastGame(void);
+static void UpdateSpectator(void);
+static Vector2 GetPieceOffset(void);
+static void LogInputLatency(void);
+#if defined(NUKELEER_PROFILE)
+static void UpdateProfiler(void);
+static void DrawProfiler(void);
+#endif
+static void SaveSessionReplay(void);
+static void SaveSessionScore(void);
+static void UpdateLoading(void);
+static bool RunLoadStep(LoadStep step);
+static Vector2 GetBoardOrigin(void);
+static Rectangle GetBoardView(void);
+static double GetWallTime(void);
+static void LoadScreenLayers(void);
+static void LoadPlayfieldLayers(void);
+static void UnloadRenderLayers(void);
+static void UpdateRenderLayers(void);
+static FramePace GetFramePace(void);
+static bool IsScreenStatic(void);
+static bool IsFrameDue(void);
+static void WaitIdle(void);
+static void LogFramePacing(void);
+static void LogTelemetry(void);
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    // Initialization (Note windowTitle is unused on Android)
+    //---------------------------------------------------------
+    startTime = GetWallTime();
+
+    // Always run: minimized, the frame scheduler decides what still runs, not raylib
+    SetConfigFlags(FLAG_VSYNC_HINT | FLAG_WINDOW_ALWAYS_RUN);
+    InitWindow(screenWidth, screenHeight, "Mega's Nuclear Waste Dump");
+    InitAudioDevice();
+#if defined(NUKELEER_PROFILE)
+    InitProfiler();
+#endif
+
+    LoadResources();
+    InitAutoplayer(&autoplayer, AUTOPLAY_BUDGET);
+
+    gameRules = GetDefaultRules();
+
+    for (int i = 1; i < argc; i++)
+    {
+        // Bigger boards for the endless dump event: --board <width>x<height>
+        if ((strcmp(argv[i], "--board") == 0) && (i + 1 < argc)) sscanf(argv[++i], "%ix%i", &gameRules.gridWidth, &gameRules.gridHeight);
+
+        // Head-to-head against another player on a NukeleerServer: --connect <host>[:port]
+        else if ((strcmp(argv[i], "--connect") == 0) && (i + 1 < argc)) ConnectOnline(argv[++i]);
+
+        // Mirror every game to spectator windows: --broadcast
+        else if (strcmp(argv[i], "--broadcast") == 0)
+        {
+            broadcastMode = OpenBroadcast(&broadcaster, BROADCAST_NAME);
+            if (!broadcastMode) TraceLog(LOG_WARNING, "BROADCAST: Could not create the snapshot ring");
+        }
+
+        // Draw the broadcast game instead of playing: --spectate
+        else if (strcmp(argv[i], "--spectate") == 0)
+        {
+            spectateMode = true;
+            currentGameState = LOADING;
+        }
+
+        // Watch a recorded game instead of playing: <file.nkr>
+        else if (LoadReplay(&replay, argv[i]))
+        {
+            replayMode = true;
+            currentGameState = LOADING;
+        }
+    }
+
+    InitGame();
+
+#if defined(PLATFORM_WEB)
+    emscripten_set_main_loop(UpdateDrawFrame, 0, 1);
+#else
+    //--------------------------------------------------------------------------------------
+
+    // Main game loop
+    while (!WindowShouldClose() && !exitRequested)    // Detect window close button or ESC key
+    {
+        
+        // Update and Draw, or on a screen where nothing changes, only look for input
+        //----------------------------------------------------------------------------------
+        if (IsFrameDue()) UpdateDrawFrame();
+        else WaitIdle();
+        //----------------------------------------------------------------------------------
+    }
+
+    LogFramePacing();
+#endif
+    // De-Initialization
+    //--------------------------------------------------------------------------------------
+    if ((currentGameState == PLAYING) && !demoMode)
+    {
+        SaveSessionReplay();
+        LogInputLatency();
+    }
+
+    UnloadGame();         // Unload loaded data (textures, sounds, models...)
+
+    CloseAudioDevice();   // Close audio device
+    CloseWindow();        // Close window and OpenGL context
+    //--------------------------------------------------------------------------------------
+
+    return 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Game Module Functions Definition
+//--------------------------------------------------------------------------------------
+
+// Load everything the screens need, once per run; restarting a game only calls InitGame()
+void LoadResources(void)
+{
+    // Assets live next to the executable, whatever directory the game is started from
+    SetAssetDirectory(GetApplicationDirectory());
+
+    // Score log next to the executable too; a torn last record from a crash is cut off here
+    if (OpenLeaderboard(TextFormat("%s%s", GetApplicationDirectory(), LEADERBOARD_FILE_NAME)))
+    {
+        LeaderboardStats stats = GetLeaderboardStats();
+
+        hiscore = GetBestScore();
+        if (stats.droppedBytes > 0) TraceLog(LOG_WARNING, "SCORES: Dropped %i bytes of a torn write", stats.droppedBytes);
+    }
+    else TraceLog(LOG_WARNING, "SCORES: Could not open %s, scores are not kept", LEADERBOARD_FILE_NAME);
+
+    if (OpenTelemetry(TextFormat("%s%s", GetApplicationDirectory(), TELEMETRY_FILE_NAME))) gameTelemetry = AttachTelemetry();
+    else TraceLog(LOG_WARNING, "TELEMETRY: Could not open %s, no events are logged", TELEMETRY_FILE_NAME);
+
+    // Pre-decoded pack if there is one, otherwise decode the gameplay PNGs in the background
+    // while the title screens load and show; UpdateLoading() uploads them later
+    if (!MountAssetPack(TextFormat("%s%s", GetApplicationDirectory(), PACK_FILE_NAME)))
+    {
+        const char *images[] = { "GameScreen.png", "GameOver.png", "RedBarrell.png", "BlueBarrell.png", "YellowBarrell.png" };
+
+        PrefetchImageAssets(images, sizeof(images)/sizeof(images[0]));
+    }
+
+    // Only the first screens are loaded before the first frame
+    TLC = LoadTextureAsset("Tut.png");
+    Titull = LoadTextureAsset("TitleProbably.png");
+
+    LoadScreenLayers();
+}
+
+// Initialize game variables
+void InitGame(void)
+{
+    // Only games played here are logged: a replay or a demo would count twice, a spectator's
+    // board is decoded, not played, and the board set up at startup behind the title is no game
+    bool logged = (currentGameState == PLAYING) && !replayMode && !demoMode && !spectateMode;
+
+    game.telemetry = logged? gameTelemetry : NULL;
+
+    // Initialize the rules (grid, statistics, counters), either fresh and recorded or from a replay
+    bool ready = false;
+
+    if (replayMode)
+    {
+        ready = InitCoreWithRules(&game, replay.seed, GetReplayRules(&replay));
+
+        if (ready) BeginReplayPlayback(&replayPlayer, &replay);
+        else
+        {
+            // No memory for the recorded board: drop the replay and go back to the title
+            TraceLog(LOG_WARNING, "REPLAY: Could not set up a %ix%i board, replay dropped", replay.gridWidth, replay.gridHeight);
+            UnloadReplay(&replay);
+            replayMode = false;
+            currentGameState = TITLE_SCREEN;
+            ready = InitCore(&game, 0);
+        }
+    }
+    else if (demoMode) ready = InitCore(&game, (unsigned int)time(NULL));
+    else if (spectateMode)
+    {
+        // Empty board until the first keyframe arrives
+        ready = InitCore(&game, 0);
+        snapshotDecoder = (SnapshotDecoder){ 0 };
+    }
+    else if (netMode)
+    {
+        // Empty board until the server pairs us up, NET_START then resets it with the match seed.
+        // The placeholder is not a game, so it is not logged. Only a game that is starting asks
+        // for a match: the board set up behind the title would pair an opponent with nobody.
+        game.telemetry = NULL;
+        ready = InitCore(&game, 0);
+        game.telemetry = logged? gameTelemetry : NULL;
+        if (currentGameState == PLAYING) RequestNetMatch(&netClient, 2);
+    }
+    else
+    {
+        unsigned int seed = (unsigned int)time(NULL);
+
+        ready = InitCoreWithRules(&game, seed, gameRules);
+
+        // A --board too big for the memory left falls back to the default board
+        if (!ready && ((gameRules.gridWidth != GRID_HORIZONTAL_SIZE) || (gameRules.gridHeight != GRID_VERTICAL_SIZE)))
+        {
+            TraceLog(LOG_WARNING, "GAME: Could not allocate a %ix%i board, playing %ix%i", gameRules.gridWidth, gameRules.gridHeight, GRID_HORIZONTAL_SIZE, GRID_VERTICAL_SIZE);
+            gameRules = GetDefaultRules();
+            ready = InitCoreWithRules(&game, seed, gameRules);
+        }
+
+        BeginReplayRecording(&replay, seed);
+    }
+
+    // Nothing can be played without a board: stay off the playfield and leave
+    if (!ready)
+    {
+        TraceLog(LOG_ERROR, "GAME: Out of memory for the board");
+        currentGameState = TITLE_SCREEN;
+        exitRequested = true;
+        return;
+    }
+
+    boardScroll = (Vector2){ 0, 0 };
+
+    if (broadcastMode) RequestKeyframe(&snapshotEncoder);
+
+    pause = false;
+    tickAccumulator = 0.0;
+    tickPieceMoved = false;
+
+    ResetInputQueue();
+}
+
+// Update game (one frame)
+void UpdateGame(void)
+{
+    UpdateLoading();
+
+    if (IsKeyPressed(KEY_F3)) showDebugOverlay = !showDebugOverlay;
+
+    if (currentGameState == TITLE_SCREEN)
+    {
+        titleIdleTime += frameDelta;
+
+        if (IsKeyPressed(KEY_ENTER)) 
+        {
+            currentGameState = TUTORIAL;
+            titleIdleTime = 0.0;
+        }
+        else if ((titleIdleTime >= ATTRACT_DELAY) && (loadStep == LOAD_DONE) && (autoplayer.table != NULL))
+        {
+            demoMode = true;
+            currentGameState = PLAYING;
+            InitGame();
+        }
+    }
+    
+    else if (currentGameState == TUTORIAL)
+    {
+        if (IsKeyPressed(KEY_ENTER)) 
+        {
+            // Normally everything is in by now; otherwise wait on the loading screen
+            currentGameState = (loadStep == LOAD_DONE)? PLAYING : LOADING;
+            if (currentGameState == PLAYING) InitGame();
+        }
+    }
+
+    else if (currentGameState == LOADING)
+    {
+        if (loadStep == LOAD_DONE)
+        {
+            currentGameState = PLAYING;
+            InitGame();
+        }
+    }
+    
+
+    else if (currentGameState == PLAYING)
+    {
+
+        if (!IsMusicTrackPlaying()) PlayMusicTrack();
+
+            // Any key ends the demo
+            if (demoMode)
+            {
+                if (GetKeyPressed() != 0) EndDemo();
+            }
+
+            else if (replayMode)
+            {
+                if (IsKeyPressed(KEY_ONE)) replaySpeed = 1;
+                if (IsKeyPressed(KEY_TWO)) replaySpeed = 4;
+                if (IsKeyPressed(KEY_THREE)) replaySpeed = MAX_REPLAY_SPEED;
+            }
+
+            else CaptureInput();
+
+            // The attract demo stays local, even when connected
+            if (netMode && !demoMode)
+            {
+                PollNetClient(&netClient, &game);
+
+                // The match can end before this game does: the opponent topped out or left
+                if (netClient.ended || netClient.connection.closed)
+                {
+                    if (netClient.connection.closed) TraceLog(LOG_WARNING, "NET: Connection to the server lost");
+                    currentGameState = GAME_OVER;
+                }
+            }
+
+            // Run as many fixed ticks as the elapsed time covers, the remainder carries over.
+            // An online game only starts with the match.
+            if (netMode && !demoMode && !netClient.started) tickAccumulator = 0.0;
+            else if (!pause) tickAccumulator += frameDelta;
+
+            int ticks = 0;
+
+            while ((tickAccumulator >= SIM_TICK_TIME) && (currentGameState == PLAYING))
+            {
+                if (ticks++ == MAX_TICKS_PER_FRAME)
+                {
+                    tickAccumulator = 0.0;
+                    break;
+                }
+
+                UpdateGameTick();
+                tickAccumulator -= SIM_TICK_TIME;
+            }
+        }
+        
+    else if (currentGameState == GAME_OVER)
+    {
+        // The server decides the winner, a few ticks behind the local top-out
+        if (netMode && !netClient.connection.closed) PollNetClient(&netClient, &game);
+
+        if (IsKeyPressed(KEY_ENTER) && (!netMode || netClient.ended || netClient.connection.closed))
+        {
+            if (!replayMode && !netMode && (game.score > hiscore)){hiscore = game.score;}
+            currentGameState = TITLE_SCREEN;
+            replayMode = false;
+            
+            StopMusicTrack();
+           
+        }
+    }
+}
+
+// Draw game (one frame)
+void DrawGame(void)
+{
+    PROFILE_BEGIN("DrawGame");
+
+    UpdateRenderLayers();
+
+    BeginDrawing();
+    ClearBackground(RAYWHITE);
+
+    if (currentGameState == TITLE_SCREEN)
+    {
+        DrawRenderLayer(titleLayer, 0, 0);
+    }
+    
+    else if (currentGameState == TUTORIAL)
+    {
+        DrawRenderLayer(tutorialLayer, 0, 0);
+    }
+
+    else if (currentGameState == LOADING)
+    {
+        DrawText("LOADING...", screenWidth/2 - MeasureText("LOADING...", 40)/2, screenHeight/2 - 40, 40, GRAY);
+    }
+    
+    else if (currentGameState == PLAYING)
+    {
+        // Background and labels come from one cached layer
+        DrawRenderLayer(backgroundLayer, 0, 0);
+
+            // Draw gameplay area
+            Vector2 offset = GetBoardOrigin();
+            Rectangle view = GetBoardView();
+            bool scrolling = (game.width > GRID_HORIZONTAL_SIZE) || (game.height > GRID_VERTICAL_SIZE);
+
+            // Fading lines blink while they wait to be deleted
+            Color fadingColor = ((game.fadeLineCounter%8) < 4)? WHITE : GRAY;
+
+            PROFILE_BEGIN("DrawBoard");
+            if (scrolling) BeginScissorMode((int)offset.x, (int)offset.y, (int)view.width, (int)view.height);
+            DrawBoardOutline(&game, offset.x, offset.y, view);
+            DrawBoard(&game, offset.x, offset.y, view, GetPieceOffset(), fadingColor);
+            if (scrolling) EndScissorMode();
+            PROFILE_END();
+
+            // Draw incoming piece (hardcoded)
+            offset.x = 600;
+            offset.y = 45;
+
+            Piece incoming = PeekPiece(&game.pieces, 0);
+            DrawAtlasTile(GetBarrelTile(incoming.color), offset.x + incoming.x*SQUARE_SIZE, offset.y + incoming.y*SQUARE_SIZE, WHITE);
+
+            DrawRenderLayer(hudLayer, HUD_X, HUD_Y);
+
+            if (replayMode) DrawText(TextFormat("REPLAY %ix  [1] [2] [3]", replaySpeed), 10, 10, 20, WHITE);
+            if (demoMode) DrawText("DEMO  press any key", 10, 10, 20, WHITE);
+            if (netMode && !demoMode) DrawOnlineStatus();
+            if (spectateMode) DrawText(!snapshotDecoder.synced? "WAITING FOR BROADCAST" : game.gameOver? "SPECTATING  game over" : "SPECTATING", 10, 10, 20, WHITE);
+            if (pause) DrawText("GAME PAUSED", screenWidth/2 - MeasureText("GAME PAUSED", 40)/2, screenHeight/2 - 40, 40, WHITE);
+        }
+        else if (currentGameState == GAME_OVER) {         DrawTexture(GetTextureAsset(GameOvers), 0, 0, WHITE);
+        DrawText("Good help is so hard to find...", GetScreenWidth()/2 - MeasureText("Good help is so hard to find...", 50)/2, GetScreenHeight()/2 - 130, 50, RED);
+             DrawText(TextFormat("Final Score:   %05i", game.score), GetScreenWidth()/2 - MeasureText("Final Score:   00000", 30)/2, GetScreenHeight()/2 - 70, 30, WHITE);
+        if (netMode)
+        {
+            const char *result = netClient.connection.closed? "Connection lost" :
+                                 !netClient.ended? "Waiting for the result..." :
+                                 (netClient.winner == (uint32_t)netClient.player)? "You win!" :
+                                 (netClient.winner == NET_NO_WINNER)? "Draw" : "You lose";
+
+            DrawText(result, GetScreenWidth()/2 - MeasureText(result, 30)/2, GetScreenHeight()/2 - 30, 30, WHITE);
+        }
+        else DrawText(TextFormat("Previous High Score:   %05i", hiscore), GetScreenWidth()/2 - MeasureText("Previous High Score:   00000", 30)/2, GetScreenHeight()/2 - 30, 30, WHITE);
+
+        if (!netMode || netClient.ended || netClient.connection.closed) DrawText("Press [Enter] to Play Again", GetScreenWidth()/2 - MeasureText("Press [Enter] to Play Again", 30)/2, GetScreenHeight()/2 + 10, 30, WHITE);
+
+        if (!replayMode && !netMode && (todayScoreCount > 0))
+        {
+            DrawText("Today's Best", GetScreenWidth()/2 - MeasureText("Today's Best", 20)/2, GetScreenHeight()/2 + 60, 20, GRAY);
+
+            for (int i = 0; i < todayScoreCount; i++)
+            {
+                bool isLast = (todayScores[i].seed == lastScore.seed) && (todayScores[i].time == lastScore.time);
+                const char *text = TextFormat("%i.   %05i   %3i lines", i + 1, todayScores[i].score, todayScores[i].lines);
+
+                DrawText(text, GetScreenWidth()/2 - MeasureText(text, 20)/2, GetScreenHeight()/2 + 85 + i*22, 20, isLast? YELLOW : WHITE);
+            }
+        } }
+
+    
+    if (showDebugOverlay)
+    {
+        LatencyStats latency = GetInputLatency();
+
+        DrawRectangle(0, screenHeight - 24, 420, 24, Fade(BLACK, 0.6f));
+        DrawText(TextFormat("%i FPS  input p50 %.1f ms  p99 %.1f ms  (%i)", GetFPS(), latency.p50*1000.0, latency.p99*1000.0, latency.count),
+                 6, screenHeight - 20, 16, GREEN);
+    }
+
+#if defined(NUKELEER_PROFILE)
+    if (showProfiler) DrawProfiler();
+#endif
+
+    PROFILE_END();
+
+    // Flushes the batch and waits for the swap, so it is the GPU and present time
+    PROFILE_BEGIN("EndDrawing");
+    EndDrawing();
+    PROFILE_END();
+
+    // Everything the last ticks applied is now on screen
+    MarkInputPresented();
+
+    if (!firstFrameShown)
+    {
+        TraceLog(LOG_INFO, "STARTUP: First frame after %.1f ms (%s)", (GetWallTime() - startTime)*1000.0,
+                 IsAssetPackMounted()? "asset pack" : "decoded from PNG");
+        firstFrameShown = true;
+    }
+}
+
+// Unload game variables
+void UnloadGame(void)
+{
+    UnloadRenderLayers();
+    UnloadBoardAtlas();
+    UnloadReplay(&replay);
+    UnloadCore(&game);
+    CloseAutoplayer(&autoplayer);
+
+    if (netMode)
+    {
+        CloseNetClient(&netClient);
+        CloseNet();
+    }
+
+    CloseBroadcast(&broadcaster);
+    UnloadSnapshotEncoder(&snapshotEncoder);
+    CloseSpectator(&spectator);
+
+    CloseLeaderboard();     // Waits for the last score to be synced
+
+    CloseTelemetry();       // Drains the game's ring one last time
+    LogTelemetry();
+    UnloadMusicTrack();     // Before the file it streams from
+
+    // Whatever is still registered (textures, music), then the pack their data may point into
+    UnloadAllAssets();
+    UnmountAssetPack();
+}
+
+// Update and Draw (one frame)
+void UpdateDrawFrame(void)
+{
+#if defined(NUKELEER_PROFILE)
+    UpdateProfiler();
+#endif
+
+    double now = GetTime();
+
+    frameDelta = (frameStart > 0.0)? now - frameStart : 0.0;
+    frameStart = now;
+    paceFrames[framePace]++;
+
+    PROFILE_BEGIN("UpdateGame");
+    UpdateGame();
+    PROFILE_END();
+
+    // Nobody sees a minimized window; EndDrawing() would have polled the input
+    if (framePace == PACE_HIDDEN) PollInputEvents();
+    else DrawGame();
+
+    PROFILE_FRAME();
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+
+// One simulation tick: the input held right now goes to the rules, or the replay is advanced
+static void UpdateGameTick(void)
+{
+    int pieceX = game.piecePositionX;
+    int pieceY = game.piecePositionY;
+    bool pieceActive = game.pieceActive;
+
+    if (replayMode) UpdateReplayPlayback();
+    else if (spectateMode) UpdateSpectator();
+    else if (demoMode)
+    {
+        UpdateCore(&game, GetAutoplayInput(&autoplayer, &game));
+
+        if (game.gameOver) EndDemo();
+    }
+    else if (netMode)
+    {
+        // Not recorded: a replay has no way to hold the garbage, and scores stay offline
+        StepNetClient(&netClient, &game, GetTickInput());
+
+        if (game.gameOver)
+        {
+            LogInputLatency();
+            currentGameState = GAME_OVER;
+        }
+    }
+    else
+    {
+        unsigned int input = GetTickInput();
+
+        RecordReplayTick(&replay, input);
+
+        PROFILE_BEGIN("UpdateCore");
+        UpdateCore(&game, input);
+        PROFILE_END();
+
+        if (game.gameOver)
+        {
+            SaveSessionReplay();
+            SaveSessionScore();
+            LogInputLatency();
+            currentGameState = GAME_OVER;
+        }
+    }
+
+    if (broadcastMode) BroadcastGame();
+
+    // Only a single-cell step of the same piece is smoothed; spawns, slides and locks snap
+    int dx = game.piecePositionX - pieceX;
+    int dy = game.piecePositionY - pieceY;
+
+    tickPieceMoved = pieceActive && game.pieceActive && (dx >= -1) && (dx <= 1) && (dy >= 0) && (dy <= 1) && ((dx != 0) || (dy != 0));
+    tickPieceX = pieceX;
+    tickPieceY = pieceY;
+}
+
+// Run the replayed game at the chosen speed, ticks are never skipped so the result is exact
+static void UpdateReplayPlayback(void)
+{
+    unsigned int input = 0;
+
+    for (int i = 0; i < replaySpeed; i++)
+    {
+        if (game.gameOver || !GetReplayInput(&replayPlayer, &input))
+        {
+            currentGameState = GAME_OVER;
+            break;
+        }
+
+        UpdateCore(&game, input);
+    }
+}
+
+// Back to the title screen, the idle timer starts over
+static void EndDemo(void)
+{
+    demoMode = false;
+    titleIdleTime = 0.0;
+    currentGameState = TITLE_SCREEN;
+
+    StopMusicTrack();
+}
+
+// Connect to a match server given as host or host:port; without one the game stays offline
+static void ConnectOnline(const char *address)
+{
+    char host[256] = { 0 };
+    int port = NET_DEFAULT_PORT;
+
+    strncpy(host, address, sizeof(host) - 1);
+
+    char *colon = strrchr(host, ':');
+    if (colon != NULL)
+    {
+        *colon = '\0';
+        port = atoi(colon + 1);
+    }
+
+    if (!InitNet()) return;
+
+    netMode = ConnectNetClient(&netClient, host, port);
+
+    if (netMode) TraceLog(LOG_INFO, "NET: Connected to %s:%i", host, port);
+    else
+    {
+        TraceLog(LOG_WARNING, "NET: Could not connect to %s:%i, playing offline", host, port);
+        CloseNet();
+    }
+}
+
+// Waiting message before the match, the opponent's progress during it
+static void DrawOnlineStatus(void)
+{
+    if (!netClient.started)
+    {
+        DrawText("WAITING FOR OPPONENT", screenWidth/2 - MeasureText("WAITING FOR OPPONENT", 40)/2, screenHeight/2 - 40, 40, WHITE);
+        return;
+    }
+
+    DrawText(TextFormat("Opponent:   %05i", netClient.opponentScore), 575, HUD_Y + HUD_HEIGHT + 10, 20, WHITE);
+    DrawText(TextFormat("     Lines:   %04i", netClient.opponentLines), 575, HUD_Y + HUD_HEIGHT + 35, 20, WHITE);
+}
+
+// One snapshot per tick, whatever is being played: a game, the demo or a replay
+static void BroadcastGame(void)
+{
+    int size = EncodeSnapshot(&snapshotEncoder, &game);
+
+    if (size > 0) PublishBroadcast(&broadcaster, snapshotEncoder.data, size, IsSnapshotKeyframe(snapshotEncoder.data, size));
+}
+
+// Apply every snapshot published since the last tick. A broadcaster that quits unlinks its
+// ring, so after a quiet spell the spectator reopens by name to find the next one.
+static void UpdateSpectator(void)
+{
+    const unsigned char *data = NULL;
+    int size = 0;
+    bool received = false;
+
+    while ((size = ReadSpectator(&spectator, &data)) > 0)
+    {
+        DecodeSnapshot(&snapshotDecoder, &game, data, size);
+        received = true;
+    }
+
+    spectatorIdleTime = received? 0.0 : spectatorIdleTime + SIM_TICK_TIME;
+
+    if ((spectator.ring == NULL) || (spectatorIdleTime >= SPECTATOR_RECONNECT))
+    {
+        CloseSpectator(&spectator);
+        OpenSpectator(&spectator, BROADCAST_NAME);
+        spectatorIdleTime = 0.0;
+    }
+}
+
+// Event screens keep full rate unfocused: a spectator window is rarely the focused one,
+// and a throttled broadcaster would publish its ticks in bursts
+static FramePace GetFramePace(void)
+{
+    if (IsWindowMinimized()) return PACE_HIDDEN;
+    if (IsScreenStatic()) return PACE_IDLE;
+    if (!IsWindowFocused() && !broadcastMode && !spectateMode) return PACE_THROTTLED;
+
+    return PACE_ACTIVE;
+}
+
+// Nothing on screen changes until a key is pressed: no ticks, no loading steps, no result
+// awaited from the server, no profiler graphs
+static bool IsScreenStatic(void)
+{
+    if ((currentGameState == PLAYING) && !pause) return false;
+    if ((currentGameState == LOADING) || (loadStep != LOAD_DONE)) return false;
+    if (netMode && (currentGameState == GAME_OVER) && !netClient.ended && !netClient.connection.closed) return false;
+#if defined(NUKELEER_PROFILE)
+    if (showProfiler) return false;
+#endif
+
+    return true;
+}
+
+static bool IsFrameDue(void)
+{
+    FramePace pace = GetFramePace();
+    double now = GetTime();
+
+    paceTime[pace] += (paceClock > 0.0)? now - paceClock : 0.0;
+    paceClock = now;
+
+    // Entering a pace, e.g. a game starting or the window restored, always gets a frame
+    if (pace != framePace)
+    {
+        framePace = pace;
+        return true;
+    }
+
+    if (pace == PACE_ACTIVE) return true;
+    if (!IsScreenStatic()) return (now - frameStart >= THROTTLED_FRAME_TIME);
+
+    // Any key wakes a static screen; the title screen also when the attract demo is due
+    if (GetKeyPressed() != 0) return true;
+    if ((currentGameState == TITLE_SCREEN) && (autoplayer.table != NULL) && (now - frameStart >= ATTRACT_DELAY - titleIdleTime)) return true;
+
+    return false;
+}
+
+// Sleep instead of presenting frames, polling the input at a low rate
+static void WaitIdle(void)
+{
+    double wait = IDLE_POLL_TIME;
+
+    if (!IsScreenStatic()) wait = fmin(wait, frameStart + THROTTLED_FRAME_TIME - GetTime());
+    if (wait > 0.0) WaitTime(wait);
+
+    PollInputEvents();
+}
+
+static void LogFramePacing(void)
+{
+    static const char *paceNames[PACE_COUNT] = { "active", "throttled", "idle", "hidden" };
+
+    for (int i = 0; i < PACE_COUNT; i++)
+    {
+        if ((paceTime[i] > 0.0) || (paceFrames[i] > 0)) TraceLog(LOG_INFO, "FRAMES: %-9s %9.1f s  %8i frames  %6.1f FPS", paceNames[i],
+                                                                 paceTime[i], paceFrames[i], (paceTime[i] > 0.0)? paceFrames[i]/paceTime[i] : 0.0);
+    }
+}
+
+static void LogTelemetry(void)
+{
+    TelemetryStats stats = GetTelemetryStats();
+
+    if (stats.events > 0) TraceLog(LOG_INFO, "TELEMETRY: %lld events (%lld dropped), %.1f KB logged, %.1fx smaller than raw",
+                                   stats.events, stats.dropped, stats.bytes/1024.0, (stats.bytes > 0)? (double)stats.rawBytes/stats.bytes : 0.0);
+}
+
+// Where the falling piece is drawn between two ticks: it starts at its previous cell
+// and reaches the current one as the accumulator fills up to the next tick
+static Vector2 GetPieceOffset(void)
+{
+    if (!tickPieceMoved || pause) return (Vector2){ 0, 0 };
+
+    float remaining = 1.0f - (float)(tickAccumulator/SIM_TICK_TIME);
+
+    return (Vector2){ (tickPieceX - game.piecePositionX)*SQUARE_SIZE*remaining, (tickPieceY - game.piecePositionY)*SQUARE_SIZE*remaining };
+}
+
+static void LogInputLatency(void)
+{
+    LatencyStats latency = GetInputLatency();
+
+    if (latency.count > 0) TraceLog(LOG_INFO, "INPUT: Press to present p50 %.1f ms, p99 %.1f ms, max %.1f ms (%i presses)",
+                                    latency.p50*1000.0, latency.p99*1000.0, latency.max*1000.0, latency.count);
+}
+
+#if defined(NUKELEER_PROFILE)
+static void UpdateProfiler(void)
+{
+    if (IsKeyPressed(KEY_F2)) showProfiler = !showProfiler;
+
+    if (IsKeyPressed(KEY_F4))
+    {
+        const char *fileName = TextFormat("trace_%u.json", (unsigned int)time(NULL));
+
+        if (SaveProfileTrace(fileName)) TraceLog(LOG_INFO, "PROFILE: Trace saved to %s", fileName);
+        else TraceLog(LOG_WARNING, "PROFILE: Could not save %s", fileName);
+    }
+}
+
+// Frame time history (one bar per frame, the line is 60 Hz) and the last/average/peak of every zone
+static void DrawProfiler(void)
+{
+    const int graphX = 10, graphY = 40, graphHeight = 100;
+    const float msToPixels = graphHeight/33.3f;
+    float frames[PROFILE_HISTORY];
+    ProfileZoneStats zoneStats[MAX_PROFILE_ZONES];
+    int zoneCount = GetProfileZoneStats(zoneStats, MAX_PROFILE_ZONES);
+
+    GetProfileFrameTimes(frames);
+
+    DrawRectangle(graphX - 5, graphY - 5, PROFILE_HISTORY*2 + 10, graphHeight + 20 + zoneCount*14, Fade(BLACK, 0.75f));
+
+    for (int i = 0; i < PROFILE_HISTORY; i++)
+    {
+        int height = (int)(frames[i]*msToPixels);
+        if (height > graphHeight) height = graphHeight;
+
+        DrawRectangle(graphX + i*2, graphY + graphHeight - height, 2, height, (frames[i] > 17.5f)? RED : GREEN);
+    }
+
+    DrawLine(graphX, graphY + graphHeight - (int)(16.7f*msToPixels), graphX + PROFILE_HISTORY*2, graphY + graphHeight - (int)(16.7f*msToPixels), YELLOW);
+
+    for (int i = 0; i < zoneCount; i++)
+    {
+        DrawText(TextFormat("%*s%-16s %6.2f %6.2f %6.2f ms", zoneStats[i].depth*2, "", zoneStats[i].name, zoneStats[i].lastMs,
+                            zoneStats[i].averageMs, zoneStats[i].peakMs), graphX, graphY + graphHeight + 8 + i*14, 10, WHITE);
+    }
+}
+#endif
+
+// Keep the session so it can be reproduced later, named after its seed
+static void SaveSessionReplay(void)
+{
+    if (replayMode || netMode || spectateMode) return;
+
+    const char *fileName = TextFormat("replay_%u.nkr", replay.seed);
+
+    EndReplayRecording(&replay, &game);
+
+    if (replay.failed) TraceLog(LOG_WARNING, "REPLAY: Out of memory while recording, %s not saved", fileName);
+    else if (!SaveReplay(&replay, fileName)) TraceLog(LOG_WARNING, "REPLAY: Could not write %s", fileName);
+}
+
+// Add the finished game to the leaderboard; the index updates now, the disk write happens in the background
+static void SaveSessionScore(void)
+{
+    if (replayMode) return;
+
+    time_t now = time(NULL);
+    struct tm day = *localtime(&now);
+
+    day.tm_hour = 0;
+    day.tm_min = 0;
+    day.tm_sec = 0;
+    day.tm_isdst = -1;
+
+    int64_t dayStart = (int64_t)mktime(&day);
+
+    lastScore = (ScoreEntry){ game.score, game.lines, replay.seed, (int64_t)now };
+    SubmitScore(lastScore);
+
+    todayScoreCount = GetTopScoresBetween(dayStart, dayStart + SECONDS_PER_DAY, todayScores, sizeof(todayScores)/sizeof(todayScores[0]));
+}
+
+// At least one step per frame, then as many as fit in LOAD_BUDGET. A step whose images are
+// still being decoded is retried next frame instead of blocking the screen.
+static void UpdateLoading(void)
+{
+    if ((loadStep == LOAD_DONE) || !firstFrameShown) return;
+
+    double start = GetWallTime();
+
+    do
+    {
+        if (!RunLoadStep(loadStep)) return;
+
+        loadStep++;
+    } while ((loadStep < LOAD_DONE) && ((GetWallTime() - start) < LOAD_BUDGET));
+
+    if (loadStep == LOAD_DONE)
+    {
+        TraceLog(LOG_INFO, "STARTUP: Gameplay assets ready after %.1f ms", (GetWallTime() - startTime)*1000.0);
+        LogAssetUsage();
+    }
+}
+
+static bool RunLoadStep(LoadStep step)
+{
+    switch (step)
+    {
+        case LOAD_MUSIC:
+        {
+            // Decoded on the music thread from here on, nothing per frame
+            int size = 0;
+
+            music = LoadFileAsset("theme.mp3");
+            LoadMusicTrack(GetFileExtension("theme.mp3"), GetFileAsset(music, &size), size, false);
+        } break;
+        case LOAD_ATLAS:
+        {
+            if (IsImageDecoding("RedBarrell.png") || IsImageDecoding("BlueBarrell.png") || IsImageDecoding("YellowBarrell.png")) return false;
+
+            // Block sprites, packed with the grid tiles into one atlas
+            LoadBoardAtlas();
+        } break;
+        case LOAD_GAME_SCREEN:
+        {
+            if (IsImageDecoding("GameScreen.png")) return false;
+
+            GameScreen = LoadTextureAsset("GameScreen.png");
+        } break;
+        case LOAD_GAME_OVER:
+        {
+            if (IsImageDecoding("GameOver.png")) return false;
+
+            GameOvers = LoadTextureAsset("GameOver.png");
+        } break;
+        case LOAD_PLAYFIELD_LAYERS: LoadPlayfieldLayers(); break;
+        default: break;
+    }
+
+    return true;
+}
+
+// Top-left corner of the grid on screen
+static Vector2 GetBoardOrigin(void)
+{
+    Vector2 offset;
+    offset.x = screenWidth/2 - (GRID_HORIZONTAL_SIZE*SQUARE_SIZE/2) - 50;
+    offset.y = screenHeight/2 - ((GRID_VERTICAL_SIZE - 1)*SQUARE_SIZE/2) + SQUARE_SIZE*2;
+
+    offset.y -= 50;
+
+    return offset;
+}
+
+// Part of the board shown in the playfield, in board pixels. A board that fits is shown whole;
+// a bigger one pans after the falling piece, easing so a new piece at the top is not a jump cut.
+static Rectangle GetBoardView(void)
+{
+    float viewWidth = fminf(GRID_HORIZONTAL_SIZE*SQUARE_SIZE, game.width*SQUARE_SIZE);
+    float viewHeight = fminf(GRID_VERTICAL_SIZE*SQUARE_SIZE, game.height*SQUARE_SIZE);
+
+    if (game.pieceCellCount > 0)
+    {
+        Vector2 pieceOffset = GetPieceOffset();
+        float targetX = (game.piecePositionX + game.pieceCells[0].x + 0.5f)*SQUARE_SIZE + pieceOffset.x - viewWidth/2;
+        float targetY = (game.piecePositionY + game.pieceCells[0].y + 0.5f)*SQUARE_SIZE + pieceOffset.y - viewHeight/2;
+        float follow = fminf(1.0f, (float)frameDelta*BOARD_SCROLL_SPEED);
+
+        boardScroll.x += (targetX - boardScroll.x)*follow;
+        boardScroll.y += (targetY - boardScroll.y)*follow;
+    }
+
+    boardScroll.x = fmaxf(0.0f, fminf(boardScroll.x, game.width*SQUARE_SIZE - viewWidth));
+    boardScroll.y = fmaxf(0.0f, fminf(boardScroll.y, game.height*SQUARE_SIZE - viewHeight));
+
+    return (Rectangle){ roundf(boardScroll.x), roundf(boardScroll.y), viewWidth, viewHeight };
+}
+
+// Wall clock, valid before the window exists (GetTime() starts at InitWindow())
+static double GetWallTime(void)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+
+    return (double)now.tv_sec + now.tv_nsec*1e-9;
+}
+
+static void LoadScreenLayers(void)
+{
+    titleLayer = LoadRenderTexture(screenWidth, screenHeight);
+    tutorialLayer = LoadRenderTexture(screenWidth, screenHeight);
+
+    // The tutorial never changes, render it once
+    BeginTextureMode(tutorialLayer);
+        DrawTexture(GetTextureAsset(TLC), 0, 0, WHITE);
+        DrawText("After 39 long years, Uncle Henry has retired from his job at the", 35, 30, 20, WHITE);
+        DrawText("nuclear waste dump and has sold the land to me!", 35, 50, 20, WHITE);
+        DrawText("As my newest employee, you are now tasked with taking up the duties", 35, 70, 20, WHITE);
+        DrawText("of handling the toxic waste.", 35, 90, 20, WHITE);
+        DrawText("Basically, you must dispose of the waste by making rows, but avoid", 35, 110, 20, WHITE);
+        DrawText("matching the same colors. If you try to stack a container of waste on", 35, 130, 20, WHITE);
+        DrawText("top of another, it will fall to the side (it prioritizes the left, then,", 35, 150, 20, WHITE);
+        DrawText("the right) so be mindful of that! Clearing a row drops the containers", 35, 170, 20, WHITE);
+        DrawText("above it straight down, and each one keeps its color as it falls.", 35, 190, 20, WHITE);
+        DrawText("I hope you've got insurance!", 35, 210, 20, WHITE);
+    EndTextureMode();
+
+    // Force the title to render on the next frame
+    titleHiscore = -1;
+}
+
+// Needs GameScreen.png and the board atlas
+static void LoadPlayfieldLayers(void)
+{
+    backgroundLayer = LoadRenderTexture(screenWidth, screenHeight);
+    hudLayer = LoadRenderTexture(HUD_WIDTH, HUD_HEIGHT);
+
+    // The playfield background never changes, render it once; the cell outline scrolls with
+    // the board and is drawn with it
+    BeginTextureMode(backgroundLayer);
+        DrawTexture(GetTextureAsset(GameScreen), 0, 0, WHITE);
+        DrawText("!!!  DANGER  !!!", 580, 65, 30, BLACK);
+    EndTextureMode();
+
+    // Force the HUD to render on the next frame
+    hudLines = -1;
+}
+
+static void UnloadRenderLayers(void)
+{
+    if (titleLayer.id > 0) UnloadRenderTexture(titleLayer);
+    if (tutorialLayer.id > 0) UnloadRenderTexture(tutorialLayer);
+    if (backgroundLayer.id > 0) UnloadRenderTexture(backgroundLayer);
+    if (hudLayer.id > 0) UnloadRenderTexture(hudLayer);
+
+    titleLayer = tutorialLayer = backgroundLayer = hudLayer = (RenderTexture2D){ 0 };
+}
+
+// Re-render the title and HUD layers only when the numbers they show have changed
+static void UpdateRenderLayers(void)
+{
+    if ((currentGameState == TITLE_SCREEN) && (titleHiscore != hiscore))
+    {
+        titleHiscore = hiscore;
+
+        BeginTextureMode(titleLayer);
+            DrawTexture(GetTextureAsset(Titull), 0, 0, WHITE);
+            DrawText("High Score", screenWidth/2 - MeasureText("High Score", 20)/2, 5, 20, RED);
+            DrawText(TextFormat("%05i", hiscore), screenWidth/2 - MeasureText("00000", 20)/2, 25, 20, WHITE);
+            DrawText("Press [Enter] to Start", screenWidth/2 - MeasureText("Press [Enter] to Start", 30)/2, screenHeight/2 + 62, 30, WHITE);
+            DrawText("© 2025 MegaKoopa255", screenWidth/2 - MeasureText("© 2025 MegaKoopa255", 20)/2, screenHeight-20, 20, WHITE);
+        EndTextureMode();
+    }
+
+    if ((currentGameState == PLAYING) && ((hudLines != game.lines) || (hudScore != game.score) || (hudHiscore != hiscore)))
+    {
+        hudLines = game.lines;
+        hudScore = game.score;
+        hudHiscore = hiscore;
+
+        // Opaque: the matching piece of GameScreen.png goes behind the text
+        BeginTextureMode(hudLayer);
+            DrawTextureRec(GetTextureAsset(GameScreen), (Rectangle){ HUD_X, HUD_Y, HUD_WIDTH, HUD_HEIGHT }, (Vector2){ 0, 0 }, WHITE);
+            DrawText(TextFormat("  Lines:   %04i", game.lines), 575 - HUD_X, 165 - HUD_Y, 30, WHITE);
+            DrawText(TextFormat(" Score:   %05i", game.score), 575 - HUD_X, 205 - HUD_Y, 30, WHITE);
+            DrawText(TextFormat("Hi Score: %05i", hiscore), 575 - HUD_X, 245 - HUD_Y, 30, WHITE);
+        EndTextureMode();
+    }
+}
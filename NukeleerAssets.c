@@ -0,0 +1,454 @@
+#include "NukeleerAssets.h"
+#include "NukeleerPack.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct Asset {
+    AssetType type;
+    char name[MAX_ASSET_NAME];
+    int references;
+    bool mapped;                // Pixels live in the mounted pack, nothing to free
+    size_t gpuBytes;
+    size_t ramBytes;
+
+    union {
+        Texture2D texture;
+        Image image;
+        struct { unsigned char *data; int size; } file;
+    };
+} Asset;
+
+typedef struct PrefetchJob {
+    pthread_t thread;
+    bool started;               // Decoding on its own thread, join before reading the image
+    bool pending;               // Not handed to the registry yet
+    atomic_bool done;
+    char fileName[MAX_ASSET_NAME];
+    char path[MAX_ASSET_PATH];
+    Image image;
+} PrefetchJob;
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+static Asset assets[MAX_ASSETS] = { 0 };
+static char assetDirectory[MAX_ASSET_PATH] = "";
+static PrefetchJob prefetchJobs[MAX_PREFETCH_THREADS] = { 0 };
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void GetAssetPath(const char *fileName, char *path);
+static bool GetPackImage(const char *fileName, Image *image);
+static void *DecodeImage(void *arg);
+static void CollectImage(PrefetchJob *job);
+static void WaitForImage(const char *fileName);
+static AssetHandle FindAsset(AssetType type, const char *name);
+static Asset *NewAsset(AssetType type, const char *name, AssetHandle *handle);
+static Asset *GetAsset(AssetHandle handle, AssetType type);
+static void FreeAsset(Asset *asset);
+static const char *GetAssetTypeName(AssetType type);
+
+//--------------------------------------------------------------------------------------
+// Assets Module Functions Definition
+//--------------------------------------------------------------------------------------
+void SetAssetDirectory(const char *directory)
+{
+    snprintf(assetDirectory, MAX_ASSET_PATH, "%s", directory);
+}
+
+void PrefetchImageAssets(const char **fileNames, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        // Files in the pack are already decoded, registered or queued files are taken care of
+        const PackEntry *entry = FindPackEntry(fileNames[i]);
+
+        if ((entry != NULL) && (entry->type == PACK_ENTRY_IMAGE)) continue;
+        if ((FindAsset(ASSET_IMAGE, fileNames[i]) > 0) || (FindAsset(ASSET_TEXTURE, fileNames[i]) > 0)) continue;
+        if (IsImageDecoding(fileNames[i])) continue;
+
+        PrefetchJob *job = NULL;
+
+        for (int j = 0; (j < MAX_PREFETCH_THREADS) && (job == NULL); j++)
+        {
+            if (!prefetchJobs[j].pending) job = &prefetchJobs[j];
+        }
+
+        // No free worker: the file is simply loaded from disk when it is asked for
+        if (job == NULL) break;
+
+        memset(job->fileName, 0, MAX_ASSET_NAME);
+        strncpy(job->fileName, fileNames[i], MAX_ASSET_NAME - 1);
+        GetAssetPath(fileNames[i], job->path);
+        job->image = (Image){ 0 };
+        job->pending = true;
+        atomic_store(&job->done, false);
+
+        job->started = (pthread_create(&job->thread, NULL, DecodeImage, job) == 0);
+        if (!job->started) DecodeImage(job);
+    }
+}
+
+bool IsImageDecoding(const char *fileName)
+{
+    bool decoding = false;
+
+    for (int i = 0; i < MAX_PREFETCH_THREADS; i++)
+    {
+        PrefetchJob *job = &prefetchJobs[i];
+
+        if (!job->pending) continue;
+
+        if (atomic_load_explicit(&job->done, memory_order_acquire)) CollectImage(job);
+        else if ((fileName == NULL) || (strncmp(job->fileName, fileName, MAX_ASSET_NAME) == 0)) decoding = true;
+    }
+
+    return decoding;
+}
+
+AssetHandle LoadTextureAsset(const char *fileName)
+{
+    WaitForImage(fileName);
+
+    AssetHandle handle = FindAsset(ASSET_TEXTURE, fileName);
+
+    if (handle > 0)
+    {
+        assets[handle - 1].references++;
+        return handle;
+    }
+
+    Image image = { 0 };
+    AssetHandle prefetched = FindAsset(ASSET_IMAGE, fileName);
+    Asset *asset = NewAsset(ASSET_TEXTURE, fileName, &handle);
+
+    if (asset == NULL) return 0;
+
+    if (GetPackImage(fileName, &image)) asset->texture = LoadTextureFromImage(image);
+    else if (prefetched > 0)
+    {
+        asset->texture = LoadTextureFromImage(assets[prefetched - 1].image);
+        if (assets[prefetched - 1].references <= 0) FreeAsset(&assets[prefetched - 1]);
+    }
+    else
+    {
+        char path[MAX_ASSET_PATH];
+        GetAssetPath(fileName, path);
+
+        asset->texture = LoadTexture(path);
+    }
+
+    asset->gpuBytes = (size_t)GetPixelDataSize(asset->texture.width, asset->texture.height, asset->texture.format);
+
+    return handle;
+}
+
+AssetHandle LoadImageAsset(const char *fileName)
+{
+    WaitForImage(fileName);
+
+    AssetHandle handle = FindAsset(ASSET_IMAGE, fileName);
+
+    if (handle > 0)
+    {
+        assets[handle - 1].references++;
+        return handle;
+    }
+
+    Asset *asset = NewAsset(ASSET_IMAGE, fileName, &handle);
+    if (asset == NULL) return 0;
+
+    if (GetPackImage(fileName, &asset->image)) asset->mapped = true;
+    else
+    {
+        char path[MAX_ASSET_PATH];
+        GetAssetPath(fileName, path);
+
+        asset->image = LoadImage(path);
+    }
+
+    asset->ramBytes = (size_t)GetPixelDataSize(asset->image.width, asset->image.height, asset->image.format);
+
+    return handle;
+}
+
+AssetHandle LoadFileAsset(const char *fileName)
+{
+    AssetHandle handle = FindAsset(ASSET_FILE, fileName);
+
+    if (handle > 0)
+    {
+        assets[handle - 1].references++;
+        return handle;
+    }
+
+    Asset *asset = NewAsset(ASSET_FILE, fileName, &handle);
+    if (asset == NULL) return 0;
+
+    const PackEntry *entry = FindPackEntry(fileName);
+
+    if ((entry != NULL) && (entry->type == PACK_ENTRY_FILE))
+    {
+        asset->file.data = (unsigned char *)GetPackEntryData(entry);
+        asset->file.size = (int)entry->size;
+        asset->mapped = true;
+    }
+    else
+    {
+        char path[MAX_ASSET_PATH];
+        GetAssetPath(fileName, path);
+
+        asset->file.data = LoadFileData(path, &asset->file.size);
+    }
+
+    asset->ramBytes = (size_t)asset->file.size;
+
+    return handle;
+}
+
+AssetHandle AddTextureAsset(const char *name, Texture2D texture)
+{
+    AssetHandle handle = FindAsset(ASSET_TEXTURE, name);
+
+    if (handle > 0)
+    {
+        // Same name, same asset: keep the registered texture and drop the duplicate
+        UnloadTexture(texture);
+        assets[handle - 1].references++;
+        return handle;
+    }
+
+    Asset *asset = NewAsset(ASSET_TEXTURE, name, &handle);
+
+    if (asset == NULL)
+    {
+        UnloadTexture(texture);
+        return 0;
+    }
+
+    asset->texture = texture;
+    asset->gpuBytes = (size_t)GetPixelDataSize(texture.width, texture.height, texture.format);
+
+    return handle;
+}
+
+Texture2D GetTextureAsset(AssetHandle handle)
+{
+    Asset *asset = GetAsset(handle, ASSET_TEXTURE);
+
+    return (asset != NULL)? asset->texture : (Texture2D){ 0 };
+}
+
+Image GetImageAsset(AssetHandle handle)
+{
+    Asset *asset = GetAsset(handle, ASSET_IMAGE);
+
+    return (asset != NULL)? asset->image : (Image){ 0 };
+}
+
+const unsigned char *GetFileAsset(AssetHandle handle, int *dataSize)
+{
+    Asset *asset = GetAsset(handle, ASSET_FILE);
+
+    *dataSize = (asset != NULL)? asset->file.size : 0;
+
+    return (asset != NULL)? asset->file.data : NULL;
+}
+
+void UnloadAsset(AssetHandle handle)
+{
+    Asset *asset = GetAsset(handle, ASSET_NONE);
+
+    if ((asset != NULL) && (--asset->references <= 0)) FreeAsset(asset);
+}
+
+void UnloadAllAssets(void)
+{
+    // Decodes still in flight land in the registry first, so they are freed with the rest
+    for (int i = 0; i < MAX_PREFETCH_THREADS; i++)
+    {
+        if (prefetchJobs[i].pending) CollectImage(&prefetchJobs[i]);
+    }
+
+    for (int i = 0; i < MAX_ASSETS; i++)
+    {
+        if (assets[i].type != ASSET_NONE) FreeAsset(&assets[i]);
+    }
+}
+
+AssetUsage GetAssetUsage(void)
+{
+    AssetUsage usage = { 0 };
+
+    for (int i = 0; i < MAX_ASSETS; i++)
+    {
+        if (assets[i].type == ASSET_NONE) continue;
+
+        usage.count++;
+        usage.gpuBytes += assets[i].gpuBytes;
+        usage.ramBytes += assets[i].ramBytes;
+    }
+
+    return usage;
+}
+
+void LogAssetUsage(void)
+{
+    for (int i = 0; i < MAX_ASSETS; i++)
+    {
+        if (assets[i].type == ASSET_NONE) continue;
+
+        TraceLog(LOG_INFO, "ASSETS: [%i] %-7s %-20s gpu %8zu B  ram %8zu B  refs %i", i + 1, GetAssetTypeName(assets[i].type),
+                 assets[i].name, assets[i].gpuBytes, assets[i].ramBytes, assets[i].references);
+    }
+
+    AssetUsage usage = GetAssetUsage();
+    TraceLog(LOG_INFO, "ASSETS: %i loaded, gpu %zu B, ram %zu B", usage.count, usage.gpuBytes, usage.ramBytes);
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+// Thread-safe: only touches the caller's buffer
+static void GetAssetPath(const char *fileName, char *path)
+{
+    snprintf(path, MAX_ASSET_PATH, "%s%s", assetDirectory, fileName);
+}
+
+// Decoded pixels straight from the mapped pack, no copy
+static bool GetPackImage(const char *fileName, Image *image)
+{
+    const PackEntry *entry = FindPackEntry(fileName);
+
+    if ((entry == NULL) || (entry->type != PACK_ENTRY_IMAGE)) return false;
+    if (entry->size < (uint64_t)GetPixelDataSize(entry->width, entry->height, entry->format)) return false;
+
+    image->data = (void *)GetPackEntryData(entry);
+    image->width = entry->width;
+    image->height = entry->height;
+    image->mipmaps = 1;
+    image->format = entry->format;
+
+    return true;
+}
+
+static void *DecodeImage(void *arg)
+{
+    PrefetchJob *job = (PrefetchJob *)arg;
+
+    job->image = LoadImage(job->path);
+    atomic_store_explicit(&job->done, true, memory_order_release);
+
+    return NULL;
+}
+
+// Main thread only: joins the worker and registers the image. Nobody holds a reference
+// yet, the first load takes over the decoded pixels.
+static void CollectImage(PrefetchJob *job)
+{
+    if (job->started) pthread_join(job->thread, NULL);
+
+    job->started = false;
+    job->pending = false;
+
+    if (job->image.data == NULL) return;
+
+    AssetHandle handle = 0;
+    Asset *asset = NewAsset(ASSET_IMAGE, job->fileName, &handle);
+
+    if (asset == NULL)
+    {
+        UnloadImage(job->image);
+        return;
+    }
+
+    asset->references = 0;
+    asset->image = job->image;
+    asset->ramBytes = (size_t)GetPixelDataSize(asset->image.width, asset->image.height, asset->image.format);
+}
+
+// A file that is being decoded is not loaded a second time, its decode is waited for
+static void WaitForImage(const char *fileName)
+{
+    for (int i = 0; i < MAX_PREFETCH_THREADS; i++)
+    {
+        PrefetchJob *job = &prefetchJobs[i];
+
+        if (job->pending && (strncmp(job->fileName, fileName, MAX_ASSET_NAME) == 0)) CollectImage(job);
+    }
+}
+
+static AssetHandle FindAsset(AssetType type, const char *name)
+{
+    for (int i = 0; i < MAX_ASSETS; i++)
+    {
+        if ((assets[i].type == type) && (strncmp(assets[i].name, name, MAX_ASSET_NAME) == 0)) return i + 1;
+    }
+
+    return 0;
+}
+
+static Asset *NewAsset(AssetType type, const char *name, AssetHandle *handle)
+{
+    for (int i = 0; i < MAX_ASSETS; i++)
+    {
+        if (assets[i].type != ASSET_NONE) continue;
+
+        memset(&assets[i], 0, sizeof(Asset));
+        assets[i].type = type;
+        assets[i].references = 1;
+        strncpy(assets[i].name, name, MAX_ASSET_NAME - 1);
+
+        *handle = i + 1;
+        return &assets[i];
+    }
+
+    TraceLog(LOG_WARNING, "ASSETS: Registry full, could not load %s", name);
+    *handle = 0;
+
+    return NULL;
+}
+
+// ASSET_NONE accepts any type
+static Asset *GetAsset(AssetHandle handle, AssetType type)
+{
+    if ((handle <= 0) || (handle > MAX_ASSETS)) return NULL;
+
+    Asset *asset = &assets[handle - 1];
+
+    if (asset->type == ASSET_NONE) return NULL;
+    if ((type != ASSET_NONE) && (asset->type != type)) return NULL;
+
+    return asset;
+}
+
+static void FreeAsset(Asset *asset)
+{
+    switch (asset->type)
+    {
+        case ASSET_TEXTURE: UnloadTexture(asset->texture); break;
+        case ASSET_IMAGE: if (!asset->mapped) UnloadImage(asset->image); break;
+        case ASSET_FILE: if (!asset->mapped) UnloadFileData(asset->file.data); break;
+        default: break;
+    }
+
+    memset(asset, 0, sizeof(Asset));
+}
+
+static const char *GetAssetTypeName(AssetType type)
+{
+    switch (type)
+    {
+        case ASSET_TEXTURE: return "texture";
+        case ASSET_IMAGE: return "image";
+        case ASSET_FILE: return "file";
+        default: return "none";
+    }
+}
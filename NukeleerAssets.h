@@ -0,0 +1,60 @@
+#ifndef NUKELEER_ASSETS_H
+#define NUKELEER_ASSETS_H
+
+#include "raylib.h"
+
+#include <stddef.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define MAX_ASSETS              32
+#define MAX_ASSET_NAME          128
+#define MAX_ASSET_PATH          512
+#define MAX_PREFETCH_THREADS    16
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// Index into the registry plus one, so a zeroed handle is never valid
+typedef int AssetHandle;
+
+typedef enum AssetType { ASSET_NONE, ASSET_TEXTURE, ASSET_IMAGE, ASSET_FILE } AssetType;
+
+typedef struct AssetUsage {
+    int count;
+    size_t gpuBytes;            // Texture memory uploaded to the GPU
+    size_t ramBytes;            // CPU-side pixel data and raw files, encoded music among them
+} AssetUsage;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+// Asset files are looked up in the pack mounted with MountAssetPack() first, then on disk
+// relative to the asset directory, so the game does not depend on the working directory
+void SetAssetDirectory(const char *directory);
+
+// Start decoding images on worker threads and return right away, for when there is no pack.
+// Later LoadTextureAsset()/LoadImageAsset() calls for these files take the decoded pixels,
+// waiting for the decode only if it has not finished yet.
+void PrefetchImageAssets(const char **fileNames, int count);
+bool IsImageDecoding(const char *fileName);    // Never blocks, NULL asks about any file
+
+// Loading a file that is already registered returns the same handle and only bumps its
+// reference count, so callers can ask for an asset as often as they like
+AssetHandle LoadTextureAsset(const char *fileName);
+AssetHandle LoadImageAsset(const char *fileName);
+AssetHandle LoadFileAsset(const char *fileName);                    // Raw bytes, mapped straight from the pack when there is one
+AssetHandle AddTextureAsset(const char *name, Texture2D texture);   // Register a texture built at runtime
+
+Texture2D GetTextureAsset(AssetHandle handle);
+Image GetImageAsset(AssetHandle handle);
+const unsigned char *GetFileAsset(AssetHandle handle, int *dataSize);
+
+void UnloadAsset(AssetHandle handle);       // Frees the asset once its last reference is gone
+void UnloadAllAssets(void);
+
+AssetUsage GetAssetUsage(void);
+void LogAssetUsage(void);                   // One line per asset plus totals, through TraceLog()
+
+#endif // NUKELEER_ASSETS_H
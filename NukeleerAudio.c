@@ -0,0 +1,379 @@
+#include "raylib.h"
+#include "NukeleerAudio.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define MAX_MUSIC_CHANNELS          2
+#define PREDECODED_COPY_FRAMES      4096        // Frames copied per step from a predecoded track
+#define DECODER_IDLE_TIME           0.005       // Seconds the decoder sleeps while the ring is full
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+static AudioStream stream = { 0 };
+static bool trackLoaded = false;
+static bool trackPlaying = false;
+static int sampleRate = 0;
+static int channels = 0;
+
+// MP3 source, decoded a chunk at a time (decoder thread only while playing)
+static char trackType[16] = { 0 };
+static const unsigned char *trackData = NULL;
+static uint32_t *frameOffsets = NULL;           // frameCount + 1 entries, the last one is the end of the data
+static int frameCount = 0;
+static int samplesPerFrame = 0;
+static int nextFrame = 0;
+
+// Predecoded source
+static Wave predecoded = { 0 };
+static unsigned int predecodedCursor = 0;
+
+// Ring: the decoder thread only writes writeFrame, the device callback only writes readFrame
+static float ring[MUSIC_RING_FRAMES*MAX_MUSIC_CHANNELS] = { 0 };
+static _Atomic uint64_t writeFrame = 0;
+static _Atomic uint64_t readFrame = 0;
+static _Atomic uint64_t discardUntil = 0;       // Set by PlayMusicTrack(), older frames belong to the last play
+static atomic_bool primed = false;              // Nothing is an underrun until the first chunk is in
+
+static pthread_t decoderThread;
+static atomic_bool stopDecoder = false;
+
+static _Atomic uint64_t framesPlayed = 0;
+static _Atomic uint64_t underrunFrames = 0;
+static _Atomic uint32_t underruns = 0;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static int ParseFrameHeader(const unsigned char *header, int *frameSamples, int *frameRate, int *frameChannels);
+static bool IndexFrames(const unsigned char *data, int dataSize);
+static void *DecodeMusic(void *arg);
+static int DecodeNextChunk(uint64_t write);
+static int CopyPredecoded(uint64_t write, int frames);
+static void WriteRing(uint64_t write, const float *samples, int frames);
+static void ReadRing(void *buffer, unsigned int frames);
+
+//--------------------------------------------------------------------------------------
+// Audio Module Functions Definition
+//--------------------------------------------------------------------------------------
+bool LoadMusicTrack(const char *fileType, const unsigned char *data, int dataSize, bool predecode)
+{
+    UnloadMusicTrack();
+
+    bool isMp3 = (strcmp(fileType, ".mp3") == 0) && IndexFrames(data, dataSize);
+
+    if (isMp3 && ((float)frameCount*samplesPerFrame/sampleRate <= MUSIC_PREDECODE_SECONDS)) predecode = true;
+
+    if (!isMp3 || predecode)
+    {
+        free(frameOffsets);
+        frameOffsets = NULL;
+
+        predecoded = LoadWaveFromMemory(fileType, data, dataSize);
+        if ((predecoded.data == NULL) || (predecoded.frameCount == 0))
+        {
+            UnloadWave(predecoded);
+            predecoded = (Wave){ 0 };
+            return false;
+        }
+
+        WaveFormat(&predecoded, predecoded.sampleRate, 32, (predecoded.channels > MAX_MUSIC_CHANNELS)? MAX_MUSIC_CHANNELS : predecoded.channels);
+
+        sampleRate = predecoded.sampleRate;
+        channels = predecoded.channels;
+    }
+
+    strncpy(trackType, fileType, sizeof(trackType) - 1);
+    trackData = data;
+
+    stream = LoadAudioStream(sampleRate, 32, channels);
+    SetAudioStreamCallback(stream, ReadRing);
+
+    trackLoaded = true;
+
+    TraceLog(LOG_INFO, "MUSIC: %s, %i Hz, %i channels", (predecoded.data != NULL)? "predecoded" : "streaming", sampleRate, channels);
+
+    return true;
+}
+
+void UnloadMusicTrack(void)
+{
+    if (!trackLoaded) return;
+
+    StopMusicTrack();
+    UnloadAudioStream(stream);
+
+    if (predecoded.data != NULL) UnloadWave(predecoded);
+    free(frameOffsets);
+
+    stream = (AudioStream){ 0 };
+    predecoded = (Wave){ 0 };
+    frameOffsets = NULL;
+    frameCount = 0;
+    trackLoaded = false;
+}
+
+void PlayMusicTrack(void)
+{
+    if (!trackLoaded || trackPlaying) return;
+
+    // The decoder is not running, so writeFrame is stable: whatever is still buffered
+    // from the last play gets skipped by the device
+    atomic_store(&discardUntil, atomic_load(&writeFrame));
+    atomic_store(&primed, false);
+    atomic_store(&stopDecoder, false);
+
+    nextFrame = 0;
+    predecodedCursor = 0;
+
+    if (pthread_create(&decoderThread, NULL, DecodeMusic, NULL) != 0)
+    {
+        TraceLog(LOG_WARNING, "MUSIC: Could not start the decoder thread");
+        return;
+    }
+
+    PlayAudioStream(stream);
+    trackPlaying = true;
+}
+
+void StopMusicTrack(void)
+{
+    if (!trackPlaying) return;
+
+    StopAudioStream(stream);
+
+    atomic_store(&stopDecoder, true);
+    pthread_join(decoderThread, NULL);
+
+    trackPlaying = false;
+
+    MusicTrackStats stats = GetMusicTrackStats();
+    TraceLog(LOG_INFO, "MUSIC: %llu frames played, %u underruns (%llu frames of silence)",
+             (unsigned long long)stats.framesPlayed, stats.underruns, (unsigned long long)stats.underrunFrames);
+}
+
+bool IsMusicTrackPlaying(void)
+{
+    return trackPlaying;
+}
+
+MusicTrackStats GetMusicTrackStats(void)
+{
+    MusicTrackStats stats = { 0 };
+    uint64_t write = atomic_load(&writeFrame);
+    uint64_t read = atomic_load(&readFrame);
+    uint64_t discard = atomic_load(&discardUntil);
+
+    if (read < discard) read = discard;
+
+    stats.framesPlayed = atomic_load(&framesPlayed);
+    stats.underrunFrames = atomic_load(&underrunFrames);
+    stats.underruns = atomic_load(&underruns);
+    stats.bufferedFrames = (write > read)? (int)(write - read) : 0;
+
+    return stats;
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+// MPEG audio layer III frame header, returns the frame length in bytes or 0 if this is not one
+static int ParseFrameHeader(const unsigned char *header, int *frameSamples, int *frameRate, int *frameChannels)
+{
+    static const int bitratesMpeg1[16] = { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 };
+    static const int bitratesMpeg2[16] = { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 };
+    static const int rates[3] = { 44100, 48000, 32000 };
+
+    if ((header[0] != 0xFF) || ((header[1] & 0xE0) != 0xE0)) return 0;
+
+    int version = (header[1] >> 3) & 0x03;          // 3: MPEG-1, 2: MPEG-2, 0: MPEG-2.5
+    int layer = (header[1] >> 1) & 0x03;            // 1: layer III
+    int bitrateIndex = header[2] >> 4;
+    int rateIndex = (header[2] >> 2) & 0x03;
+    int padding = (header[2] >> 1) & 0x01;
+
+    if ((version == 1) || (layer != 1) || (rateIndex == 3)) return 0;
+
+    int bitrate = ((version == 3)? bitratesMpeg1 : bitratesMpeg2)[bitrateIndex]*1000;
+    if (bitrate == 0) return 0;
+
+    *frameRate = rates[rateIndex] >> ((version == 3)? 0 : (version == 2)? 1 : 2);
+    *frameSamples = (version == 3)? 1152 : 576;
+    *frameChannels = ((header[3] >> 6) == 3)? 1 : 2;
+
+    return ((version == 3)? 144 : 72)*bitrate/(*frameRate) + padding;
+}
+
+// Find where every frame starts, so chunks can be cut on frame boundaries
+static bool IndexFrames(const unsigned char *data, int dataSize)
+{
+    int position = 0;
+    int capacity = 0;
+
+    // Skip an ID3v2 tag
+    if ((dataSize >= 10) && (memcmp(data, "ID3", 3) == 0))
+    {
+        position = 10 + ((data[6] & 0x7F) << 21 | (data[7] & 0x7F) << 14 | (data[8] & 0x7F) << 7 | (data[9] & 0x7F));
+        if (data[5] & 0x10) position += 10;
+    }
+
+    frameCount = 0;
+
+    while (position + 4 <= dataSize)
+    {
+        int frameSamples = 0, frameRate = 0, frameChannels = 0;
+        int length = ParseFrameHeader(data + position, &frameSamples, &frameRate, &frameChannels);
+
+        // Every frame has to match the first one, anything else is junk between frames
+        if ((length == 0) || (position + length > dataSize) ||
+            ((frameCount > 0) && ((frameRate != sampleRate) || (frameChannels != channels) || (frameSamples != samplesPerFrame))))
+        {
+            position++;
+            continue;
+        }
+
+        if (frameCount + 2 > capacity)
+        {
+            capacity = (capacity == 0)? 1024 : capacity*2;
+
+            uint32_t *offsets = realloc(frameOffsets, capacity*sizeof(uint32_t));
+            if (offsets == NULL) return false;
+
+            frameOffsets = offsets;
+        }
+
+        sampleRate = frameRate;
+        channels = frameChannels;
+        samplesPerFrame = frameSamples;
+
+        frameOffsets[frameCount++] = (uint32_t)position;
+        frameOffsets[frameCount] = (uint32_t)(position + length);
+        position += length;
+    }
+
+    return (frameCount > 0);
+}
+
+static void *DecodeMusic(void *arg)
+{
+    (void)arg;
+
+    int chunkFrames = (predecoded.data != NULL)? PREDECODED_COPY_FRAMES : MUSIC_CHUNK_MP3_FRAMES*samplesPerFrame;
+
+    while (!atomic_load_explicit(&stopDecoder, memory_order_acquire))
+    {
+        uint64_t write = atomic_load_explicit(&writeFrame, memory_order_relaxed);
+        uint64_t read = atomic_load_explicit(&readFrame, memory_order_acquire);
+        uint64_t discard = atomic_load_explicit(&discardUntil, memory_order_relaxed);
+
+        // The device moves past discarded frames before reading, they count as free
+        if (read < discard) read = discard;
+
+        int space = MUSIC_RING_FRAMES - (int)(write - read);
+
+        if (space < chunkFrames)
+        {
+            WaitTime(DECODER_IDLE_TIME);
+            continue;
+        }
+
+        int frames = (predecoded.data != NULL)? CopyPredecoded(write, chunkFrames) : DecodeNextChunk(write);
+
+        atomic_store_explicit(&writeFrame, write + frames, memory_order_release);
+        if (frames > 0) atomic_store_explicit(&primed, true, memory_order_release);
+    }
+
+    return NULL;
+}
+
+// Decoding starts MUSIC_PREROLL_MP3_FRAMES early so the bit reservoir and overlap state are
+// in place, then only the chunk's own frames are kept, matching a continuous decode
+static int DecodeNextChunk(uint64_t write)
+{
+    int first = nextFrame;
+    int count = (frameCount - first < MUSIC_CHUNK_MP3_FRAMES)? frameCount - first : MUSIC_CHUNK_MP3_FRAMES;
+    int preroll = (first < MUSIC_PREROLL_MP3_FRAMES)? first : MUSIC_PREROLL_MP3_FRAMES;
+
+    uint32_t begin = frameOffsets[first - preroll];
+    uint32_t end = frameOffsets[first + count];
+
+    nextFrame = (first + count < frameCount)? first + count : 0;
+
+    Wave wave = LoadWaveFromMemory(trackType, trackData + begin, (int)(end - begin));
+    if (wave.data == NULL) return 0;
+
+    WaveFormat(&wave, sampleRate, 32, channels);
+
+    unsigned int keep = (unsigned int)(count*samplesPerFrame);
+    unsigned int skip = ((preroll > 0) && (wave.frameCount > keep))? wave.frameCount - keep : 0;
+    int frames = (int)(wave.frameCount - skip);
+
+    if (frames > MUSIC_CHUNK_MP3_FRAMES*samplesPerFrame) frames = MUSIC_CHUNK_MP3_FRAMES*samplesPerFrame;
+
+    WriteRing(write, (const float *)wave.data + skip*channels, frames);
+    UnloadWave(wave);
+
+    return frames;
+}
+
+static int CopyPredecoded(uint64_t write, int frames)
+{
+    unsigned int left = predecoded.frameCount - predecodedCursor;
+
+    if ((unsigned int)frames > left) frames = (int)left;
+
+    WriteRing(write, (const float *)predecoded.data + (size_t)predecodedCursor*channels, frames);
+
+    predecodedCursor += frames;
+    if (predecodedCursor >= predecoded.frameCount) predecodedCursor = 0;
+
+    return frames;
+}
+
+static void WriteRing(uint64_t write, const float *samples, int frames)
+{
+    int start = (int)(write & (MUSIC_RING_FRAMES - 1));
+    int first = (frames < MUSIC_RING_FRAMES - start)? frames : MUSIC_RING_FRAMES - start;
+
+    memcpy(ring + start*channels, samples, (size_t)first*channels*sizeof(float));
+    memcpy(ring, samples + first*channels, (size_t)(frames - first)*channels*sizeof(float));
+}
+
+// Audio device thread: never blocks, plays silence when the decoder is behind
+static void ReadRing(void *buffer, unsigned int frames)
+{
+    float *out = (float *)buffer;
+    uint64_t read = atomic_load_explicit(&readFrame, memory_order_relaxed);
+    uint64_t write = atomic_load_explicit(&writeFrame, memory_order_acquire);
+    uint64_t discard = atomic_load_explicit(&discardUntil, memory_order_relaxed);
+
+    if (read < discard) read = discard;
+
+    unsigned int available = (unsigned int)(write - read);
+    unsigned int count = (frames < available)? frames : available;
+    unsigned int start = (unsigned int)(read & (MUSIC_RING_FRAMES - 1));
+    unsigned int first = (count < MUSIC_RING_FRAMES - start)? count : MUSIC_RING_FRAMES - start;
+
+    memcpy(out, ring + start*channels, (size_t)first*channels*sizeof(float));
+    memcpy(out + first*channels, ring, (size_t)(count - first)*channels*sizeof(float));
+
+    if (count < frames)
+    {
+        memset(out + count*channels, 0, (size_t)(frames - count)*channels*sizeof(float));
+
+        if (atomic_load_explicit(&primed, memory_order_acquire))
+        {
+            atomic_fetch_add_explicit(&underruns, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&underrunFrames, frames - count, memory_order_relaxed);
+        }
+    }
+
+    atomic_fetch_add_explicit(&framesPlayed, count, memory_order_relaxed);
+    atomic_store_explicit(&readFrame, read + count, memory_order_release);
+}
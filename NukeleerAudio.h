@@ -0,0 +1,40 @@
+#ifndef NUKELEER_AUDIO_H
+#define NUKELEER_AUDIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define MUSIC_RING_FRAMES           65536       // PCM frames between decoder and device, power of two (~1.5 s)
+#define MUSIC_CHUNK_MP3_FRAMES      32          // MP3 frames decoded per step (~0.8 s)
+#define MUSIC_PREROLL_MP3_FRAMES    8           // Decoded ahead of each chunk to rebuild the decoder state, then dropped
+#define MUSIC_PREDECODE_SECONDS     30.0f       // Tracks up to this long are decoded whole at load
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct MusicTrackStats {
+    uint64_t framesPlayed;          // Frames handed to the device
+    uint64_t underrunFrames;        // Frames of silence because the decoder fell behind
+    uint32_t underruns;             // Device callbacks that found the ring short
+    int bufferedFrames;             // Decoded and waiting in the ring right now
+} MusicTrackStats;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+// One looping music track, decoded on its own thread into a single-producer/single-consumer
+// ring that the audio device drains from its callback; nothing runs per frame on the main
+// thread. MP3 data is decoded a chunk at a time, anything else (or a short MP3, or with
+// predecode set) is decoded whole here. data must stay valid until UnloadMusicTrack().
+bool LoadMusicTrack(const char *fileType, const unsigned char *data, int dataSize, bool predecode);
+void UnloadMusicTrack(void);
+
+void PlayMusicTrack(void);          // From the start
+void StopMusicTrack(void);
+bool IsMusicTrackPlaying(void);
+MusicTrackStats GetMusicTrackStats(void);
+
+#endif // NUKELEER_AUDIO_H
@@ -0,0 +1,550 @@
+#include "NukeleerAutoplay.h"
+#include "NukeleerBoard.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define SPAWN_X                 ((GRID_HORIZONTAL_SIZE - 4)/2)  // Spawn area origin column, as in Createpiece()
+#define SPAWN_SIZE              4
+#define BARREL_COLORS           3
+#define CLOCK_CHECK_NODES       16          // Placements between deadline checks, power of two
+#define OVERRUN_SLACK           1.1         // Decisions longer than this times the budget count as overruns
+
+// Board evaluation, in game points
+#define GAME_OVER_PENALTY       100000.0f
+#define WEIGHT_HOLE             -30.0f      // Empty cell under a barrel
+#define WEIGHT_HEIGHT           -2.0f       // Per cell of stack height, summed over the columns
+#define WEIGHT_DEAD_CELL        -25.0f      // Open cell next to all three colors, no barrel can ever rest there
+#define WEIGHT_SPAWN_CELL       -200.0f     // Barrel in the spawn rows, one step from topping out
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+struct AutoplayEntry {
+    uint64_t key;               // Board hash mixed with depth, piece and rule state, 0 is empty
+    float value;
+};
+
+typedef struct Landing {
+    int x;
+    int y;
+} Landing;
+
+// Cells a piece can lock in, plus the route to each: from[y][x] is the column the piece
+// entered row y at before stepping to column x (-1 if x is not reachable on row y)
+typedef struct Reach {
+    Landing landings[GRID_HORIZONTAL_SIZE*GRID_VERTICAL_SIZE];
+    int count;
+    signed char from[GRID_VERTICAL_SIZE][GRID_HORIZONTAL_SIZE];
+} Reach;
+
+// Everything the rules need to score the rest of a game from here
+typedef struct SearchNode {
+    Board board;
+    uint64_t hash;              // Zobrist hash of the FULL cells and their colors
+    int lines;
+    int gravitySpeed;
+} SearchNode;
+
+typedef struct Search {
+    Autoplayer *ai;
+    Piece known[2];             // Current and incoming piece, later ones are random
+    RuleSet rules;
+    double deadline;
+    long long nodes;
+    bool timed;                 // Every pass, the first one too; only a zero budget runs untimed
+    bool aborted;
+} Search;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void Decide(Autoplayer *ai, const GameContext *ctx, int x, int y, int firstMoves);
+static float GetPieceValue(Search *search, const SearchNode *node, int ply, int depth);
+static float GetBestLanding(Search *search, const SearchNode *node, const Reach *reach, BarrelColor color, int ply, int depth);
+static float GetLandingValue(Search *search, const SearchNode *node, Landing landing, BarrelColor color, int ply, int depth);
+static void FindLandings(const Board *board, int x, int y, int firstMoves, int moves, Reach *reach);
+static void ClearSpawnCell(const Autoplayer *ai, SearchNode *node, int x, int y);
+static float EvaluateBoard(const Board *board);
+static uint64_t GetBoardHash(const Autoplayer *ai, const Board *board);
+static uint64_t GetNodeKey(const SearchNode *node, int depth, int piece);
+static inline uint64_t GetCellKey(const Autoplayer *ai, int x, int y, BarrelColor color);
+static inline uint16_t GetColorCells(const Board *board, int y, BarrelColor color);
+static inline int CountBits(uint16_t bits);
+static uint64_t SplitMix64(uint64_t *state);
+static double GetAutoplayTime(void);
+
+//--------------------------------------------------------------------------------------
+// Autoplay Module Functions Definition
+//--------------------------------------------------------------------------------------
+bool InitAutoplayer(Autoplayer *ai, double budget)
+{
+    memset(ai, 0, sizeof(Autoplayer));
+
+    ai->budget = budget;
+    ai->table = calloc(AUTOPLAY_TABLE_SIZE, sizeof(AutoplayEntry));
+    ai->keys = malloc(GRID_HORIZONTAL_SIZE*GRID_VERTICAL_SIZE*BARREL_COLORS*sizeof(uint64_t));
+
+    if ((ai->table == NULL) || (ai->keys == NULL))
+    {
+        CloseAutoplayer(ai);
+        return false;
+    }
+
+    uint64_t state = 0x4e756b656c656572ULL;
+
+    for (int i = 0; i < GRID_HORIZONTAL_SIZE*GRID_VERTICAL_SIZE*BARREL_COLORS; i++) ai->keys[i] = SplitMix64(&state);
+
+    return true;
+}
+
+void CloseAutoplayer(Autoplayer *ai)
+{
+    free(ai->table);
+    free(ai->keys);
+
+    ai->table = NULL;
+    ai->keys = NULL;
+}
+
+// Called before every UpdateCore(), so it can predict exactly what this tick will do
+unsigned int GetAutoplayInput(Autoplayer *ai, const GameContext *ctx)
+{
+    // The search runs on bitboards of the default size, other boards get no input
+    if ((ctx->width != GRID_HORIZONTAL_SIZE) || (ctx->height != GRID_VERTICAL_SIZE)) return 0;
+
+    if (!ctx->pieceActive || (ctx->pieceCellCount == 0) || ctx->lineToDelete || ctx->gameOverTriggered || ctx->gameOver)
+    {
+        ai->planned = false;
+        ai->lastInput = 0;
+        return 0;
+    }
+
+    // Barrels are single cells
+    int x = ctx->piecePositionX + ctx->pieceCells[0].x;
+    int y = ctx->piecePositionY + ctx->pieceCells[0].y;
+    bool supported = (GRID_CELL(ctx, x, y + 1) == FULL) || (GRID_CELL(ctx, x, y + 1) == BLOCK);
+    int ticksToGravity = ctx->gravitySpeed - ctx->gravityMovementCounter - 1;
+
+    // Gravity runs before the side step, so a step taken this tick lands on the row below
+    if (ticksToGravity <= 0)
+    {
+        if (supported)
+        {
+            ai->lastInput = 0;
+            return 0;
+        }
+
+        y++;
+        ticksToGravity = ctx->gravitySpeed;
+    }
+
+    if (ai->planned && (y != ai->lastRow))
+    {
+        if ((y > ai->targetY) || (x != ai->path[y - 1]))
+        {
+            ai->planned = false;
+            ai->replans++;
+        }
+    }
+
+    // Taps start on this tick, one every other tick
+    if (!ai->planned) Decide(ai, ctx, x, y, (ticksToGravity + 1)/2);
+
+    ai->lastRow = y;
+
+    unsigned int input = 0;
+
+    if (!ai->planned) input = INPUT_DOWN;
+    else if (x != ai->path[y])
+    {
+        unsigned int key = (ai->path[y] < x)? INPUT_LEFT : INPUT_RIGHT;
+
+        // Release between taps, every press moves one cell straight away
+        input = (ai->lastInput & key)? 0 : key;
+    }
+    else
+    {
+        bool straight = true;
+
+        for (int j = y; j <= ai->targetY; j++)
+        {
+            if (ai->path[j] != x) straight = false;
+        }
+
+        if (straight) input = INPUT_DOWN;
+    }
+
+    ai->lastInput = input;
+
+    return input;
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+
+// Iterative deepening over the landing cells of the active piece; the answer of the
+// deepest search that finished inside the budget is kept. The budget covers the whole
+// decision from here, board conversion included. If even the first pass runs out, the
+// best landing it got to is taken. A zero budget runs the first pass alone, untimed, so
+// headless runs are reproducible.
+static void Decide(Autoplayer *ai, const GameContext *ctx, int x, int y, int firstMoves)
+{
+    double start = GetAutoplayTime();
+    Search search = { 0 };
+    SearchNode root = { 0 };
+    Reach reach;
+
+    search.ai = ai;
+    search.known[0] = ctx->piece;
+    search.known[1] = PeekPiece(&ctx->pieces, 0);
+    search.rules = ctx->rules;
+    search.deadline = start + ai->budget;
+
+    BoardFromGrid(&root.board, ctx->grid, ctx->gridColors);
+    root.hash = GetBoardHash(ai, &root.board);
+    root.lines = ctx->lines;
+    root.gravitySpeed = ctx->gravitySpeed;
+
+    FindLandings(&root.board, x, y, firstMoves, ctx->gravitySpeed/2, &reach);
+
+    ai->planned = false;
+    if (reach.count == 0) return;
+
+    int best = 0;
+    int completedDepth = 0;
+    int maxDepth = (ai->budget > 0.0)? MAX_AUTOPLAY_DEPTH : 1;
+
+    search.timed = (ai->budget > 0.0);
+
+    for (int depth = 1; depth <= maxDepth; depth++)
+    {
+        int bestThisDepth = 0;
+        float bestValue = -3.4e38f;
+
+        for (int i = 0; (i < reach.count) && !search.aborted; i++)
+        {
+            float value = GetLandingValue(&search, &root, reach.landings[i], ctx->piece.color, 0, depth);
+
+            if (search.aborted) break;
+
+            if (value > bestValue)
+            {
+                bestValue = value;
+                bestThisDepth = i;
+            }
+        }
+
+        if (search.aborted)
+        {
+            // Deeper passes cut short are dropped, a partial first pass still beats no plan
+            if (depth == 1) best = bestThisDepth;
+            break;
+        }
+
+        best = bestThisDepth;
+        completedDepth = depth;
+    }
+
+    // Walk the route back from the lock cell, one row at a time
+    Landing target = reach.landings[best];
+    int column = target.x;
+
+    for (int j = target.y; j >= y; j--)
+    {
+        ai->path[j] = column;
+        column = reach.from[j][column];
+    }
+
+    ai->planned = true;
+    ai->targetX = target.x;
+    ai->targetY = target.y;
+    ai->lastRow = y;
+
+    double elapsed = GetAutoplayTime() - start;
+
+    ai->decisions++;
+    ai->depthSum += completedDepth;
+    ai->nodes += search.nodes;
+    if (elapsed > ai->maxDecisionTime) ai->maxDecisionTime = elapsed;
+    if ((ai->budget > 0.0) && (elapsed > ai->budget*OVERRUN_SLACK)) ai->overruns++;
+}
+
+// Value of the piece number ply: the known ones are placed as well as possible,
+// a random one averages every spawn cell and color GeneratePiece() can produce
+static float GetPieceValue(Search *search, const SearchNode *node, int ply, int depth)
+{
+    if (depth == 0) return EvaluateBoard(&node->board);
+
+    int piece = (ply < 2)? ((search->known[ply].x*SPAWN_SIZE + search->known[ply].y)*BARREL_COLORS + (int)search->known[ply].color) : -1;
+    uint64_t key = GetNodeKey(node, depth, piece);
+    AutoplayEntry *entry = &search->ai->table[key & (AUTOPLAY_TABLE_SIZE - 1)];
+
+    if (entry->key == key) return entry->value;
+
+    SearchNode spawned = { 0 };
+    Reach reach;
+    float value = 0.0f;
+
+    if (ply < 2)
+    {
+        Piece known = search->known[ply];
+
+        spawned = *node;
+        ClearSpawnCell(search->ai, &spawned, SPAWN_X + known.x, known.y);
+        FindLandings(&spawned.board, SPAWN_X + known.x, known.y, node->gravitySpeed/4, node->gravitySpeed/2, &reach);
+
+        value = GetBestLanding(search, &spawned, &reach, known.color, ply, depth);
+    }
+    else
+    {
+        for (int sx = 0; (sx < SPAWN_SIZE) && !search->aborted; sx++)
+        {
+            for (int sy = 0; (sy < SPAWN_SIZE) && !search->aborted; sy++)
+            {
+                spawned = *node;
+                ClearSpawnCell(search->ai, &spawned, SPAWN_X + sx, sy);
+                FindLandings(&spawned.board, SPAWN_X + sx, sy, node->gravitySpeed/4, node->gravitySpeed/2, &reach);
+
+                for (int c = 0; c < BARREL_COLORS; c++) value += GetBestLanding(search, &spawned, &reach, (BarrelColor)c, ply, depth);
+            }
+        }
+
+        value /= (float)(SPAWN_SIZE*SPAWN_SIZE*BARREL_COLORS);
+    }
+
+    if (search->aborted) return 0.0f;
+
+    entry->key = key;
+    entry->value = value;
+
+    return value;
+}
+
+static float GetBestLanding(Search *search, const SearchNode *node, const Reach *reach, BarrelColor color, int ply, int depth)
+{
+    // A piece with nowhere to go is stuck in the spawn area, the game is over
+    float best = -GAME_OVER_PENALTY;
+
+    for (int i = 0; (i < reach->count) && !search->aborted; i++)
+    {
+        float value = GetLandingValue(search, node, reach->landings[i], color, ply, depth);
+
+        if (value > best) best = value;
+    }
+
+    return best;
+}
+
+// Points the lock earns, same formulas as the rules, plus the value of what follows
+static float GetLandingValue(Search *search, const SearchNode *node, Landing landing, BarrelColor color, int ply, int depth)
+{
+    search->nodes++;
+
+    if (search->timed && ((search->nodes & (CLOCK_CHECK_NODES - 1)) == 0) && (GetAutoplayTime() > search->deadline)) search->aborted = true;
+    if (search->aborted) return 0.0f;
+
+    SearchNode child = *node;
+    int x = landing.x;
+    int y = landing.y;
+    int slide = BoardLockPiece(&child.board, &x, &y, color);
+    const RuleSet *rules = &search->rules;
+    float reward = (float)(rules->lockScoreBase + (abs(rules->lockScorePivot - ((2*node->lines) + 1)))/rules->lockScoreDivisor + slide);
+
+    if (BoardHasSameColorNeighbour(&child.board, x, y, color)) return reward - rules->sameColorPenalty - GAME_OVER_PENALTY;
+
+    bool lineToDelete = BoardCheckCompletion(&child.board);
+
+    // The top rows are checked before the completed lines are removed
+    if ((child.board.full[0] | child.board.full[1]) & BOARD_INTERIOR_MASK) return reward - GAME_OVER_PENALTY;
+
+    if (lineToDelete)
+    {
+        int deletedLines = BoardDeleteCompleteLines(&child.board);
+
+        child.lines += deletedLines;
+        child.gravitySpeed -= deletedLines*rules->gravityDecay;
+        if (child.gravitySpeed < rules->minGravity) child.gravitySpeed = rules->minGravity;
+        child.hash = GetBoardHash(search->ai, &child.board);
+
+        reward += (float)(rules->lineScoreBase + (child.lines*rules->lineScorePerLine));
+    }
+    else child.hash ^= GetCellKey(search->ai, x, y, color);
+
+    return reward + GetPieceValue(search, &child, ply + 1, depth - 1);
+}
+
+// Every cell the piece can lock in, walking down one row per gravity step: between two
+// steps it can take up to moves side steps through empty cells (firstMoves on the first
+// row), and it locks at the next step if it sits on a barrel or the floor
+static void FindLandings(const Board *board, int x, int y, int firstMoves, int moves, Reach *reach)
+{
+    uint16_t entries = (uint16_t)(1u << x);
+    int steps = firstMoves;
+
+    reach->count = 0;
+    memset(reach->from, -1, sizeof(reach->from));
+
+    for (; (y < GRID_VERTICAL_SIZE - 1) && (entries != 0); y++)
+    {
+        uint16_t open = BOARD_INTERIOR_MASK & ~board->full[y];
+        uint16_t support = (y + 1 == GRID_VERTICAL_SIZE - 1)? BOARD_ROW_MASK : board->full[y + 1];
+        uint16_t exits = 0;
+
+        for (int e = 1; e < GRID_HORIZONTAL_SIZE - 1; e++)
+        {
+            if (!(entries & (1u << e))) continue;
+
+            for (int direction = -1; direction <= 1; direction += 2)
+            {
+                for (int c = e, s = 0; (s <= steps) && (open & (1u << c)); c += direction, s++)
+                {
+                    if (reach->from[y][c] < 0) reach->from[y][c] = (signed char)e;
+                    exits |= (uint16_t)(1u << c);
+                }
+            }
+        }
+
+        for (int c = 1; c < GRID_HORIZONTAL_SIZE - 1; c++)
+        {
+            if (exits & support & (1u << c)) reach->landings[reach->count++] = (Landing){ c, y };
+        }
+
+        entries = exits & ~support;
+        steps = moves;
+    }
+}
+
+// Createpiece() empties the spawn cell, whatever was there
+static void ClearSpawnCell(const Autoplayer *ai, SearchNode *node, int x, int y)
+{
+    if (!(node->board.full[y] & (1u << x))) return;
+
+    node->hash ^= GetCellKey(ai, x, y, BoardGetColor(&node->board, x, y));
+    BoardSetCell(&node->board, x, y, EMPTY);
+}
+
+static float EvaluateBoard(const Board *board)
+{
+    uint16_t colorCells[BARREL_COLORS][GRID_VERTICAL_SIZE] = { 0 };
+    uint16_t covered = 0;
+    int holes = 0;
+    int height = 0;
+    int deadCells = 0;
+    int spawnCells = 0;
+
+    for (int j = 0; j < GRID_VERTICAL_SIZE - 1; j++)
+    {
+        for (int c = 0; c < BARREL_COLORS; c++) colorCells[c][j] = GetColorCells(board, j, (BarrelColor)c);
+    }
+
+    for (int j = 0; j < GRID_VERTICAL_SIZE - 1; j++)
+    {
+        uint16_t full = board->full[j] & BOARD_INTERIOR_MASK;
+        uint16_t dead = BOARD_INTERIOR_MASK & ~full & ~covered;
+
+        for (int c = 0; c < BARREL_COLORS; c++)
+        {
+            uint16_t near = (uint16_t)((colorCells[c][j] << 1) | (colorCells[c][j] >> 1));
+
+            if (j > 0) near |= colorCells[c][j - 1];
+            if (j < GRID_VERTICAL_SIZE - 2) near |= colorCells[c][j + 1];
+
+            dead &= near;
+        }
+
+        holes += CountBits(covered & ~full & BOARD_INTERIOR_MASK);
+        covered |= full;
+        height += CountBits(covered);
+        deadCells += CountBits(dead);
+        if (j < SPAWN_SIZE) spawnCells += CountBits(full);
+    }
+
+    return holes*WEIGHT_HOLE + height*WEIGHT_HEIGHT + deadCells*WEIGHT_DEAD_CELL + spawnCells*WEIGHT_SPAWN_CELL;
+}
+
+static uint64_t GetBoardHash(const Autoplayer *ai, const Board *board)
+{
+    uint64_t hash = 0;
+
+    for (int j = 0; j < GRID_VERTICAL_SIZE - 1; j++)
+    {
+        for (int i = 1; (i < GRID_HORIZONTAL_SIZE - 1) && (board->full[j] >> i); i++)
+        {
+            if (board->full[j] & (1u << i)) hash ^= GetCellKey(ai, i, j, BoardGetColor(board, i, j));
+        }
+    }
+
+    return hash;
+}
+
+// The same board is worth something else with more depth left, another piece to place,
+// or other line and gravity counts, so those are mixed into the table key
+static uint64_t GetNodeKey(const SearchNode *node, int depth, int piece)
+{
+    uint64_t state = (uint64_t)depth | ((uint64_t)(piece + 1) << 8) | ((uint64_t)node->gravitySpeed << 16) | ((uint64_t)node->lines << 24);
+
+    return (node->hash ^ SplitMix64(&state)) | 1;
+}
+
+static inline uint64_t GetCellKey(const Autoplayer *ai, int x, int y, BarrelColor color)
+{
+    return ai->keys[(y*GRID_HORIZONTAL_SIZE + x)*BARREL_COLORS + color];
+}
+
+// FULL cells of row y holding the given color
+static inline uint16_t GetColorCells(const Board *board, int y, BarrelColor color)
+{
+    uint16_t low = (color & 1)? board->colorLow[y] : (uint16_t)~board->colorLow[y];
+    uint16_t high = (color & 2)? board->colorHigh[y] : (uint16_t)~board->colorHigh[y];
+
+    return board->full[y] & low & high;
+}
+
+static inline int CountBits(uint16_t bits)
+{
+    int count = 0;
+
+    for (; bits != 0; bits &= (uint16_t)(bits - 1)) count++;
+
+    return count;
+}
+
+static uint64_t SplitMix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27))*0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+static double GetAutoplayTime(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart/(double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + now.tv_nsec*1e-9;
+#endif
+}
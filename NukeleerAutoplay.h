@@ -0,0 +1,55 @@
+#ifndef NUKELEER_AUTOPLAY_H
+#define NUKELEER_AUTOPLAY_H
+
+#include "NukeleerCore.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define AUTOPLAY_BUDGET         0.001       // Default seconds per decision
+#define AUTOPLAY_TABLE_SIZE     65536       // Transposition table entries, power of two
+#define MAX_AUTOPLAY_DEPTH      4           // Pieces searched: current, incoming, then random ones
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct AutoplayEntry AutoplayEntry;
+
+// Plays through the same per-tick input bitmask as a person. Once per piece it searches
+// every reachable landing cell with expectimax (the current and incoming pieces are
+// known, later ones average over the spawn cells and colors), then steers the piece
+// there by tapping the keys. Owns its transposition table, so one per thread. Plays
+// boards of the default size only.
+typedef struct Autoplayer {
+    double budget;                      // Seconds per decision, the deepest finished search wins; 0 searches one piece, untimed
+    AutoplayEntry *table;
+    uint64_t *keys;                     // Zobrist keys, one per cell and color
+
+    // Plan for the active piece: the column to be in on each row, down to the lock cell
+    bool planned;
+    int path[GRID_VERTICAL_SIZE];
+    int targetX;
+    int targetY;
+    int lastRow;
+    unsigned int lastInput;
+
+    // Statistics
+    int decisions;
+    int replans;                        // The piece left the planned path (timing was tighter than modelled)
+    int depthSum;                       // Completed search depth, summed over decisions
+    long long nodes;
+    double maxDecisionTime;
+    int overruns;                       // Decisions past the budget: the clock is checked every few nodes, and a thread can be preempted
+} Autoplayer;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+bool InitAutoplayer(Autoplayer *ai, double budget);     // Allocates the transposition table
+void CloseAutoplayer(Autoplayer *ai);
+unsigned int GetAutoplayInput(Autoplayer *ai, const GameContext *ctx);  // INPUT_* bits for the next tick
+
+#endif // NUKELEER_AUTOPLAY_H
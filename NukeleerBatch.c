@@ -0,0 +1,205 @@
+#include "NukeleerBatch.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// One worker's share of game indices, packed as (end << 32) | begin so the owner
+// (taking from begin) and thieves (taking from end) agree through a single CAS.
+// Aligned to its own cache line so workers never false-share their ranges.
+typedef struct BatchWorker {
+    _Alignas(64) _Atomic uint64_t range;
+    pthread_t thread;
+    int index;
+    struct BatchShared *shared;
+    GameContext ctx;
+} BatchWorker;
+
+typedef struct BatchShared {
+    BatchWorker *workers;
+    int workerCount;
+    BatchGameCallback playGame;
+    void *userData;
+} BatchShared;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void *AllocWorkers(int count);
+static void FreeWorkers(void *workers);
+static inline uint64_t PackRange(uint32_t begin, uint32_t end);
+static bool PopGame(BatchWorker *worker, int *gameIndex);
+static bool StealGames(BatchWorker *thief);
+static void *WorkerMain(void *arg);
+
+//--------------------------------------------------------------------------------------
+// Batch Module Functions Definition
+//--------------------------------------------------------------------------------------
+int GetProcessorCount(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    return (count > 0)? count : 1;
+}
+
+void RunBatch(int gameCount, int threadCount, BatchGameCallback playGame, void *userData)
+{
+    if (gameCount <= 0) return;
+
+    if (threadCount <= 0) threadCount = GetProcessorCount();
+    if (threadCount > MAX_BATCH_THREADS) threadCount = MAX_BATCH_THREADS;
+    if (threadCount > gameCount) threadCount = gameCount;
+
+    BatchShared shared = { 0 };
+    shared.workers = AllocWorkers(threadCount);
+    shared.workerCount = threadCount;
+    shared.playGame = playGame;
+    shared.userData = userData;
+
+    if (shared.workers == NULL) return;
+
+    // Even initial split, the first (gameCount % threadCount) workers get one extra game
+    uint32_t begin = 0;
+
+    for (int w = 0; w < threadCount; w++)
+    {
+        uint32_t count = (uint32_t)(gameCount/threadCount + ((w < gameCount%threadCount)? 1 : 0));
+
+        atomic_init(&shared.workers[w].range, PackRange(begin, begin + count));
+        shared.workers[w].index = w;
+        shared.workers[w].shared = &shared;
+        shared.workers[w].ctx = (GameContext){ 0 };
+        begin += count;
+    }
+
+    // The calling thread works as worker 0
+    for (int w = 1; w < threadCount; w++) pthread_create(&shared.workers[w].thread, NULL, WorkerMain, &shared.workers[w]);
+
+    WorkerMain(&shared.workers[0]);
+
+    for (int w = 1; w < threadCount; w++) pthread_join(shared.workers[w].thread, NULL);
+    for (int w = 0; w < threadCount; w++) UnloadCore(&shared.workers[w].ctx);
+
+    FreeWorkers(shared.workers);
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+// Workers are cache-line aligned, which plain malloc() does not guarantee
+static void *AllocWorkers(int count)
+{
+#if defined(_WIN32)
+    return _aligned_malloc(sizeof(BatchWorker)*count, 64);
+#else
+    return aligned_alloc(64, sizeof(BatchWorker)*count);
+#endif
+}
+
+static void FreeWorkers(void *workers)
+{
+#if defined(_WIN32)
+    _aligned_free(workers);
+#else
+    free(workers);
+#endif
+}
+
+static inline uint64_t PackRange(uint32_t begin, uint32_t end)
+{
+    return ((uint64_t)end << 32) | begin;
+}
+
+// Take the next game from the front of our own range
+static bool PopGame(BatchWorker *worker, int *gameIndex)
+{
+    uint64_t range = atomic_load_explicit(&worker->range, memory_order_relaxed);
+
+    for (;;)
+    {
+        uint32_t begin = (uint32_t)range;
+        uint32_t end = (uint32_t)(range >> 32);
+
+        if (begin >= end) return false;
+
+        if (atomic_compare_exchange_weak(&worker->range, &range, PackRange(begin + 1, end)))
+        {
+            *gameIndex = (int)begin;
+            return true;
+        }
+    }
+}
+
+// Move the back half of the largest remaining range into our (empty) range
+static bool StealGames(BatchWorker *thief)
+{
+    BatchShared *shared = thief->shared;
+
+    for (;;)
+    {
+        BatchWorker *victim = NULL;
+        uint64_t victimRange = 0;
+        uint32_t largest = 0;
+
+        for (int w = 0; w < shared->workerCount; w++)
+        {
+            if (w == thief->index) continue;
+
+            uint64_t range = atomic_load_explicit(&shared->workers[w].range, memory_order_relaxed);
+            uint32_t begin = (uint32_t)range;
+            uint32_t end = (uint32_t)(range >> 32);
+
+            if ((end > begin) && (end - begin > largest))
+            {
+                largest = end - begin;
+                victim = &shared->workers[w];
+                victimRange = range;
+            }
+        }
+
+        // Games are never added, so once every range is empty the batch is finishing
+        if (victim == NULL) return false;
+
+        uint32_t begin = (uint32_t)victimRange;
+        uint32_t end = (uint32_t)(victimRange >> 32);
+        uint32_t split = end - (largest + 1)/2;
+
+        if (atomic_compare_exchange_strong(&victim->range, &victimRange, PackRange(begin, split)))
+        {
+            atomic_store(&thief->range, PackRange(split, end));
+            return true;
+        }
+    }
+}
+
+static void *WorkerMain(void *arg)
+{
+    BatchWorker *worker = (BatchWorker *)arg;
+    BatchShared *shared = worker->shared;
+    int gameIndex = 0;
+
+    do
+    {
+        while (PopGame(worker, &gameIndex)) shared->playGame(&worker->ctx, gameIndex, shared->userData);
+
+    } while (StealGames(worker));
+
+    return NULL;
+}
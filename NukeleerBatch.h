@@ -0,0 +1,28 @@
+#ifndef NUKELEER_BATCH_H
+#define NUKELEER_BATCH_H
+
+#include "NukeleerCore.h"
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define MAX_BATCH_THREADS       256
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// Plays game number gameIndex on a context owned by the calling worker. Results
+// should be written to per-game slots in userData so workers never share writes.
+typedef void (*BatchGameCallback)(GameContext *ctx, int gameIndex, void *userData);
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+int GetProcessorCount(void);    // Logical cores available to the process
+
+// Run gameCount independent games across threadCount workers (0 uses every core).
+// Each worker starts with an even share of the games and steals half of the
+// largest remaining share once its own runs out. Returns when all games are done.
+void RunBatch(int gameCount, int threadCount, BatchGameCallback playGame, void *userData);
+
+#endif // NUKELEER_BATCH_H
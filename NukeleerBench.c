@@ -0,0 +1,490 @@
+// Microbenchmarks for the rule helpers, on both the grid rules and the bitboard engine,
+// plus whole-game throughput. No window, GL context or audio device. Results are
+// written as JSON so runs from different builds can be compared.
+//
+// Usage: NukeleerBench [output.json]      Writes to stdout without a file name
+
+#include "NukeleerCoreInternal.h"
+#include "NukeleerBoard.h"
+
+#include <stdio.h>
+#include <time.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define MIN_BENCH_TIME          0.2         // Seconds each measurement runs for at least
+#define BENCH_GAMES             2000
+#define MAX_GAME_TICKS          1000000
+#define INPUT_HOLD_TICKS        20          // Same random player as NukeleerSim
+#define PIECE_COLUMN            5
+#define BOARD_SIZE_TICKS        2000000     // Ticks played on each board size
+#define BENCH_POOL_SIZE         128         // Fixture copies per timed batch, small enough to stay in cache
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum BoardFixture {
+    FIXTURE_EMPTY,
+    FIXTURE_HALF_FULL,          // Bottom half filled, one hole per row
+    FIXTURE_NEAR_TOPOUT,        // Filled up to the third row, one hole per row
+    FIXTURE_MULTI_LINE_CLEAR,   // Four complete rows under a holed stack
+    FIXTURE_TOWER,              // A single column, the locked piece slides all the way down-left
+    FIXTURE_COUNT
+} BoardFixture;
+
+typedef struct BenchState {
+    GameContext resting;        // Piece on top of the stack, about to lock
+    GameContext falling;        // Piece in the top row with room below
+    GameContext faded;          // resting after CheckCompletion(), rows marked FADING
+    Board restingBoard;
+    Board fadedBoard;
+
+    // Ops that change their board take a fresh fixture copy from here, one per call. The
+    // pools are refilled between timed batches, so the copies are never part of the time.
+    GameContext pool[BENCH_POOL_SIZE];
+    Board boardPool[BENCH_POOL_SIZE];
+    int next;
+
+    int pieceX;
+    int pieceY;
+    unsigned int flip;
+    long long sink;             // Keeps results alive so nothing is optimized out
+} BenchState;
+
+typedef void (*BenchOp)(BenchState *state);
+
+typedef struct BenchCase {
+    const char *name;
+    const char *engine;
+    BenchOp op;
+    BenchOp prepare;            // Refills the pool before each batch, NULL for ops that only read
+} BenchCase;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void InitBenchState(BenchState *state, BoardFixture fixture);
+static void PlacePiece(GameContext *ctx, int x, int y);
+static double MeasureOp(const BenchCase *bench, BenchState *state, long long *iterations);
+static void MeasureGames(double *gamesPerSecond, double *ticksPerSecond, long long *totalTicks);
+static double MeasureBoardTicks(int width, int height);
+static unsigned int GetRandomInput(unsigned int *state);
+static double GetWallTime(void);
+
+static void PrepareResting(BenchState *state);
+static void PrepareFalling(BenchState *state);
+static void PrepareFaded(BenchState *state);
+static void PrepareRestingBoards(BenchState *state);
+static void PrepareFadedBoards(BenchState *state);
+
+static void OpCopyGrid(BenchState *state);
+static void OpCopyBoard(BenchState *state);
+static void OpCheckDetection(BenchState *state);
+static void OpCheckCompletion(BenchState *state);
+static void OpDeleteCompleteLines(BenchState *state);
+static void OpResolveLateral(BenchState *state);
+static void OpResolveFallingFree(BenchState *state);
+static void OpResolveFallingLock(BenchState *state);
+static void OpBoardCheckDetection(BenchState *state);
+static void OpBoardCheckCompletion(BenchState *state);
+static void OpBoardDeleteCompleteLines(BenchState *state);
+static void OpBoardLockPiece(BenchState *state);
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+static const char *fixtureNames[FIXTURE_COUNT] = { "empty", "half-full", "near-topout", "multi-line-clear", "tower" };
+static const int boardSizes[][2] = { { GRID_HORIZONTAL_SIZE, GRID_VERTICAL_SIZE }, { 64, 256 }, { MAX_GRID_HORIZONTAL_SIZE, MAX_GRID_VERTICAL_SIZE } };
+
+static const BenchCase cases[] = {
+    { "CopyCore", "grid", OpCopyGrid, NULL },
+    { "CheckDetection", "grid", OpCheckDetection, NULL },
+    { "CheckCompletion", "grid", OpCheckCompletion, PrepareResting },
+    { "DeleteCompleteLines", "grid", OpDeleteCompleteLines, PrepareFaded },
+    { "ResolveLateralMovement", "grid", OpResolveLateral, NULL },
+    { "ResolveFallingMovement/fall", "grid", OpResolveFallingFree, PrepareFalling },
+    { "ResolveFallingMovement/lock-slide", "grid", OpResolveFallingLock, PrepareResting },
+    { "copy", "bitboard", OpCopyBoard, NULL },
+    { "CheckDetection", "bitboard", OpBoardCheckDetection, NULL },
+    { "CheckCompletion", "bitboard", OpBoardCheckCompletion, PrepareRestingBoards },
+    { "DeleteCompleteLines", "bitboard", OpBoardDeleteCompleteLines, PrepareFadedBoards },
+    { "LockPiece/lock-slide", "bitboard", OpBoardLockPiece, PrepareRestingBoards },
+};
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    FILE *out = (argc > 1)? fopen(argv[1], "w") : stdout;
+    if (out == NULL)
+    {
+        printf("could not create %s\n", argv[1]);
+        return 1;
+    }
+
+    static BenchState state = { 0 };
+    long long iterations = 0;
+    bool first = true;
+
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+
+    for (int f = 0; f < FIXTURE_COUNT; f++)
+    {
+        InitBenchState(&state, (BoardFixture)f);
+
+        for (int c = 0; c < (int)(sizeof(cases)/sizeof(cases[0])); c++)
+        {
+            double ns = MeasureOp(&cases[c], &state, &iterations);
+
+            fprintf(out, "%s    { \"name\": \"%s\", \"engine\": \"%s\", \"fixture\": \"%s\", \"ns_per_op\": %.2f, \"iterations\": %lld }",
+                    first? "" : ",\n", cases[c].name, cases[c].engine, fixtureNames[f], ns, iterations);
+            first = false;
+        }
+    }
+
+    double gamesPerSecond = 0.0, ticksPerSecond = 0.0;
+    long long totalTicks = 0;
+
+    MeasureGames(&gamesPerSecond, &ticksPerSecond, &totalTicks);
+
+    fprintf(out, "\n  ],\n  \"games\": { \"count\": %i, \"ticks\": %lld, \"games_per_second\": %.1f, \"ticks_per_second\": %.1f },\n",
+            BENCH_GAMES, totalTicks, gamesPerSecond, ticksPerSecond);
+
+    fprintf(out, "  \"board_sizes\": [\n");
+
+    for (int b = 0; b < (int)(sizeof(boardSizes)/sizeof(boardSizes[0])); b++)
+    {
+        fprintf(out, "%s    { \"width\": %i, \"height\": %i, \"ns_per_tick\": %.2f }", (b > 0)? ",\n" : "",
+                boardSizes[b][0], boardSizes[b][1], MeasureBoardTicks(boardSizes[b][0], boardSizes[b][1]));
+    }
+
+    fprintf(out, "\n  ],\n");
+    fprintf(out, "  \"sink\": %lld\n}\n", state.sink);
+
+    if (out != stdout) fclose(out);
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------
+// Module Functions Definition
+//--------------------------------------------------------------------------------------
+static void InitBenchState(BenchState *state, BoardFixture fixture)
+{
+    GameContext *ctx = &state->resting;
+    int top = GRID_VERTICAL_SIZE - 1;           // First stack row in the piece column
+
+    InitCore(ctx, 1);
+
+    for (int j = 0; j < GRID_VERTICAL_SIZE - 1; j++)
+    {
+        bool filled = false;
+        bool complete = false;
+
+        switch (fixture)
+        {
+            case FIXTURE_HALF_FULL: filled = (j >= GRID_VERTICAL_SIZE/2); break;
+            case FIXTURE_NEAR_TOPOUT: filled = (j >= 3); break;
+            case FIXTURE_MULTI_LINE_CLEAR: filled = (j >= GRID_VERTICAL_SIZE/2); complete = (j >= GRID_VERTICAL_SIZE - 5); break;
+            default: break;
+        }
+
+        for (int i = 1; i < GRID_HORIZONTAL_SIZE - 1; i++)
+        {
+            bool hole = !complete && (i == 1 + (j*7)%(GRID_HORIZONTAL_SIZE - 2)) && (i != PIECE_COLUMN);
+
+            if (fixture == FIXTURE_TOWER) filled = (i == PIECE_COLUMN) && (j >= 8);
+
+            if (filled && !hole)
+            {
+                SetCell(ctx, i, j, FULL);
+                GRID_COLOR(ctx, i, j) = (BarrelColor)((i*7 + j*3)%3);
+            }
+        }
+    }
+
+    for (int j = 0; j < GRID_VERTICAL_SIZE - 1; j++)
+    {
+        if (GRID_CELL(ctx, PIECE_COLUMN, j) == FULL) { top = j; break; }
+    }
+
+    CopyCore(&state->falling, ctx);
+
+    state->pieceX = PIECE_COLUMN;
+    state->pieceY = top - 1;
+    PlacePiece(ctx, state->pieceX, state->pieceY);
+    PlacePiece(&state->falling, PIECE_COLUMN, 0);
+
+    // Every filled row is dirty, so this marks all the complete ones
+    CopyCore(&state->faded, ctx);
+    bool lineToDelete = false;
+    CheckCompletion(&state->faded, &lineToDelete);
+
+    // As in a game, only the row the piece locks into is left to check
+    for (int k = 0; k < ctx->dirtyRowCount; k++) ctx->rowDirty[ctx->dirtyRows[k]] = false;
+    ctx->dirtyRowCount = 0;
+    ctx->rowDirty[state->pieceY] = true;
+    ctx->dirtyRows[ctx->dirtyRowCount++] = state->pieceY;
+
+    BoardFromGrid(&state->restingBoard, state->resting.grid, state->resting.gridColors);
+    BoardFromGrid(&state->fadedBoard, state->faded.grid, state->faded.gridColors);
+
+    // The bitboard still carries the piece as a MOVING cell
+    BoardSetCell(&state->restingBoard, state->pieceX, state->pieceY, MOVING);
+    BoardSetCell(&state->fadedBoard, state->pieceX, state->pieceY, MOVING);
+
+    // Allocates the pool grids now, so no timed copy has to
+    PrepareResting(state);
+    state->flip = 0;
+}
+
+static void PlacePiece(GameContext *ctx, int x, int y)
+{
+    ctx->piece = (Piece){ 0, y, BARREL_BLUE };
+    ctx->piecePositionX = x;
+    ctx->piecePositionY = y;
+    ctx->pieceCells[0] = (PieceCell){ 0, 0 };
+    ctx->pieceCellCount = 1;
+    ctx->pieceActive = true;
+}
+
+// Doubles the iteration count until the timed batches add up to MIN_BENCH_TIME, returns
+// ns per call. Each batch runs over the whole pool, refilled before the clock starts.
+static double MeasureOp(const BenchCase *bench, BenchState *state, long long *iterations)
+{
+    long long count = 8*BENCH_POOL_SIZE;
+
+    for (;;)
+    {
+        double elapsed = 0.0;
+
+        for (long long done = 0; done < count; done += BENCH_POOL_SIZE)
+        {
+            if (bench->prepare != NULL) bench->prepare(state);
+            state->next = 0;
+
+            double start = GetWallTime();
+
+            for (int i = 0; i < BENCH_POOL_SIZE; i++) bench->op(state);
+
+            elapsed += GetWallTime() - start;
+        }
+
+        if (elapsed >= MIN_BENCH_TIME)
+        {
+            *iterations = count;
+            return elapsed*1e9/count;
+        }
+
+        count *= 2;
+    }
+}
+
+static void MeasureGames(double *gamesPerSecond, double *ticksPerSecond, long long *totalTicks)
+{
+    static GameContext ctx = { 0 };
+
+    double start = GetWallTime();
+
+    *totalTicks = 0;
+
+    for (int g = 0; g < BENCH_GAMES; g++)
+    {
+        unsigned int gameSeed = 1 + (unsigned int)g*2654435761u;
+        unsigned int inputState = ~gameSeed;
+        unsigned int input = 0;
+
+        InitCore(&ctx, gameSeed);
+
+        for (int t = 0; (t < MAX_GAME_TICKS) && !ctx.gameOver; t++)
+        {
+            if ((t%INPUT_HOLD_TICKS) == 0) input = GetRandomInput(&inputState);
+
+            UpdateCore(&ctx, input);
+            (*totalTicks)++;
+        }
+    }
+
+    double seconds = GetWallTime() - start;
+    if (seconds <= 0.0) seconds = 1e-9;
+
+    *gamesPerSecond = BENCH_GAMES/seconds;
+    *ticksPerSecond = *totalTicks/seconds;
+}
+
+// Tick cost of random games on one board size, setup excluded. A tick only touches the
+// piece and the rows it changes, so this should stay flat as the board grows.
+static double MeasureBoardTicks(int width, int height)
+{
+    static GameContext ctx = { 0 };
+    RuleSet rules = GetDefaultRules();
+    long long ticks = 0;
+    double seconds = 0.0;
+
+    rules.gridWidth = width;
+    rules.gridHeight = height;
+
+    for (unsigned int g = 0; ticks < BOARD_SIZE_TICKS; g++)
+    {
+        unsigned int gameSeed = 1 + g*2654435761u;
+        unsigned int inputState = ~gameSeed;
+        unsigned int input = 0;
+
+        InitCoreWithRules(&ctx, gameSeed, rules);
+
+        double start = GetWallTime();
+
+        for (int t = 0; (ticks < BOARD_SIZE_TICKS) && !ctx.gameOver; t++)
+        {
+            if ((t%INPUT_HOLD_TICKS) == 0) input = GetRandomInput(&inputState);
+
+            UpdateCore(&ctx, input);
+            ticks++;
+        }
+
+        seconds += GetWallTime() - start;
+    }
+
+    return seconds*1e9/ticks;
+}
+
+// Same random player as NukeleerSim
+static unsigned int GetRandomInput(unsigned int *state)
+{
+    static const unsigned int choices[] = {
+        0, INPUT_LEFT, INPUT_RIGHT, INPUT_DOWN, INPUT_LEFT | INPUT_DOWN, INPUT_RIGHT | INPUT_DOWN
+    };
+
+    *state = *state*1103515245u + 12345u;
+
+    return choices[((*state >> 16) & 0x7fff)%(sizeof(choices)/sizeof(choices[0]))];
+}
+
+static double GetWallTime(void)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+
+    return (double)now.tv_sec + now.tv_nsec*1e-9;
+}
+
+//--------------------------------------------------------------------------------------
+// Pool fixtures
+//--------------------------------------------------------------------------------------
+static void PrepareResting(BenchState *state)
+{
+    for (int i = 0; i < BENCH_POOL_SIZE; i++) CopyCore(&state->pool[i], &state->resting);
+}
+
+static void PrepareFalling(BenchState *state)
+{
+    for (int i = 0; i < BENCH_POOL_SIZE; i++) CopyCore(&state->pool[i], &state->falling);
+}
+
+static void PrepareFaded(BenchState *state)
+{
+    for (int i = 0; i < BENCH_POOL_SIZE; i++) CopyCore(&state->pool[i], &state->faded);
+}
+
+static void PrepareRestingBoards(BenchState *state)
+{
+    for (int i = 0; i < BENCH_POOL_SIZE; i++) state->boardPool[i] = state->restingBoard;
+}
+
+static void PrepareFadedBoards(BenchState *state)
+{
+    for (int i = 0; i < BENCH_POOL_SIZE; i++) state->boardPool[i] = state->fadedBoard;
+}
+
+//--------------------------------------------------------------------------------------
+// Benchmarked operations
+//--------------------------------------------------------------------------------------
+static void OpCopyGrid(BenchState *state)
+{
+    GameContext *work = &state->pool[state->next++];
+
+    CopyCore(work, &state->resting);
+    state->sink += work->score;
+}
+
+static void OpCopyBoard(BenchState *state)
+{
+    Board *work = &state->boardPool[state->next++];
+
+    *work = state->restingBoard;
+    state->sink += work->full[0];
+}
+
+static void OpCheckDetection(BenchState *state)
+{
+    bool detection = false;
+
+    CheckDetection(&state->resting, &detection);
+    state->sink += detection;
+}
+
+static void OpCheckCompletion(BenchState *state)
+{
+    GameContext *work = &state->pool[state->next++];
+    bool lineToDelete = false;
+
+    CheckCompletion(work, &lineToDelete);
+    state->sink += lineToDelete;
+}
+
+static void OpDeleteCompleteLines(BenchState *state)
+{
+    state->sink += DeleteCompleteLines(&state->pool[state->next++]);
+}
+
+// Left then right, so the piece keeps coming back to the same cell
+static void OpResolveLateral(BenchState *state)
+{
+    state->flip ^= 1;
+    state->sink += ResolveLateralMovement(&state->falling, state->flip? INPUT_LEFT : INPUT_RIGHT);
+}
+
+static void OpResolveFallingFree(BenchState *state)
+{
+    GameContext *work = &state->pool[state->next++];
+    bool detection = false;
+    bool pieceActive = true;
+
+    ResolveFallingMovement(work, &detection, &pieceActive);
+    state->sink += work->piecePositionY;
+}
+
+static void OpResolveFallingLock(BenchState *state)
+{
+    GameContext *work = &state->pool[state->next++];
+    bool detection = true;
+    bool pieceActive = true;
+
+    ResolveFallingMovement(work, &detection, &pieceActive);
+    state->sink += work->score;
+}
+
+static void OpBoardCheckDetection(BenchState *state)
+{
+    state->sink += BoardCheckDetection(&state->restingBoard);
+}
+
+static void OpBoardCheckCompletion(BenchState *state)
+{
+    state->sink += BoardCheckCompletion(&state->boardPool[state->next++]);
+}
+
+static void OpBoardDeleteCompleteLines(BenchState *state)
+{
+    state->sink += BoardDeleteCompleteLines(&state->boardPool[state->next++]);
+}
+
+static void OpBoardLockPiece(BenchState *state)
+{
+    int x = state->pieceX;
+    int y = state->pieceY;
+
+    state->sink += BoardLockPiece(&state->boardPool[state->next++], &x, &y, BARREL_BLUE);
+}
@@ -0,0 +1,240 @@
+#include "NukeleerBoard.h"
+
+#include <string.h>
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static inline uint16_t GetBlockRow(int y);
+static inline uint16_t GetOccupiedRow(const Board *board, int y);
+static inline uint16_t GetColorRow(const Board *board, int y, BarrelColor color);
+static inline bool IsEmpty(const Board *board, int x, int y);
+
+//--------------------------------------------------------------------------------------
+// Board Module Functions Definition
+//--------------------------------------------------------------------------------------
+
+// Pack a GridSquare matrix (row-major, as in GameContext) into row masks
+void BoardFromGrid(Board *board, const GridSquare *grid, const BarrelColor *colors)
+{
+    memset(board, 0, sizeof(Board));
+
+    for (int j = 0; j < GRID_VERTICAL_SIZE; j++)
+    {
+        for (int i = 0; i < GRID_HORIZONTAL_SIZE; i++)
+        {
+            BoardSetCell(board, i, j, grid[j*GRID_HORIZONTAL_SIZE + i]);
+            BoardSetColor(board, i, j, colors[j*GRID_HORIZONTAL_SIZE + i]);
+        }
+    }
+}
+
+// Unpack the row masks back into a GridSquare matrix
+void BoardToGrid(const Board *board, GridSquare *grid, BarrelColor *colors)
+{
+    for (int j = 0; j < GRID_VERTICAL_SIZE; j++)
+    {
+        for (int i = 0; i < GRID_HORIZONTAL_SIZE; i++)
+        {
+            grid[j*GRID_HORIZONTAL_SIZE + i] = BoardGetCell(board, i, j);
+            colors[j*GRID_HORIZONTAL_SIZE + i] = BoardGetColor(board, i, j);
+        }
+    }
+}
+
+GridSquare BoardGetCell(const Board *board, int x, int y)
+{
+    uint16_t bit = (uint16_t)(1u << x);
+
+    if (GetBlockRow(y) & bit) return BLOCK;
+    if (board->full[y] & bit) return FULL;
+    if (board->moving[y] & bit) return MOVING;
+    if (board->fading[y] & bit) return FADING;
+
+    return EMPTY;
+}
+
+BarrelColor BoardGetColor(const Board *board, int x, int y)
+{
+    int low = (board->colorLow[y] >> x) & 1;
+    int high = (board->colorHigh[y] >> x) & 1;
+
+    return (BarrelColor)(low | (high << 1));
+}
+
+// BLOCK is fixed by the walls, so setting it (or anything over a wall) only clears the other states
+void BoardSetCell(Board *board, int x, int y, GridSquare square)
+{
+    uint16_t bit = (uint16_t)(1u << x);
+
+    board->full[y] &= ~bit;
+    board->moving[y] &= ~bit;
+    board->fading[y] &= ~bit;
+
+    if (GetBlockRow(y) & bit) return;
+
+    if (square == FULL) board->full[y] |= bit;
+    else if (square == MOVING) board->moving[y] |= bit;
+    else if (square == FADING) board->fading[y] |= bit;
+}
+
+void BoardSetColor(Board *board, int x, int y, BarrelColor color)
+{
+    uint16_t bit = (uint16_t)(1u << x);
+
+    if (color & 1) board->colorLow[y] |= bit;
+    else board->colorLow[y] &= ~bit;
+
+    if (color & 2) board->colorHigh[y] |= bit;
+    else board->colorHigh[y] &= ~bit;
+}
+
+// Same rule as CheckDetection(): a moving cell with FULL or BLOCK right below it
+bool BoardCheckDetection(const Board *board)
+{
+    for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
+    {
+        if (board->moving[j] & (board->full[j + 1] | GetBlockRow(j + 1))) return true;
+    }
+
+    return false;
+}
+
+// Same rule as CheckCompletion(): every interior cell FULL turns the row FADING
+bool BoardCheckCompletion(Board *board)
+{
+    bool lineToDelete = false;
+
+    for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
+    {
+        if ((board->full[j] & BOARD_INTERIOR_MASK) == BOARD_INTERIOR_MASK)
+        {
+            board->full[j] &= ~BOARD_INTERIOR_MASK;
+            board->fading[j] |= BOARD_INTERIOR_MASK;
+            lineToDelete = true;
+        }
+    }
+
+    return lineToDelete;
+}
+
+// Same-color game over test from ResolveFallingMovement(), four neighbours at once
+bool BoardHasSameColorNeighbour(const Board *board, int x, int y, BarrelColor color)
+{
+    uint16_t bit = (uint16_t)(1u << x);
+    uint16_t sides = (uint16_t)((bit << 1) | (bit >> 1));
+    uint16_t match = board->full[y] & GetColorRow(board, y, color) & sides;
+
+    if (y > 0) match |= board->full[y - 1] & GetColorRow(board, y - 1, color) & bit;
+    if (y < GRID_VERTICAL_SIZE - 1) match |= board->full[y + 1] & GetColorRow(board, y + 1, color) & bit;
+
+    return (match != 0);
+}
+
+// Lock the moving cell at (x, y) and let it slide diagonally (left first, then right)
+// exactly like ResolveFallingMovement(). The final position is written back to x and y.
+int BoardLockPiece(Board *board, int *x, int *y, BarrelColor color)
+{
+    int i = *x;
+    int j = *y;
+    int slide = 0;
+
+    BoardSetCell(board, i, j, FULL);
+    BoardSetColor(board, i, j, color);
+
+    bool canMoveDownLeft = (i < GRID_HORIZONTAL_SIZE - 1) && (j < GRID_VERTICAL_SIZE - 1) && IsEmpty(board, i - 1, j + 1);
+    bool canMoveDownRight = (i < GRID_HORIZONTAL_SIZE - 1) && (j < GRID_VERTICAL_SIZE - 1) && IsEmpty(board, i + 1, j + 1);
+
+    while (canMoveDownLeft)
+    {
+        BoardSetCell(board, i, j, EMPTY);
+        BoardSetCell(board, i - 1, j + 1, FULL);
+        BoardSetColor(board, i - 1, j + 1, color);
+
+        j++;
+        i--;
+        slide++;
+
+        if ((j >= GRID_VERTICAL_SIZE - 1) || (i <= 0) || !IsEmpty(board, i - 1, j + 1)) break;
+    }
+
+    while (!canMoveDownLeft && canMoveDownRight)
+    {
+        BoardSetCell(board, i, j, EMPTY);
+        BoardSetCell(board, i + 1, j + 1, FULL);
+        BoardSetColor(board, i + 1, j + 1, color);
+
+        j++;
+        i++;
+        slide++;
+
+        if ((j >= GRID_VERTICAL_SIZE - 1) || (i >= GRID_HORIZONTAL_SIZE - 1) || !IsEmpty(board, i + 1, j + 1)) break;
+    }
+
+    *x = i;
+    *y = j;
+
+    return slide;
+}
+
+// Same result as DeleteCompleteLines(): FADING rows vanish and the rows above drop down,
+// taking their colors with them.
+int BoardDeleteCompleteLines(Board *board)
+{
+    int deletedLines = 0;
+    int write = GRID_VERTICAL_SIZE - 2;
+
+    for (int j = GRID_VERTICAL_SIZE - 2; j >= 0; j--)
+    {
+        if (board->fading[j] & BOARD_INTERIOR_MASK)
+        {
+            deletedLines++;
+            continue;
+        }
+
+        board->full[write] = board->full[j];
+        board->moving[write] = board->moving[j];
+        board->fading[write] = board->fading[j];
+        board->colorLow[write] = board->colorLow[j];
+        board->colorHigh[write] = board->colorHigh[j];
+        write--;
+    }
+
+    for (; write >= 0; write--)
+    {
+        board->full[write] = 0;
+        board->moving[write] = 0;
+        board->fading[write] = 0;
+        board->colorLow[write] = 0;
+        board->colorHigh[write] = 0;
+    }
+
+    return deletedLines;
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+static inline uint16_t GetBlockRow(int y)
+{
+    return (y == GRID_VERTICAL_SIZE - 1)? BOARD_ROW_MASK : BOARD_WALL_MASK;
+}
+
+static inline uint16_t GetOccupiedRow(const Board *board, int y)
+{
+    return board->full[y] | board->moving[y] | board->fading[y] | GetBlockRow(y);
+}
+
+// Mask of the cells in row y whose 2-bit color equals color
+static inline uint16_t GetColorRow(const Board *board, int y, BarrelColor color)
+{
+    uint16_t low = (color & 1)? board->colorLow[y] : (uint16_t)~board->colorLow[y];
+    uint16_t high = (color & 2)? board->colorHigh[y] : (uint16_t)~board->colorHigh[y];
+
+    return low & high;
+}
+
+static inline bool IsEmpty(const Board *board, int x, int y)
+{
+    return ((GetOccupiedRow(board, y) >> x) & 1) == 0;
+}
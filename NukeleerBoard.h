@@ -0,0 +1,52 @@
+#ifndef NUKELEER_BOARD_H
+#define NUKELEER_BOARD_H
+
+#include "NukeleerCore.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+// Bit i of a row mask is column i of the grid, so rows must fit in 16 bits
+#define BOARD_ROW_MASK          ((uint16_t)((1u << GRID_HORIZONTAL_SIZE) - 1))
+#define BOARD_WALL_MASK         ((uint16_t)(1u | (1u << (GRID_HORIZONTAL_SIZE - 1))))
+#define BOARD_INTERIOR_MASK     ((uint16_t)(BOARD_ROW_MASK & ~BOARD_WALL_MASK))
+
+_Static_assert(GRID_HORIZONTAL_SIZE <= 16, "bitboard rows are 16-bit masks");
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// Bitboard alternative to the GridSquare matrix: one row mask per occupancy state
+// plus two color planes holding the 2-bit BarrelColor of each cell. BLOCK cells
+// never change, so they are derived from the walls instead of being stored.
+// Cells that are not FULL keep whatever color bits they had, like gridColors.
+typedef struct Board {
+    uint16_t full[GRID_VERTICAL_SIZE];
+    uint16_t moving[GRID_VERTICAL_SIZE];
+    uint16_t fading[GRID_VERTICAL_SIZE];
+    uint16_t colorLow[GRID_VERTICAL_SIZE];      // Bit 0 of the BarrelColor
+    uint16_t colorHigh[GRID_VERTICAL_SIZE];     // Bit 1 of the BarrelColor
+} Board;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+// Grids of the default size only, laid out as in GameContext (see GRID_CELL())
+void BoardFromGrid(Board *board, const GridSquare *grid, const BarrelColor *colors);
+void BoardToGrid(const Board *board, GridSquare *grid, BarrelColor *colors);
+
+GridSquare BoardGetCell(const Board *board, int x, int y);
+BarrelColor BoardGetColor(const Board *board, int x, int y);
+void BoardSetCell(Board *board, int x, int y, GridSquare square);
+void BoardSetColor(Board *board, int x, int y, BarrelColor color);
+
+bool BoardCheckDetection(const Board *board);                       // Moving cell resting on FULL or BLOCK
+bool BoardCheckCompletion(Board *board);                            // Mark full rows as FADING
+bool BoardHasSameColorNeighbour(const Board *board, int x, int y, BarrelColor color);
+int BoardLockPiece(Board *board, int *x, int *y, BarrelColor color); // Lock and slide, returns slide length
+int BoardDeleteCompleteLines(Board *board);                         // Remove FADING rows, returns count
+
+#endif // NUKELEER_BOARD_H
@@ -0,0 +1,273 @@
+#include "NukeleerBroadcast.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define BROADCAST_MAGIC         0x42424b4eu     // "NKBB"
+#define RECORD_HEADER_SIZE      4               // Record size, then the record
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// Offsets count bytes written since the ring was created and only grow; the byte at
+// offset o lives at data[o % capacity]. Written like a seqlock: the writer moves
+// reserved past a record before overwriting anything, and head once it is complete.
+struct BroadcastRing {
+    _Atomic uint32_t magic;             // Set once the rest is initialized
+    uint32_t capacity;
+    _Atomic uint64_t reserved;          // End of the record being written
+    _Atomic uint64_t head;              // End of the last complete record
+    _Atomic uint64_t keyframe;          // Start of the latest keyframe record
+    unsigned char data[];
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static BroadcastRing *MapRing(const char *name, bool create, void **mapping);
+static void UnmapRing(BroadcastRing *ring, void *mapping);
+static void CopyToRing(BroadcastRing *ring, uint64_t offset, const void *source, int size);
+static void CopyFromRing(const BroadcastRing *ring, uint64_t offset, void *destination, int size);
+
+//--------------------------------------------------------------------------------------
+// Broadcast Module Functions Definition
+//--------------------------------------------------------------------------------------
+bool OpenBroadcast(Broadcaster *broadcaster, const char *name)
+{
+    memset(broadcaster, 0, sizeof(Broadcaster));
+    snprintf(broadcaster->name, sizeof(broadcaster->name), "%s", name);
+
+    broadcaster->ring = MapRing(name, true, &broadcaster->mapping);
+    if (broadcaster->ring == NULL) return false;
+
+    BroadcastRing *ring = broadcaster->ring;
+
+    // A ring left behind by a writer that crashed is picked up where it stopped,
+    // so readers still attached to it carry on
+    if ((atomic_load(&ring->magic) != BROADCAST_MAGIC) || (ring->capacity != BROADCAST_RING_SIZE))
+    {
+        ring->capacity = BROADCAST_RING_SIZE;
+        atomic_store(&ring->reserved, 0);
+        atomic_store(&ring->head, 0);
+        atomic_store(&ring->keyframe, 0);
+        atomic_store_explicit(&ring->magic, BROADCAST_MAGIC, memory_order_release);
+    }
+
+    return true;
+}
+
+bool PublishBroadcast(Broadcaster *broadcaster, const unsigned char *data, int size, bool keyframe)
+{
+    BroadcastRing *ring = broadcaster->ring;
+
+    if ((ring == NULL) || (size <= 0) || (size > MAX_BROADCAST_RECORD)) return false;
+
+    uint32_t recordSize = (uint32_t)size;
+    uint64_t start = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t end = start + RECORD_HEADER_SIZE + recordSize;
+
+    atomic_store_explicit(&ring->reserved, end, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    CopyToRing(ring, start, &recordSize, RECORD_HEADER_SIZE);
+    CopyToRing(ring, start + RECORD_HEADER_SIZE, data, size);
+
+    atomic_store_explicit(&ring->head, end, memory_order_release);
+    if (keyframe) atomic_store_explicit(&ring->keyframe, start, memory_order_release);
+
+    broadcaster->records++;
+    broadcaster->bytes += size;
+
+    return true;
+}
+
+void CloseBroadcast(Broadcaster *broadcaster)
+{
+    if (broadcaster->ring == NULL) return;
+
+    UnmapRing(broadcaster->ring, broadcaster->mapping);
+
+#if !defined(_WIN32)
+    // Readers keep their mapping until they reopen; the name is free for the next writer
+    char path[80] = { 0 };
+    snprintf(path, sizeof(path), "/%s", broadcaster->name);
+    shm_unlink(path);
+#endif
+
+    broadcaster->ring = NULL;
+    broadcaster->mapping = NULL;
+}
+
+bool OpenSpectator(Spectator *spectator, const char *name)
+{
+    memset(spectator, 0, sizeof(Spectator));
+
+    spectator->ring = MapRing(name, false, &spectator->mapping);
+    if (spectator->ring == NULL) return false;
+
+    if ((atomic_load_explicit(&spectator->ring->magic, memory_order_acquire) != BROADCAST_MAGIC) ||
+        (spectator->ring->capacity != BROADCAST_RING_SIZE))
+    {
+        CloseSpectator(spectator);
+        return false;
+    }
+
+    // Start at the latest keyframe, everything after it can be decoded
+    spectator->offset = atomic_load_explicit(&spectator->ring->keyframe, memory_order_acquire);
+
+    return true;
+}
+
+int ReadSpectator(Spectator *spectator, const unsigned char **data)
+{
+    BroadcastRing *ring = spectator->ring;
+
+    if (ring == NULL) return 0;
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (spectator->offset >= head) return 0;
+
+    // Lapped: what this reader was up to is gone
+    if (head - spectator->offset > ring->capacity)
+    {
+        spectator->offset = atomic_load_explicit(&ring->keyframe, memory_order_acquire);
+        spectator->skipped++;
+    }
+
+    uint32_t size = 0;
+    CopyFromRing(ring, spectator->offset, &size, RECORD_HEADER_SIZE);
+
+    if ((size > MAX_BROADCAST_RECORD) || (spectator->offset + RECORD_HEADER_SIZE + size > head)) size = 0;
+    else
+    {
+        if ((int)size > spectator->recordCapacity)
+        {
+            unsigned char *record = realloc(spectator->record, size);
+            if (record == NULL) return 0;
+
+            spectator->record = record;
+            spectator->recordCapacity = (int)size;
+        }
+
+        CopyFromRing(ring, spectator->offset + RECORD_HEADER_SIZE, spectator->record, (int)size);
+    }
+
+    // The writer may have overwritten the record while it was copied
+    atomic_thread_fence(memory_order_acquire);
+    uint64_t reserved = atomic_load_explicit(&ring->reserved, memory_order_relaxed);
+
+    if ((size == 0) || (reserved - spectator->offset > ring->capacity))
+    {
+        spectator->offset = atomic_load_explicit(&ring->keyframe, memory_order_acquire);
+        spectator->skipped++;
+        return 0;
+    }
+
+    spectator->offset += RECORD_HEADER_SIZE + size;
+    *data = spectator->record;
+
+    return (int)size;
+}
+
+void CloseSpectator(Spectator *spectator)
+{
+    if (spectator->ring != NULL) UnmapRing(spectator->ring, spectator->mapping);
+
+    free(spectator->record);
+    memset(spectator, 0, sizeof(Spectator));
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+static BroadcastRing *MapRing(const char *name, bool create, void **mapping)
+{
+    size_t size = sizeof(BroadcastRing) + BROADCAST_RING_SIZE;
+    void *memory = NULL;
+
+#if defined(_WIN32)
+    char path[80] = { 0 };
+    snprintf(path, sizeof(path), "Local\\%s", name);
+
+    HANDLE handle = create? CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)size, path) :
+                            OpenFileMappingA(FILE_MAP_READ, FALSE, path);
+    if (handle == NULL) return NULL;
+
+    memory = MapViewOfFile(handle, create? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+
+    if (memory == NULL)
+    {
+        CloseHandle(handle);
+        return NULL;
+    }
+
+    *mapping = handle;
+#else
+    char path[80] = { 0 };
+    snprintf(path, sizeof(path), "/%s", name);
+
+    int file = shm_open(path, create? (O_RDWR | O_CREAT) : O_RDONLY, 0600);
+    if (file < 0) return NULL;
+
+    struct stat info;
+
+    if ((fstat(file, &info) != 0) || (create && ((size_t)info.st_size != size) && (ftruncate(file, (off_t)size) != 0)) ||
+        (!create && ((size_t)info.st_size < size)))
+    {
+        close(file);
+        return NULL;
+    }
+
+    memory = mmap(NULL, size, create? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+
+    if (memory == MAP_FAILED) return NULL;
+
+    *mapping = NULL;
+#endif
+
+    return (BroadcastRing *)memory;
+}
+
+static void UnmapRing(BroadcastRing *ring, void *mapping)
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(ring);
+    CloseHandle((HANDLE)mapping);
+#else
+    (void)mapping;
+    munmap(ring, sizeof(BroadcastRing) + BROADCAST_RING_SIZE);
+#endif
+}
+
+static void CopyToRing(BroadcastRing *ring, uint64_t offset, const void *source, int size)
+{
+    uint32_t start = (uint32_t)(offset & (ring->capacity - 1));
+    int first = ((uint32_t)size <= ring->capacity - start)? size : (int)(ring->capacity - start);
+
+    memcpy(ring->data + start, source, first);
+    memcpy(ring->data, (const unsigned char *)source + first, size - first);
+}
+
+static void CopyFromRing(const BroadcastRing *ring, uint64_t offset, void *destination, int size)
+{
+    uint32_t start = (uint32_t)(offset & (ring->capacity - 1));
+    int first = ((uint32_t)size <= ring->capacity - start)? size : (int)(ring->capacity - start);
+
+    memcpy(destination, ring->data + start, first);
+    memcpy((unsigned char *)destination + first, ring->data, size - first);
+}
@@ -0,0 +1,52 @@
+#ifndef NUKELEER_BROADCAST_H
+#define NUKELEER_BROADCAST_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define BROADCAST_NAME          "nukeleer"
+#define BROADCAST_RING_SIZE     (8 << 20)   // Bytes of records, a power of two
+#define MAX_BROADCAST_RECORD    (BROADCAST_RING_SIZE/4)
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// Shared memory ring with one writer and any number of readers on the same machine.
+// The writer never waits: a reader that falls a whole ring behind jumps to the latest
+// record the writer marked as a keyframe, and a record overwritten while being copied
+// is detected and dropped the same way.
+typedef struct BroadcastRing BroadcastRing;
+
+typedef struct Broadcaster {
+    BroadcastRing *ring;
+    void *mapping;              // File mapping handle on Windows
+    char name[64];
+    long long records;
+    long long bytes;
+} Broadcaster;
+
+typedef struct Spectator {
+    BroadcastRing *ring;
+    void *mapping;
+    uint64_t offset;            // Next record to read
+    unsigned char *record;      // Copy of the last record read
+    int recordCapacity;
+    int skipped;                // Times the writer lapped this reader
+} Spectator;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+bool OpenBroadcast(Broadcaster *broadcaster, const char *name);     // Creates the ring, readers may already be waiting
+bool PublishBroadcast(Broadcaster *broadcaster, const unsigned char *data, int size, bool keyframe);
+void CloseBroadcast(Broadcaster *broadcaster);
+
+bool OpenSpectator(Spectator *spectator, const char *name);         // False until a writer opened the ring
+int ReadSpectator(Spectator *spectator, const unsigned char **data);    // Size of the next record, 0 when caught up
+void CloseSpectator(Spectator *spectator);
+
+#endif // NUKELEER_BROADCAST_H
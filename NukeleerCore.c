@@ -0,0 +1,615 @@
+#include "NukeleerCore.h"
+#include "NukeleerCoreInternal.h"
+#include "NukeleerProfile.h"
+#include "NukeleerTelemetry.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static bool ReserveGrid(GameContext *ctx, int width, int height);
+static void RaiseGarbage(GameContext *ctx);
+static bool Createpiece(GameContext *ctx);
+static bool ResolveTurnMovement(GameContext *ctx);
+static void EndGame(GameContext *ctx, TelemetryCause cause);
+static void RecordEvent(GameContext *ctx, TelemetryType type, int x, int y, int extra, int value);
+
+//--------------------------------------------------------------------------------------
+// Core Module Functions Definition
+//--------------------------------------------------------------------------------------
+
+// Initialize game variables
+bool InitCore(GameContext *ctx, unsigned int seed)
+{
+    return InitCoreWithRules(ctx, seed, GetDefaultRules());
+}
+
+bool InitCoreWithRules(GameContext *ctx, unsigned int seed, RuleSet rules)
+{
+    if (rules.gridWidth < MIN_GRID_HORIZONTAL_SIZE) rules.gridWidth = MIN_GRID_HORIZONTAL_SIZE;
+    if (rules.gridWidth > MAX_GRID_HORIZONTAL_SIZE) rules.gridWidth = MAX_GRID_HORIZONTAL_SIZE;
+    if (rules.gridHeight < MIN_GRID_VERTICAL_SIZE) rules.gridHeight = MIN_GRID_VERTICAL_SIZE;
+    if (rules.gridHeight > MAX_GRID_VERTICAL_SIZE) rules.gridHeight = MAX_GRID_VERTICAL_SIZE;
+
+    if (!ReserveGrid(ctx, rules.gridWidth, rules.gridHeight)) return false;
+
+    ctx->rules = rules;
+
+    // Initialize game statistics
+    ctx->level = 1;
+    ctx->lines = 0;
+    ctx->score = 0;
+
+    ctx->piecePositionX = 0;
+    ctx->piecePositionY = 0;
+    ctx->pieceCellCount = 0;
+
+    ctx->garbageRows = 0;
+    ctx->garbageSeed = 0;
+
+    ctx->pieceActive = false;
+    ctx->detection = false;
+    ctx->lineToDelete = false;
+    ctx->gameOver = false;
+    ctx->gameOverTriggered = false;
+    ctx->gameOverTimer = GAME_OVER_DELAY;
+
+    // Counters
+    ctx->gravityMovementCounter = 0;
+    ctx->lateralMovementCounter = 0;
+    ctx->turnMovementCounter = 0;
+    ctx->fastFallMovementCounter = 0;
+
+    ctx->fadeLineCounter = 0;
+    ctx->gravitySpeed = rules.startGravity;
+
+    ctx->previousInput = 0;
+    ctx->tick = 0;
+
+    // Independent, reproducible piece sequence for this game
+    InitPieceStream(&ctx->pieces, seed);
+
+    RecordEvent(ctx, TELEMETRY_GAME_START, ctx->width, ctx->height, 0, (int)seed);
+
+    // Initialize grid matrices
+    for (int j = 0; j < ctx->height; j++)
+    {
+        for (int i = 0; i < ctx->width; i++)
+        {
+            if ((j == ctx->height - 1) || (i == 0) || (i == ctx->width - 1)) GRID_CELL(ctx, i, j) = BLOCK;
+            else GRID_CELL(ctx, i, j) = EMPTY;
+
+            GRID_COLOR(ctx, i, j) = BARREL_RED;
+        }
+
+        ctx->rowFill[j] = 0;
+        ctx->rowDirty[j] = false;
+    }
+
+    ctx->dirtyRowCount = 0;
+    ctx->stackTop = ctx->height - 1;
+    ctx->lowestFadingRow = -1;
+
+    return true;
+}
+
+// Deep copy; dst keeps its own matrices, grown to fit src if needed
+bool CopyCore(GameContext *dst, const GameContext *src)
+{
+    if (!ReserveGrid(dst, src->width, src->height)) return false;
+
+    GameContext storage = *dst;
+    int cells = src->width*src->height;
+
+    *dst = *src;
+    dst->grid = storage.grid;
+    dst->gridColors = storage.gridColors;
+    dst->rowFill = storage.rowFill;
+    dst->dirtyRows = storage.dirtyRows;
+    dst->rowDirty = storage.rowDirty;
+    dst->cellCapacity = storage.cellCapacity;
+    dst->rowCapacity = storage.rowCapacity;
+    dst->telemetry = storage.telemetry;
+
+    memcpy(dst->grid, src->grid, cells*sizeof(GridSquare));
+    memcpy(dst->gridColors, src->gridColors, cells*sizeof(BarrelColor));
+    memcpy(dst->rowFill, src->rowFill, src->height*sizeof(int));
+    memcpy(dst->dirtyRows, src->dirtyRows, src->dirtyRowCount*sizeof(int));
+    memcpy(dst->rowDirty, src->rowDirty, src->height*sizeof(bool));
+
+    return true;
+}
+
+void UnloadCore(GameContext *ctx)
+{
+    free(ctx->grid);
+    free(ctx->gridColors);
+    free(ctx->rowFill);
+    free(ctx->dirtyRows);
+    free(ctx->rowDirty);
+
+    memset(ctx, 0, sizeof(GameContext));
+}
+
+// The constants the game shipped with
+RuleSet GetDefaultRules(void)
+{
+    RuleSet rules = { 0 };
+
+    rules.gridWidth = GRID_HORIZONTAL_SIZE;
+    rules.gridHeight = GRID_VERTICAL_SIZE;
+    rules.lineScoreBase = 56;
+    rules.lineScorePerLine = 98;
+    rules.lockScoreBase = 1;
+    rules.lockScorePivot = 19;
+    rules.lockScoreDivisor = 4;
+    rules.sameColorPenalty = 200;
+    rules.startGravity = 15;
+    rules.gravityDecay = 1;
+    rules.minGravity = 4;
+
+    return rules;
+}
+
+// Update game rules (one tick)
+void UpdateCore(GameContext *ctx, unsigned int input)
+{
+    unsigned int pressed = input & ~ctx->previousInput;
+    ctx->previousInput = input;
+    ctx->tick++;
+
+    if (ctx->gameOver) return;
+
+    if (ctx->gameOverTriggered)
+    {
+        ctx->gameOverTimer--;
+        if (ctx->gameOverTimer <= 0) EndGame(ctx, TELEMETRY_CAUSE_SAME_COLOR);
+        return;
+    }
+
+    if (!ctx->lineToDelete)
+    {
+        if (!ctx->pieceActive)
+        {
+            ctx->pieceActive = Createpiece(ctx);
+            ctx->fastFallMovementCounter = 0;
+        }
+        else
+        {
+            ctx->fastFallMovementCounter++;
+            ctx->gravityMovementCounter++;
+            ctx->lateralMovementCounter++;
+            ctx->turnMovementCounter++;
+
+            if (pressed & (INPUT_LEFT | INPUT_RIGHT)) ctx->lateralMovementCounter = LATERAL_SPEED;
+            if (pressed & INPUT_UP) ctx->turnMovementCounter = TURNING_SPEED;
+
+            if ((input & INPUT_DOWN) && (ctx->fastFallMovementCounter >= FAST_FALL_AWAIT_COUNTER))
+            {
+                ctx->gravityMovementCounter += ctx->gravitySpeed;
+            }
+
+            if (ctx->gravityMovementCounter >= ctx->gravitySpeed)
+            {
+                PROFILE_BEGIN("CheckDetection");
+                CheckDetection(ctx, &ctx->detection);
+                PROFILE_END();
+
+                PROFILE_BEGIN("ResolveFalling");
+                ResolveFallingMovement(ctx, &ctx->detection, &ctx->pieceActive);
+                PROFILE_END();
+
+                // Rows only fill up when a piece locks
+                if (!ctx->pieceActive)
+                {
+                    PROFILE_BEGIN("CheckCompletion");
+                    CheckCompletion(ctx, &ctx->lineToDelete);
+                    PROFILE_END();
+                }
+
+                ctx->gravityMovementCounter = 0;
+            }
+
+            if (ctx->lateralMovementCounter >= LATERAL_SPEED)
+            {
+                if (!ResolveLateralMovement(ctx, input)) ctx->lateralMovementCounter = 0;
+            }
+
+            if (ctx->turnMovementCounter >= TURNING_SPEED)
+            {
+                if (ResolveTurnMovement(ctx)) ctx->turnMovementCounter = 0;
+            }
+        }
+
+        // Any settled barrel in the two top rows ends the game
+        if ((ctx->rowFill[0] > 0) || (ctx->rowFill[1] > 0)) EndGame(ctx, TELEMETRY_CAUSE_TOPOUT);
+    }
+    else
+    {
+        ctx->fadeLineCounter++;
+
+        if (ctx->fadeLineCounter >= FADING_TIME)
+        {
+            PROFILE_BEGIN("DeleteLines");
+            int deletedLines = DeleteCompleteLines(ctx);
+            PROFILE_END();
+
+            ctx->fadeLineCounter = 0;
+            ctx->lineToDelete = false;
+            ctx->lines += deletedLines;
+            ctx->score += (ctx->rules.lineScoreBase + (ctx->lines * ctx->rules.lineScorePerLine));
+
+            RecordEvent(ctx, TELEMETRY_LINE_CLEAR, deletedLines, ctx->lines, 0, ctx->rules.lineScoreBase + ctx->lines*ctx->rules.lineScorePerLine);
+        }
+    }
+}
+
+// Both sides of a match call this before the same tick, so the game stays deterministic
+void QueueGarbage(GameContext *ctx, int rows, unsigned int seed)
+{
+    if (rows <= 0) return;
+
+    ctx->garbageRows += rows;
+    ctx->garbageSeed = ctx->garbageSeed*2654435761u + seed;
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+
+// Grow the matrices and row tables to fit; a smaller board reuses what is there
+static bool ReserveGrid(GameContext *ctx, int width, int height)
+{
+    int cells = width*height;
+
+    if (cells > ctx->cellCapacity)
+    {
+        GridSquare *grid = realloc(ctx->grid, cells*sizeof(GridSquare));
+        if (grid == NULL) return false;
+        ctx->grid = grid;
+
+        BarrelColor *gridColors = realloc(ctx->gridColors, cells*sizeof(BarrelColor));
+        if (gridColors == NULL) return false;
+        ctx->gridColors = gridColors;
+
+        ctx->cellCapacity = cells;
+    }
+
+    if (height > ctx->rowCapacity)
+    {
+        int *rowFill = realloc(ctx->rowFill, height*sizeof(int));
+        if (rowFill == NULL) return false;
+        ctx->rowFill = rowFill;
+
+        int *dirtyRows = realloc(ctx->dirtyRows, height*sizeof(int));
+        if (dirtyRows == NULL) return false;
+        ctx->dirtyRows = dirtyRows;
+
+        bool *rowDirty = realloc(ctx->rowDirty, height*sizeof(bool));
+        if (rowDirty == NULL) return false;
+        ctx->rowDirty = rowDirty;
+
+        ctx->rowCapacity = height;
+    }
+
+    ctx->width = width;
+    ctx->height = height;
+
+    return true;
+}
+
+// Every grid write that may add or remove a FULL cell goes through here, so the row
+// counts, the dirty rows and the stack top stay exact without rescanning
+void SetCell(GameContext *ctx, int i, int j, GridSquare square)
+{
+    GridSquare *cell = &GRID_CELL(ctx, i, j);
+
+    if ((*cell == FULL) && (square != FULL)) ctx->rowFill[j]--;
+    else if ((*cell != FULL) && (square == FULL))
+    {
+        ctx->rowFill[j]++;
+
+        if (!ctx->rowDirty[j])
+        {
+            ctx->rowDirty[j] = true;
+            ctx->dirtyRows[ctx->dirtyRowCount++] = j;
+        }
+
+        if (j < ctx->stackTop) ctx->stackTop = j;
+    }
+
+    *cell = square;
+}
+
+// Push the stack up and fill the bottom rows with barrels, one hole per row. Colors follow
+// the diagonals, so no two garbage barrels of a color touch. Runs between pieces, when no
+// rows are waiting for a completion check.
+static void RaiseGarbage(GameContext *ctx)
+{
+    int rows = ctx->garbageRows;
+    int floor = ctx->height - 1;
+
+    if (rows > floor) rows = floor;
+
+    // Whatever is pushed past the top row is lost, and with it the game
+    int first = (ctx->stackTop > rows)? ctx->stackTop : rows;
+
+    for (int j = ctx->stackTop; j < first; j++)
+    {
+        if (ctx->rowFill[j] > 0) EndGame(ctx, TELEMETRY_CAUSE_GARBAGE);
+    }
+
+    if (first < floor)
+    {
+        memmove(&GRID_CELL(ctx, 0, first - rows), &GRID_CELL(ctx, 0, first), (floor - first)*ctx->width*sizeof(GridSquare));
+        memmove(&GRID_COLOR(ctx, 0, first - rows), &GRID_COLOR(ctx, 0, first), (floor - first)*ctx->width*sizeof(BarrelColor));
+        memmove(&ctx->rowFill[first - rows], &ctx->rowFill[first], (floor - first)*sizeof(int));
+    }
+
+    unsigned int state = ctx->garbageSeed;
+
+    for (int j = floor - rows; j < floor; j++)
+    {
+        state = state*1103515245u + 12345u;
+        int hole = 1 + (int)((state >> 16)%(unsigned int)(ctx->width - 2));
+
+        for (int i = 1; i < ctx->width - 1; i++)
+        {
+            GRID_CELL(ctx, i, j) = (i == hole)? EMPTY : FULL;
+            GRID_COLOR(ctx, i, j) = (BarrelColor)((i + j)%3);
+        }
+
+        ctx->rowFill[j] = ctx->width - 3;
+    }
+
+    ctx->stackTop = (ctx->stackTop > rows)? ctx->stackTop - rows : 0;
+    ctx->garbageSeed = state;
+    ctx->garbageRows = 0;
+}
+
+static bool Createpiece(GameContext *ctx)
+{
+    if (ctx->garbageRows > 0) RaiseGarbage(ctx);
+
+    ctx->piecePositionX = (int)((ctx->width - 4)/2);
+    ctx->piecePositionY = -4;
+
+    // The incoming piece becomes the actual piece, keeping the color it was generated with
+    ctx->piece = NextPiece(&ctx->pieces);
+
+    // A barrel is a single cell, placed in the spawn area below the origin
+    ctx->pieceCells[0] = (PieceCell){ ctx->piece.x, ctx->piece.y - ctx->piecePositionY };
+    ctx->pieceCellCount = 1;
+
+    // The piece replaces whatever was in its spawn cells
+    for (int k = 0; k < ctx->pieceCellCount; k++)
+    {
+        SetCell(ctx, ctx->piecePositionX + ctx->pieceCells[k].x, ctx->piecePositionY + ctx->pieceCells[k].y, EMPTY);
+    }
+
+    return true;
+}
+
+void ResolveFallingMovement(GameContext *ctx, bool *detection, bool *pieceActive)
+{
+    // If we finished moving this piece, we write it to the grid and stop it
+    if (*detection)
+    {
+        for (int k = 0; k < ctx->pieceCellCount; k++)
+        {
+            int i = ctx->piecePositionX + ctx->pieceCells[k].x;
+            int j = ctx->piecePositionY + ctx->pieceCells[k].y;
+
+            int lockScore = (ctx->rules.lockScoreBase + (abs(ctx->rules.lockScorePivot - ((2*ctx->lines) + 1)))/ctx->rules.lockScoreDivisor);
+
+            SetCell(ctx, i, j, FULL);
+            ctx->score += lockScore;
+            RecordEvent(ctx, TELEMETRY_LOCK, i, j, ctx->piece.color, lockScore);
+            *detection = false;
+            *pieceActive = false;
+            GRID_COLOR(ctx, i, j) = ctx->piece.color;
+
+            // Variables to check if movement is possible
+            bool canMoveDownLeft = false;
+            bool canMoveDownRight = false;
+
+            // Check if the block can move diagonally down-left
+            if (i < ctx->width - 1 && j < ctx->height - 1 && GRID_CELL(ctx, i-1, j+1) == EMPTY)
+            {
+                canMoveDownLeft = true;
+            }
+
+            // Check if the block can move diagonally down-right
+            if (i < ctx->width - 1 && j < ctx->height - 1 && GRID_CELL(ctx, i+1, j+1) == EMPTY)
+            {
+                canMoveDownRight = true;
+            }
+
+            // Move Down-Left continuously
+            while (canMoveDownLeft)
+            {
+                SetCell(ctx, i, j, EMPTY);
+                SetCell(ctx, i-1, j+1, FULL);
+                GRID_COLOR(ctx, i-1, j+1) = ctx->piece.color;
+
+                j++;
+                i--;
+                ctx->score++;
+
+                if (j >= ctx->height - 1 || i <= 0 || GRID_CELL(ctx, i-1, j+1) != EMPTY)
+                    break;
+            }
+
+            // Move Down-Right continuously
+            while (!canMoveDownLeft && canMoveDownRight)
+            {
+                SetCell(ctx, i, j, EMPTY);
+                SetCell(ctx, i+1, j+1, FULL);
+                GRID_COLOR(ctx, i+1, j+1) = ctx->piece.color;
+
+                j++;
+                i++;
+                ctx->score++;
+
+                if (j >= ctx->height - 1 || i >= ctx->width - 1 || GRID_CELL(ctx, i+1, j+1) != EMPTY)
+                    break;
+            }
+
+            int slid = j - (ctx->piecePositionY + ctx->pieceCells[k].y);
+            if (slid > 0) RecordEvent(ctx, TELEMETRY_SLIDE, i, j, canMoveDownLeft? -1 : 1, slid);
+
+            // Game Over Condition: Check for adjacent same-color blocks
+            if ((i > 0 && GRID_CELL(ctx, i-1, j) == FULL && GRID_COLOR(ctx, i-1, j) == ctx->piece.color) ||
+                (i < ctx->width - 1 && GRID_CELL(ctx, i+1, j) == FULL && GRID_COLOR(ctx, i+1, j) == ctx->piece.color) ||
+                (j > 0 && GRID_CELL(ctx, i, j-1) == FULL && GRID_COLOR(ctx, i, j-1) == ctx->piece.color) ||
+                (j < ctx->height - 1 && GRID_CELL(ctx, i, j+1) == FULL && GRID_COLOR(ctx, i, j+1) == ctx->piece.color))
+            {
+                if (!ctx->gameOverTriggered)
+                {
+                    ctx->gameOverTriggered = true;
+                    ctx->score -= ctx->rules.sameColorPenalty;
+                    ctx->gameOverTimer = GAME_OVER_DELAY;
+                    RecordEvent(ctx, TELEMETRY_SAME_COLOR, i, j, ctx->piece.color, ctx->rules.sameColorPenalty);
+                }
+            }
+        }
+
+        ctx->pieceCellCount = 0;
+    }
+    else ctx->piecePositionY++;
+}
+
+bool ResolveLateralMovement(GameContext *ctx, unsigned int input)
+{
+    bool collision = false;
+    int direction = 0;
+
+    if (input & INPUT_LEFT) direction = -1;         // Move left
+    else if (input & INPUT_RIGHT) direction = 1;    // Move right
+    else return false;
+
+    // Check if we are touching a wall or we have a full square at the side
+    for (int k = 0; k < ctx->pieceCellCount; k++)
+    {
+        int i = ctx->piecePositionX + ctx->pieceCells[k].x + direction;
+        int j = ctx->piecePositionY + ctx->pieceCells[k].y;
+
+        if ((i <= 0) || (i >= ctx->width - 1) || (GRID_CELL(ctx, i, j) == FULL)) collision = true;
+    }
+
+    // If able, move
+    if (!collision) ctx->piecePositionX += direction;
+
+    return collision;
+}
+
+static bool ResolveTurnMovement(GameContext *ctx)
+{
+    // Input for turning the piece
+    (void)ctx;
+
+    return false;
+}
+
+void CheckDetection(GameContext *ctx, bool *detection)
+{
+    for (int k = 0; k < ctx->pieceCellCount; k++)
+    {
+        int i = ctx->piecePositionX + ctx->pieceCells[k].x;
+        int j = ctx->piecePositionY + ctx->pieceCells[k].y;
+
+        if ((GRID_CELL(ctx, i, j+1) == FULL) || (GRID_CELL(ctx, i, j+1) == BLOCK)) *detection = true;
+    }
+}
+
+// Only rows that gained a FULL cell since the last check can have been completed
+void CheckCompletion(GameContext *ctx, bool *lineToDelete)
+{
+    for (int k = 0; k < ctx->dirtyRowCount; k++)
+    {
+        int j = ctx->dirtyRows[k];
+
+        ctx->rowDirty[j] = false;
+
+        if (ctx->rowFill[j] == ctx->width - 2)
+        {
+            *lineToDelete = true;
+
+            // Mark the completed line, it no longer counts as filled
+            for (int i = 1; i < ctx->width - 1; i++) GRID_CELL(ctx, i, j) = FADING;
+
+            ctx->rowFill[j] = 0;
+            if (j > ctx->lowestFadingRow) ctx->lowestFadingRow = j;
+        }
+    }
+
+    ctx->dirtyRowCount = 0;
+}
+
+int DeleteCompleteLines(GameContext *ctx)
+{
+    int deletedLines = 0;
+    int write = ctx->lowestFadingRow;
+
+    // Single pass from the lowest completed row up to the top of the stack: kept rows are
+    // copied down over the completed ones, cells, colors and fill counts together. Rows
+    // below are untouched and rows above the stack are empty, so neither is visited.
+    for (int j = ctx->lowestFadingRow; j >= ctx->stackTop; j--)
+    {
+        if (GRID_CELL(ctx, 1, j) == FADING)
+        {
+            deletedLines++;
+            continue;
+        }
+
+        if (write != j)
+        {
+            memcpy(&GRID_CELL(ctx, 0, write), &GRID_CELL(ctx, 0, j), ctx->width*sizeof(GridSquare));
+            memcpy(&GRID_COLOR(ctx, 0, write), &GRID_COLOR(ctx, 0, j), ctx->width*sizeof(BarrelColor));
+            ctx->rowFill[write] = ctx->rowFill[j];
+        }
+
+        write--;
+    }
+
+    // Rows uncovered at the top of the stack
+    for (; write >= ctx->stackTop; write--)
+    {
+        for (int i = 1; i < ctx->width - 1; i++)
+        {
+            GRID_CELL(ctx, i, write) = EMPTY;
+            GRID_COLOR(ctx, i, write) = BARREL_RED;
+        }
+
+        ctx->rowFill[write] = 0;
+    }
+
+    ctx->stackTop += deletedLines;
+    ctx->lowestFadingRow = -1;
+
+    if (deletedLines > 0)
+    {
+        ctx->gravitySpeed -= deletedLines*ctx->rules.gravityDecay;
+        if (ctx->gravitySpeed < ctx->rules.minGravity) ctx->gravitySpeed = ctx->rules.minGravity;
+    }
+
+    return deletedLines;
+}
+
+static void EndGame(GameContext *ctx, TelemetryCause cause)
+{
+    if (ctx->gameOver) return;
+
+    ctx->gameOver = true;
+    RecordEvent(ctx, TELEMETRY_GAME_OVER, ctx->lines, 0, cause, ctx->score);
+}
+
+// Costs a branch when no ring is attached, as in the headless tools
+static void RecordEvent(GameContext *ctx, TelemetryType type, int x, int y, int extra, int value)
+{
+    if (ctx->telemetry == NULL) return;
+
+    EmitTelemetry(ctx->telemetry, (TelemetryEvent){ ctx->tick, (uint16_t)type, (int16_t)x, (int16_t)y, (int16_t)extra, value });
+}
@@ -0,0 +1,142 @@
+#ifndef NUKELEER_CORE_H
+#define NUKELEER_CORE_H
+
+#include "NukeleerPieces.h"
+
+#include <stdbool.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define GRID_HORIZONTAL_SIZE    12          // Default board, walls and floor included
+#define GRID_VERTICAL_SIZE      20
+#define MIN_GRID_HORIZONTAL_SIZE 6          // Spawn area plus the walls
+#define MIN_GRID_VERTICAL_SIZE  8
+#define MAX_GRID_HORIZONTAL_SIZE 256
+#define MAX_GRID_VERTICAL_SIZE  1024
+
+#define LATERAL_SPEED           15
+#define TURNING_SPEED           12
+#define FAST_FALL_AWAIT_COUNTER 30
+
+#define MAX_PIECE_CELLS         4           // Cells an active piece may cover
+
+#define FADING_TIME             33
+#define GAME_OVER_DELAY         120
+
+// Per-tick input bitmask: one bit per held key, edges are derived by the core
+#define INPUT_LEFT              0x01
+#define INPUT_RIGHT             0x02
+#define INPUT_UP                0x04
+#define INPUT_DOWN              0x08
+
+// Grid cells are stored row by row, ctx->width cells per row
+#define GRID_CELL(ctx, x, y)    ((ctx)->grid[(y)*(ctx)->width + (x)])
+#define GRID_COLOR(ctx, x, y)   ((ctx)->gridColors[(y)*(ctx)->width + (x)])
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum GridSquare { EMPTY, MOVING, FULL, BLOCK, FADING } GridSquare;
+
+// Offset of one active piece cell from the piece origin
+typedef struct PieceCell {
+    int x;
+    int y;
+} PieceCell;
+
+// Board size, scoring and difficulty constants. Stored per game, so rule variants can be
+// played side by side; InitCore() uses GetDefaultRules()
+typedef struct RuleSet {
+    int gridWidth;              // Walls and floor included, clamped to MIN/MAX_GRID_*_SIZE
+    int gridHeight;
+    int lineScoreBase;          // Per clear: lineScoreBase + lines*lineScorePerLine
+    int lineScorePerLine;
+    int lockScoreBase;          // Per lock: lockScoreBase + abs(lockScorePivot - (2*lines + 1))/lockScoreDivisor
+    int lockScorePivot;
+    int lockScoreDivisor;
+    int sameColorPenalty;       // Taken off when a barrel touches one of its own color
+    int startGravity;           // Ticks per row at the start of a game
+    int gravityDecay;           // Ticks per row taken off for every deleted line
+    int minGravity;
+} RuleSet;
+
+// Everything one game needs to advance one tick, no window or audio involved.
+// Contexts share nothing, so any number of games can run side by side. The matrices are
+// allocated by InitCore() and kept for the next game; copy with CopyCore(), free with UnloadCore().
+typedef struct GameContext {
+    // Matrices, width*height cells each (see GRID_CELL())
+    int width;
+    int height;
+    GridSquare *grid;
+    BarrelColor *gridColors;
+
+    // Kept up to date on every change to a FULL cell, so a tick never scans the whole board
+    int *rowFill;               // FULL cells per row
+    int *dirtyRows;             // Rows that gained a FULL cell since the last completion check
+    bool *rowDirty;
+    int dirtyRowCount;
+    int stackTop;               // No FULL cell above this row
+    int lowestFadingRow;        // Bottom row marked by the last completion check
+
+    int cellCapacity;           // Allocated sizes, reused while a new game fits
+    int rowCapacity;
+
+    // Active piece and the upcoming ones
+    Piece piece;
+    PieceStream pieces;
+
+    // Active piece origin and its cells. The piece is kept off the grid (no MOVING
+    // squares) until it locks, so moving it never touches the rest of the board.
+    int piecePositionX;
+    int piecePositionY;
+    PieceCell pieceCells[MAX_PIECE_CELLS];
+    int pieceCellCount;
+
+    // Garbage rows sent by an opponent, pushed in under the stack before the next piece spawns
+    int garbageRows;
+    unsigned int garbageSeed;
+
+    // Game parameters
+    bool pieceActive;
+    bool detection;
+    bool lineToDelete;
+    bool gameOver;
+    bool gameOverTriggered;
+    int gameOverTimer;
+
+    // Statistics
+    int level;
+    int lines;
+    int score;
+
+    // Counters
+    int gravityMovementCounter;
+    int lateralMovementCounter;
+    int turnMovementCounter;
+    int fastFallMovementCounter;
+    int fadeLineCounter;
+    int gravitySpeed;
+
+    unsigned int previousInput;     // Input of the last tick, used to detect presses
+    unsigned int tick;              // UpdateCore() calls since InitCore()
+
+    // Gameplay events go here when set (see NukeleerTelemetry.h). Not touched by InitCore(),
+    // and like the matrices, CopyCore() leaves the destination's own.
+    struct TelemetryRing *telemetry;
+
+    RuleSet rules;
+} GameContext;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+bool InitCore(GameContext *ctx, unsigned int seed);     // Reset the rules to a fresh game
+bool InitCoreWithRules(GameContext *ctx, unsigned int seed, RuleSet rules);     // False if the board could not be allocated
+bool CopyCore(GameContext *dst, const GameContext *src);
+void UnloadCore(GameContext *ctx);
+RuleSet GetDefaultRules(void);
+void UpdateCore(GameContext *ctx, unsigned int input);  // Advance the rules by one tick
+void QueueGarbage(GameContext *ctx, int rows, unsigned int seed);   // Rows with one hole each, raised at the next spawn
+
+#endif // NUKELEER_CORE_H
@@ -0,0 +1,18 @@
+#ifndef NUKELEER_CORE_INTERNAL_H
+#define NUKELEER_CORE_INTERNAL_H
+
+#include "NukeleerCore.h"
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+// The rule steps UpdateCore() is built from, for the benchmark. They expect the state
+// UpdateCore() leaves between ticks; the game only goes through NukeleerCore.h.
+void SetCell(GameContext *ctx, int i, int j, GridSquare square);                // Keeps the row counts and dirty rows exact
+void ResolveFallingMovement(GameContext *ctx, bool *detection, bool *pieceActive);
+bool ResolveLateralMovement(GameContext *ctx, unsigned int input);
+void CheckDetection(GameContext *ctx, bool *detection);
+void CheckCompletion(GameContext *ctx, bool *lineToDelete);                     // Dirty rows only
+int DeleteCompleteLines(GameContext *ctx);
+
+#endif // NUKELEER_CORE_INTERNAL_H
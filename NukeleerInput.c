@@ -0,0 +1,182 @@
+#include "raylib.h"
+#include "NukeleerInput.h"
+#include "NukeleerCore.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define MAX_PENDING_PRESSES     16          // Applied but not yet presented
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct InputEvent {
+    unsigned int key;           // One INPUT_* bit
+    bool down;
+    double time;                // GetTime() when the change was captured
+} InputEvent;
+
+typedef struct KeyBinding {
+    int key;
+    unsigned int bit;
+} KeyBinding;
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+static const KeyBinding bindings[] = {
+    { KEY_LEFT, INPUT_LEFT }, { KEY_RIGHT, INPUT_RIGHT }, { KEY_UP, INPUT_UP }, { KEY_DOWN, INPUT_DOWN }
+};
+
+static InputEvent queue[INPUT_QUEUE_SIZE] = { 0 };
+static unsigned int queueHead = 0;
+static unsigned int queueTail = 0;
+static unsigned int capturedKeys = 0;       // As of the last CaptureInput()
+static unsigned int tickKeys = 0;           // As of the last GetTickInput()
+
+static double pendingPresses[MAX_PENDING_PRESSES] = { 0 };
+static int pendingCount = 0;
+
+static double latencies[LATENCY_SAMPLES] = { 0 };
+static int latencyCount = 0;
+static int latencyNext = 0;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static unsigned int GetKeyBit(int key);
+static bool PushEvent(unsigned int key, bool down, double time);
+static int CompareDoubles(const void *a, const void *b);
+
+//--------------------------------------------------------------------------------------
+// Input Module Functions Definition
+//--------------------------------------------------------------------------------------
+void ResetInputQueue(void)
+{
+    // Presses from the menus are still in raylib's key queue
+    while (GetKeyPressed() != 0) { }
+
+    queueHead = queueTail = 0;
+    capturedKeys = tickKeys = 0;
+    pendingCount = 0;
+}
+
+// raylib does not timestamp events, so the capture time is the closest we get: events
+// are polled at the end of the previous frame and this runs first thing in the next one
+void CaptureInput(void)
+{
+    double now = GetTime();
+    int key = 0;
+
+    // A tap that starts and ends between two polls only shows up in the key queue
+    while ((key = GetKeyPressed()) != 0)
+    {
+        unsigned int bit = GetKeyBit(key);
+
+        if ((bit != 0) && !(capturedKeys & bit) && PushEvent(bit, true, now)) capturedKeys |= bit;
+    }
+
+    for (int i = 0; i < (int)(sizeof(bindings)/sizeof(bindings[0])); i++)
+    {
+        bool down = IsKeyDown(bindings[i].key);
+        bool captured = (capturedKeys & bindings[i].bit) != 0;
+
+        if ((down == captured) || !PushEvent(bindings[i].bit, down, now)) continue;
+
+        if (down) capturedKeys |= bindings[i].bit;
+        else capturedKeys &= ~bindings[i].bit;
+    }
+}
+
+unsigned int GetTickInput(void)
+{
+    unsigned int changed = 0;
+
+    while (queueHead != queueTail)
+    {
+        const InputEvent *event = &queue[queueHead & (INPUT_QUEUE_SIZE - 1)];
+
+        // A second change to the same key waits for the next tick
+        if (changed & event->key) break;
+
+        changed |= event->key;
+
+        if (event->down)
+        {
+            tickKeys |= event->key;
+            if (pendingCount < MAX_PENDING_PRESSES) pendingPresses[pendingCount++] = event->time;
+        }
+        else tickKeys &= ~event->key;
+
+        queueHead++;
+    }
+
+    return tickKeys;
+}
+
+void MarkInputPresented(void)
+{
+    double now = GetTime();
+
+    for (int i = 0; i < pendingCount; i++)
+    {
+        latencies[latencyNext] = now - pendingPresses[i];
+        latencyNext = (latencyNext + 1)%LATENCY_SAMPLES;
+        if (latencyCount < LATENCY_SAMPLES) latencyCount++;
+    }
+
+    pendingCount = 0;
+}
+
+LatencyStats GetInputLatency(void)
+{
+    LatencyStats stats = { 0 };
+    double sorted[LATENCY_SAMPLES];
+
+    if (latencyCount == 0) return stats;
+
+    for (int i = 0; i < latencyCount; i++) sorted[i] = latencies[i];
+    qsort(sorted, latencyCount, sizeof(double), CompareDoubles);
+
+    stats.count = latencyCount;
+    stats.p50 = sorted[(latencyCount - 1)*50/100];
+    stats.p99 = sorted[(latencyCount - 1)*99/100];
+    stats.max = sorted[latencyCount - 1];
+
+    return stats;
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+static unsigned int GetKeyBit(int key)
+{
+    for (int i = 0; i < (int)(sizeof(bindings)/sizeof(bindings[0])); i++)
+    {
+        if (bindings[i].key == key) return bindings[i].bit;
+    }
+
+    return 0;
+}
+
+// A full queue refuses the change, it is captured again on the next frame
+static bool PushEvent(unsigned int key, bool down, double time)
+{
+    if (queueTail - queueHead >= INPUT_QUEUE_SIZE) return false;
+
+    queue[queueTail & (INPUT_QUEUE_SIZE - 1)] = (InputEvent){ key, down, time };
+    queueTail++;
+
+    return true;
+}
+
+static int CompareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
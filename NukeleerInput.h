@@ -0,0 +1,32 @@
+#ifndef NUKELEER_INPUT_H
+#define NUKELEER_INPUT_H
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define INPUT_QUEUE_SIZE        64          // Key changes waiting for a simulation tick, power of two
+#define LATENCY_SAMPLES         256         // Most recent presses kept for the latency statistics
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct LatencyStats {
+    int count;
+    double p50;                 // Seconds from capturing a press to presenting the frame that shows it
+    double p99;
+    double max;
+} LatencyStats;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+// Game keys become timestamped press/release events. Every change is applied at a
+// simulation tick, in order, and a key that changes twice (a tap shorter than a frame)
+// is spread over two ticks so the rules still see the press.
+void ResetInputQueue(void);             // Drop queued events and held keys, at the start of a game
+void CaptureInput(void);                // Once per frame, right after events are polled
+unsigned int GetTickInput(void);        // INPUT_* bits held for the next tick, consuming its events
+void MarkInputPresented(void);          // After EndDrawing(): presses applied so far are on screen
+LatencyStats GetInputLatency(void);
+
+#endif // NUKELEER_INPUT_H
@@ -0,0 +1,283 @@
+// Load generator for NukeleerServer: opens many connections from one process, pairs
+// them into matches and plays each game at 60 ticks per second, exactly as the game
+// client would. Every other client button-mashes, the rest play with the autoplayer
+// so lines get cleared and garbage flows. Reports how far the server lags behind the
+// players, whether its games ever disagree with theirs, and how much garbage was sent.
+//
+// Usage: NukeleerLoad [clients] [seconds] [host] [port]
+
+#include "NukeleerCore.h"
+#include "NukeleerNet.h"
+#include "NukeleerAutoplay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define LOAD_TICK_TIME          (1.0/60.0)
+#define INPUT_HOLD_TICKS        20          // Ticks a random key combination is held
+#define MAX_LAG_TICKS           256         // Histogram range, longer lags land in the last bucket
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct LoadClient {
+    NetClient client;
+    GameContext ctx;
+    unsigned int inputState;
+    unsigned int input;
+    bool autoplay;
+    Autoplayer ai;              // Copy of the shared one, with its own plan
+    int reports;                // Server reports already sampled
+    bool lost;                  // Connection closed, counted once
+} LoadClient;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static unsigned int GetRandomInput(unsigned int *state);
+static int GetLagPercentile(const long long *histogram, long long count, double percentile);
+static double GetLoadTime(void);
+static void WaitLoad(double seconds);
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    int clientCount = (argc > 1)? atoi(argv[1]) : 1000;
+    double duration = (argc > 2)? atof(argv[2]) : 10.0;
+    const char *host = (argc > 3)? argv[3] : "127.0.0.1";
+    int port = (argc > 4)? atoi(argv[4]) : NET_DEFAULT_PORT;
+
+    if (clientCount <= 0) return 0;
+    if (!InitNet()) return 1;
+
+    int fileLimit = RaiseOpenFileLimit(clientCount + 64);
+    if (fileLimit < clientCount + 16) printf("open file limit is %i, expect failed connections\n", fileLimit);
+
+    LoadClient *clients = calloc(clientCount, sizeof(LoadClient));
+    if (clients == NULL) return 1;
+
+    // Every client runs on this thread, so the autoplaying ones share one transposition table.
+    // A zero budget searches one piece untimed: cheap, and it still clears lines.
+    Autoplayer sharedAi = { 0 };
+
+    if (!InitAutoplayer(&sharedAi, 0.0))
+    {
+        free(clients);
+        return 1;
+    }
+
+    int connected = 0;
+
+    for (int i = 0; i < clientCount; i++)
+    {
+        LoadClient *load = &clients[i];
+
+        load->inputState = 0x9e3779b9u*(unsigned int)(i + 1);
+        load->autoplay = (((i/2)%2) == 1);      // Matches pair clients in connection order
+        load->ai = sharedAi;
+
+        if (ConnectNetClient(&load->client, host, port))
+        {
+            RequestNetMatch(&load->client, 2);
+            connected++;
+        }
+        else load->lost = true;
+    }
+
+    printf("clients: %i connected of %i\n", connected, clientCount);
+
+    long long lagHistogram[MAX_LAG_TICKS] = { 0 };
+    long long lagSamples = 0;
+    long long matches = 0;
+    long long ticks = 0;
+    long long garbageRows = 0;
+    int desyncs = 0;
+    int lostCount = 0;
+
+    double start = GetLoadTime();
+    double nextFrame = start;
+    double nextReport = start + 1.0;
+
+    while (GetLoadTime() - start < duration)
+    {
+        double now = GetLoadTime();
+
+        if (now < nextFrame)
+        {
+            WaitLoad(nextFrame - now);
+            continue;
+        }
+
+        nextFrame += LOAD_TICK_TIME;
+
+        for (int i = 0; i < clientCount; i++)
+        {
+            LoadClient *load = &clients[i];
+            NetClient *client = &load->client;
+
+            if (load->lost) continue;
+
+            PollNetClient(client, &load->ctx);
+
+            if (client->connection.closed)
+            {
+                load->lost = true;
+                lostCount++;
+                continue;
+            }
+
+            if (client->reports != load->reports)
+            {
+                int lag = (client->lagTicks < 0)? 0 : (client->lagTicks >= MAX_LAG_TICKS)? MAX_LAG_TICKS - 1 : client->lagTicks;
+
+                lagHistogram[lag]++;
+                lagSamples++;
+                load->reports = client->reports;
+            }
+
+            if (!client->started) continue;
+
+            if (client->ended)
+            {
+                matches++;
+                garbageRows += client->garbageRows;
+                load->ai = sharedAi;
+                RequestNetMatch(client, 2);
+                continue;
+            }
+
+            if (load->autoplay) load->input = GetAutoplayInput(&load->ai, &load->ctx);
+            else if ((client->tick%INPUT_HOLD_TICKS) == 0) load->input = GetRandomInput(&load->inputState);
+
+            if (!load->ctx.gameOver)
+            {
+                StepNetClient(client, &load->ctx, load->input);
+                ticks++;
+            }
+        }
+
+        if (now >= nextReport)
+        {
+            long long garbage = garbageRows;
+
+            desyncs = 0;
+
+            for (int i = 0; i < clientCount; i++)
+            {
+                desyncs += clients[i].client.desyncs;
+                if (clients[i].client.started && !clients[i].client.ended) garbage += clients[i].client.garbageRows;
+            }
+
+            printf("matches: %lld  ticks: %lld  lag p50: %i ticks  p99: %i ticks  desyncs: %i  garbage rows: %lld  lost: %i\n",
+                   matches, ticks, GetLagPercentile(lagHistogram, lagSamples, 0.5), GetLagPercentile(lagHistogram, lagSamples, 0.99), desyncs, garbage, lostCount);
+            fflush(stdout);
+            nextReport += 1.0;
+        }
+    }
+
+    double seconds = GetLoadTime() - start;
+    long long bytesIn = 0;
+    long long bytesOut = 0;
+
+    desyncs = 0;
+
+    for (int i = 0; i < clientCount; i++)
+    {
+        bytesIn += clients[i].client.connection.bytesIn;
+        bytesOut += clients[i].client.connection.bytesOut;
+        desyncs += clients[i].client.desyncs;
+
+        // Matches still running count too, most autoplayed ones outlast a short run
+        if (clients[i].client.started && !clients[i].client.ended) garbageRows += clients[i].client.garbageRows;
+
+        CloseNetClient(&clients[i].client);
+        UnloadCore(&clients[i].ctx);
+    }
+
+    printf("clients: %i (%i lost)\n", connected, lostCount);
+    printf("matches finished: %lld\n", matches);
+    printf("ticks/s: %.0f\n", ticks/seconds);
+    printf("server lag: p50 %.1f ms  p99 %.1f ms  (%lld reports)\n",
+           GetLagPercentile(lagHistogram, lagSamples, 0.5)*LOAD_TICK_TIME*1000.0, GetLagPercentile(lagHistogram, lagSamples, 0.99)*LOAD_TICK_TIME*1000.0, lagSamples);
+    printf("desyncs: %i (%lld garbage rows sent)\n", desyncs, garbageRows);
+    if (garbageRows == 0) printf("no garbage was sent, so it was not checked: autoplayed games clear their first line after about a minute\n");
+    printf("traffic per client: %.1f B/s up  %.1f B/s down\n", (connected > 0)? bytesOut/seconds/connected : 0.0, (connected > 0)? bytesIn/seconds/connected : 0.0);
+
+    free(clients);
+    CloseAutoplayer(&sharedAi);
+    CloseNet();
+
+    return (desyncs == 0)? 0 : 2;
+}
+
+//--------------------------------------------------------------------------------------
+// Module Functions Definition
+//--------------------------------------------------------------------------------------
+
+// Pick a held key combination, roughly what a button-mashing player would do
+static unsigned int GetRandomInput(unsigned int *state)
+{
+    static const unsigned int choices[] = {
+        0, INPUT_LEFT, INPUT_RIGHT, INPUT_DOWN, INPUT_LEFT | INPUT_DOWN, INPUT_RIGHT | INPUT_DOWN
+    };
+
+    *state = *state*1103515245u + 12345u;
+
+    return choices[((*state >> 16) & 0x7fff)%(sizeof(choices)/sizeof(choices[0]))];
+}
+
+static int GetLagPercentile(const long long *histogram, long long count, double percentile)
+{
+    long long target = (long long)(count*percentile);
+    long long seen = 0;
+
+    if (count == 0) return 0;
+
+    for (int i = 0; i < MAX_LAG_TICKS; i++)
+    {
+        seen += histogram[i];
+        if (seen > target) return i;
+    }
+
+    return MAX_LAG_TICKS - 1;
+}
+
+static double GetLoadTime(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart/(double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + now.tv_nsec*1e-9;
+#endif
+}
+
+static void WaitLoad(double seconds)
+{
+#if defined(_WIN32)
+    Sleep((DWORD)(seconds*1000.0));
+#else
+    struct timespec wait = { 0 };
+    wait.tv_nsec = (long)(seconds*1e9);
+    nanosleep(&wait, NULL);
+#endif
+}
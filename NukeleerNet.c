@@ -0,0 +1,461 @@
+#include "NukeleerNet.h"
+#include "NukeleerReplay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+#else
+    #include <arpa/inet.h>
+    #include <errno.h>
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/resource.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define NET_LISTEN_BACKLOG      1024
+
+#if defined(MSG_NOSIGNAL)
+    #define NET_SEND_FLAGS      MSG_NOSIGNAL    // A closed peer is reported by send(), not SIGPIPE
+#else
+    #define NET_SEND_FLAGS      0
+#endif
+
+#if defined(_WIN32)
+    _Static_assert((sizeof(NetPollEntry) == sizeof(WSAPOLLFD)) && (NET_POLL_IN == POLLIN), "NetPollEntry must match WSAPOLLFD");
+#else
+    _Static_assert((sizeof(NetPollEntry) == sizeof(struct pollfd)) && (NET_POLL_IN == POLLIN), "NetPollEntry must match struct pollfd");
+#endif
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+// Fields that follow the type byte of each message
+static const int messageFields[NET_MESSAGE_TYPES] = {
+    [NET_HELLO] = 2,
+    [NET_START] = 3,
+    [NET_INPUT] = 2,
+    [NET_GARBAGE] = 2,
+    [NET_GARBAGE_TAKEN] = 1,
+    [NET_STATE] = 5,
+    [NET_END] = 1,
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static bool SetSocketOptions(NetSocket socket);     // Non-blocking, no Nagle delay
+static bool WouldBlock(void);
+static void PutUint32(unsigned char *bytes, uint32_t value);
+static uint32_t GetUint32(const unsigned char *bytes);
+
+//--------------------------------------------------------------------------------------
+// Sockets Module Functions Definition
+//--------------------------------------------------------------------------------------
+bool InitNet(void)
+{
+#if defined(_WIN32)
+    WSADATA data;
+    return (WSAStartup(MAKEWORD(2, 2), &data) == 0);
+#else
+    return true;
+#endif
+}
+
+void CloseNet(void)
+{
+#if defined(_WIN32)
+    WSACleanup();
+#endif
+}
+
+int RaiseOpenFileLimit(int wanted)
+{
+#if defined(_WIN32)
+    return wanted;      // Sockets are not counted against a file limit
+#else
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return 0;
+
+    if ((limit.rlim_cur == RLIM_INFINITY) || (limit.rlim_cur >= (rlim_t)wanted)) return wanted;
+
+    rlim_t target = (rlim_t)wanted;
+    if ((limit.rlim_max != RLIM_INFINITY) && (target > limit.rlim_max)) target = limit.rlim_max;
+
+    limit.rlim_cur = target;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    getrlimit(RLIMIT_NOFILE, &limit);
+
+    return (int)limit.rlim_cur;
+#endif
+}
+
+NetSocket ListenNet(int port, bool loopbackOnly)
+{
+    NetSocket listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listener == INVALID_NET_SOCKET) return INVALID_NET_SOCKET;
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&reuse, sizeof(reuse));
+
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    address.sin_addr.s_addr = htonl(loopbackOnly? INADDR_LOOPBACK : INADDR_ANY);
+
+    if ((bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0) ||
+        (listen(listener, NET_LISTEN_BACKLOG) != 0) || !SetSocketOptions(listener))
+    {
+        CloseNetSocket(listener);
+        return INVALID_NET_SOCKET;
+    }
+
+    return listener;
+}
+
+NetSocket AcceptNet(NetSocket listener)
+{
+    NetSocket socket = accept(listener, NULL, NULL);
+    if (socket == INVALID_NET_SOCKET) return INVALID_NET_SOCKET;
+
+    if (!SetSocketOptions(socket))
+    {
+        CloseNetSocket(socket);
+        return INVALID_NET_SOCKET;
+    }
+
+    return socket;
+}
+
+// Blocking connect, the socket is switched to non-blocking once it is established
+NetSocket ConnectNet(const char *host, int port)
+{
+    struct addrinfo hints = { 0 };
+    struct addrinfo *addresses = NULL;
+    char service[16] = { 0 };
+
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    snprintf(service, sizeof(service), "%i", port);
+
+    if (getaddrinfo(host, service, &hints, &addresses) != 0) return INVALID_NET_SOCKET;
+
+    NetSocket result = INVALID_NET_SOCKET;
+
+    for (struct addrinfo *address = addresses; (address != NULL) && (result == INVALID_NET_SOCKET); address = address->ai_next)
+    {
+        NetSocket candidate = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (candidate == INVALID_NET_SOCKET) continue;
+
+        if ((connect(candidate, address->ai_addr, (int)address->ai_addrlen) == 0) && SetSocketOptions(candidate)) result = candidate;
+        else CloseNetSocket(candidate);
+    }
+
+    freeaddrinfo(addresses);
+
+    return result;
+}
+
+void CloseNetSocket(NetSocket socket)
+{
+    if (socket == INVALID_NET_SOCKET) return;
+
+#if defined(_WIN32)
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+int PollNet(NetPollEntry *entries, int count, int timeoutMs)
+{
+#if defined(_WIN32)
+    return WSAPoll((WSAPOLLFD *)entries, (ULONG)count, timeoutMs);
+#else
+    return poll((struct pollfd *)entries, (nfds_t)count, timeoutMs);
+#endif
+}
+
+//--------------------------------------------------------------------------------------
+// Connection Module Functions Definition
+//--------------------------------------------------------------------------------------
+void InitNetConnection(NetConnection *connection, NetSocket socket)
+{
+    memset(connection, 0, sizeof(NetConnection));
+    connection->socket = socket;
+    connection->closed = (socket == INVALID_NET_SOCKET);
+}
+
+void CloseNetConnection(NetConnection *connection)
+{
+    CloseNetSocket(connection->socket);
+    connection->socket = INVALID_NET_SOCKET;
+    connection->closed = true;
+}
+
+void ReceiveNet(NetConnection *connection)
+{
+    while (!connection->closed && (connection->inSize < NET_BUFFER_SIZE))
+    {
+        int received = (int)recv(connection->socket, (char *)connection->in + connection->inSize, NET_BUFFER_SIZE - connection->inSize, 0);
+
+        if (received > 0)
+        {
+            connection->inSize += received;
+            connection->bytesIn += received;
+        }
+        else
+        {
+            if ((received < 0) && WouldBlock()) break;
+            connection->closed = true;      // Orderly shutdown or a reset
+        }
+    }
+}
+
+bool GetNetMessage(NetConnection *connection, NetMessage *message)
+{
+    if (connection->inSize == 0) return false;
+
+    int type = connection->in[0];
+
+    if ((type <= 0) || (type >= NET_MESSAGE_TYPES))
+    {
+        connection->closed = true;
+        connection->inSize = 0;
+        return false;
+    }
+
+    int size = 1 + 4*messageFields[type];
+    if (connection->inSize < size) return false;
+
+    message->type = type;
+    for (int i = 0; i < NET_MAX_FIELDS; i++) message->fields[i] = (i < messageFields[type])? GetUint32(connection->in + 1 + 4*i) : 0;
+
+    connection->inSize -= size;
+    memmove(connection->in, connection->in + size, connection->inSize);
+
+    return true;
+}
+
+void SendNetMessage(NetConnection *connection, int type, const uint32_t *fields)
+{
+    int size = 1 + 4*messageFields[type];
+
+    if (connection->closed) return;
+
+    // A peer that stops reading is dropped instead of buffering without bound
+    if (connection->outSize + size > NET_BUFFER_SIZE)
+    {
+        connection->closed = true;
+        return;
+    }
+
+    unsigned char *bytes = connection->out + connection->outSize;
+    bytes[0] = (unsigned char)type;
+    for (int i = 0; i < messageFields[type]; i++) PutUint32(bytes + 1 + 4*i, fields[i]);
+
+    connection->outSize += size;
+}
+
+void FlushNet(NetConnection *connection)
+{
+    int offset = 0;
+
+    while (!connection->closed && (offset < connection->outSize))
+    {
+        int sent = (int)send(connection->socket, (const char *)connection->out + offset, connection->outSize - offset, NET_SEND_FLAGS);
+
+        if (sent > 0)
+        {
+            offset += sent;
+            connection->bytesOut += sent;
+        }
+        else if ((sent < 0) && WouldBlock()) break;
+        else connection->closed = true;
+    }
+
+    connection->outSize -= offset;
+    if ((offset > 0) && (connection->outSize > 0)) memmove(connection->out, connection->out + offset, connection->outSize);
+}
+
+//--------------------------------------------------------------------------------------
+// Client Module Functions Definition
+//--------------------------------------------------------------------------------------
+bool ConnectNetClient(NetClient *client, const char *host, int port)
+{
+    memset(client, 0, sizeof(NetClient));
+    InitNetConnection(&client->connection, ConnectNet(host, port));
+    client->winner = NET_NO_WINNER;
+
+    return !client->connection.closed;
+}
+
+void RequestNetMatch(NetClient *client, int players)
+{
+    uint32_t fields[2] = { NET_PROTOCOL_VERSION, (uint32_t)players };
+    NetMessage message = { 0 };
+
+    // Anything still unread belongs to an earlier match and would end the new one at once
+    ReceiveNet(&client->connection);
+    while (GetNetMessage(&client->connection, &message)) { }
+
+    client->started = false;
+    client->ended = false;
+    SendNetMessage(&client->connection, NET_HELLO, fields);
+    FlushNet(&client->connection);
+}
+
+void PollNetClient(NetClient *client, GameContext *ctx)
+{
+    NetMessage message = { 0 };
+
+    ReceiveNet(&client->connection);
+
+    while (GetNetMessage(&client->connection, &message))
+    {
+        switch (message.type)
+        {
+            case NET_START:
+            {
+                client->started = true;
+                client->ended = false;
+                client->seed = message.fields[0];
+                client->player = (int)message.fields[1];
+                client->playerCount = (int)message.fields[2];
+                client->tick = 0;
+                client->lastInput = 0;
+                client->winner = NET_NO_WINNER;
+                client->opponentScore = 0;
+                client->opponentLines = 0;
+                client->garbageRows = 0;
+                client->lagTicks = 0;
+                memset(client->hashTicks, 0, sizeof(client->hashTicks));
+
+                InitCore(ctx, client->seed);
+            } break;
+            case NET_GARBAGE:
+            {
+                // Raised at this tick on both sides, the server waits for the answer
+                uint32_t fields[1] = { client->tick };
+
+                QueueGarbage(ctx, (int)message.fields[0], message.fields[1]);
+                client->garbageRows += (int)message.fields[0];
+                SendNetMessage(&client->connection, NET_GARBAGE_TAKEN, fields);
+            } break;
+            case NET_STATE:
+            {
+                uint32_t tick = message.fields[1];
+
+                if ((int)message.fields[0] == client->player)
+                {
+                    int slot = (tick/NET_STATE_TICKS)%NET_HASH_HISTORY;
+
+                    if ((client->hashTicks[slot] == tick) && (client->hashes[slot] != message.fields[4])) client->desyncs++;
+                    client->reports++;
+                    client->lagTicks = (int)(client->tick - tick);
+                }
+                else
+                {
+                    client->opponentScore = (int)message.fields[2];
+                    client->opponentLines = (int)message.fields[3];
+                }
+            } break;
+            case NET_END:
+            {
+                client->ended = true;
+                client->winner = message.fields[0];
+            } break;
+            default: client->connection.closed = true; break;
+        }
+    }
+
+    FlushNet(&client->connection);
+}
+
+void StepNetClient(NetClient *client, GameContext *ctx, unsigned int input)
+{
+    if (!client->started || client->ended || ctx->gameOver) return;
+
+    if ((input != client->lastInput) || ((client->tick%NET_KEEPALIVE_TICKS) == 0))
+    {
+        uint32_t fields[2] = { client->tick, input };
+        SendNetMessage(&client->connection, NET_INPUT, fields);
+        client->lastInput = input;
+    }
+
+    UpdateCore(ctx, input);
+    client->tick++;
+
+    if ((client->tick%NET_STATE_TICKS) == 0)
+    {
+        int slot = (client->tick/NET_STATE_TICKS)%NET_HASH_HISTORY;
+        client->hashTicks[slot] = client->tick;
+        client->hashes[slot] = GetGameHash(ctx);
+    }
+
+    // The server can only see the top-out once it knows every tick up to it
+    if (ctx->gameOver)
+    {
+        uint32_t fields[2] = { client->tick, input };
+        SendNetMessage(&client->connection, NET_INPUT, fields);
+    }
+
+    FlushNet(&client->connection);
+}
+
+void CloseNetClient(NetClient *client)
+{
+    FlushNet(&client->connection);
+    CloseNetConnection(&client->connection);
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+static bool SetSocketOptions(NetSocket socket)
+{
+    int noDelay = 1;
+    setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&noDelay, sizeof(noDelay));
+
+#if defined(_WIN32)
+    u_long nonBlocking = 1;
+    return (ioctlsocket(socket, FIONBIO, &nonBlocking) == 0);
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    return (flags != -1) && (fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0);
+#endif
+}
+
+static bool WouldBlock(void)
+{
+#if defined(_WIN32)
+    return (WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+    return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+#endif
+}
+
+static void PutUint32(unsigned char *bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)(value);
+    bytes[1] = (unsigned char)(value >> 8);
+    bytes[2] = (unsigned char)(value >> 16);
+    bytes[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t GetUint32(const unsigned char *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
@@ -0,0 +1,124 @@
+#ifndef NUKELEER_NET_H
+#define NUKELEER_NET_H
+
+#include "NukeleerCore.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// No system socket headers here: windows.h clashes with raylib names, and the game includes this
+#if defined(_WIN32)
+    typedef uintptr_t NetSocket;                // SOCKET
+    #define INVALID_NET_SOCKET  (~(NetSocket)0)
+    #define NET_POLL_IN         0x0300          // POLLRDNORM | POLLRDBAND
+#else
+    typedef int NetSocket;
+    #define INVALID_NET_SOCKET  (-1)
+    #define NET_POLL_IN         0x0001          // POLLIN
+#endif
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define NET_PROTOCOL_VERSION    1
+#define NET_DEFAULT_PORT        7777
+#define NET_BUFFER_SIZE         2048        // Per direction and connection
+#define NET_MAX_FIELDS          5
+#define NET_KEEPALIVE_TICKS     15          // An unchanged input is re-sent this often, so the server can advance
+#define NET_STATE_TICKS         60          // Ticks between the server's score and hash reports
+#define NET_HASH_HISTORY        16          // Own hashes a client keeps to check those reports
+#define NET_NO_WINNER           0xffffffffu
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// Every message is a type byte then a fixed number of little-endian uint32 fields,
+// listed here in order. Ticks count UpdateCore() calls since the match started.
+typedef enum NetMessageType {
+    NET_HELLO = 1,          // Client: protocol version, players wanted (1 plays alone, 2 waits for an opponent)
+    NET_START,              // Server: seed, player index, player count
+    NET_INPUT,              // Client: tick, input. From that tick on the input is this; also reports the client got there
+    NET_GARBAGE,            // Server: rows, seed. The opponent cleared lines
+    NET_GARBAGE_TAKEN,      // Client: tick the oldest unanswered garbage was queued before
+    NET_STATE,              // Server: player index, tick, score, lines, game hash
+    NET_END,                // Server: winning player index, or NET_NO_WINNER
+    NET_MESSAGE_TYPES
+} NetMessageType;
+
+// Same layout as struct pollfd (WSAPOLLFD on Windows)
+typedef struct NetPollEntry {
+    NetSocket fd;
+    short events;
+    short revents;
+} NetPollEntry;
+
+typedef struct NetMessage {
+    int type;
+    uint32_t fields[NET_MAX_FIELDS];
+} NetMessage;
+
+// A non-blocking TCP connection with its own buffers. Messages are queued with
+// SendNetMessage() and go out on FlushNet(); ReceiveNet() reads whatever has arrived.
+typedef struct NetConnection {
+    NetSocket socket;
+    unsigned char in[NET_BUFFER_SIZE];
+    int inSize;
+    unsigned char out[NET_BUFFER_SIZE];
+    int outSize;
+    bool closed;                // Peer gone, protocol error or a buffer overrun
+    long long bytesIn;
+    long long bytesOut;
+} NetConnection;
+
+// The client half of a match, shared by the game and the load generator. The game itself
+// runs locally as usual and only its input changes go to the server, which plays the same
+// ticks authoritatively and relays garbage and scores.
+typedef struct NetClient {
+    NetConnection connection;
+    bool started;               // NET_START received, the context was reset with its seed
+    bool ended;                 // NET_END received
+    unsigned int seed;
+    int player;
+    int playerCount;
+    uint32_t tick;
+    unsigned int lastInput;
+    uint32_t winner;
+
+    int opponentScore;
+    int opponentLines;
+    int garbageRows;            // Received over the match
+
+    uint32_t hashTicks[NET_HASH_HISTORY];
+    uint32_t hashes[NET_HASH_HISTORY];
+    int reports;                // Server reports on this client's own game
+    int desyncs;                // Reports that did not match the local game
+    int lagTicks;               // How far the last report was behind the local game
+} NetClient;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+bool InitNet(void);                                     // Socket library setup (Winsock), once per process
+void CloseNet(void);
+int RaiseOpenFileLimit(int wanted);                     // Connections are files on POSIX; returns the new limit
+
+NetSocket ListenNet(int port, bool loopbackOnly);
+NetSocket AcceptNet(NetSocket listener);                // INVALID_NET_SOCKET when nobody is waiting
+NetSocket ConnectNet(const char *host, int port);
+void CloseNetSocket(NetSocket socket);
+int PollNet(NetPollEntry *entries, int count, int timeoutMs);   // poll() or WSAPoll(), waits up to timeoutMs for any entry
+
+void InitNetConnection(NetConnection *connection, NetSocket socket);
+void CloseNetConnection(NetConnection *connection);
+void ReceiveNet(NetConnection *connection);
+bool GetNetMessage(NetConnection *connection, NetMessage *message);     // Next complete message, if any
+void SendNetMessage(NetConnection *connection, int type, const uint32_t *fields);
+void FlushNet(NetConnection *connection);
+
+bool ConnectNetClient(NetClient *client, const char *host, int port);
+void RequestNetMatch(NetClient *client, int players);   // Sends NET_HELLO, a new match after the last one ended
+void PollNetClient(NetClient *client, GameContext *ctx);    // Handle server messages, resets ctx on NET_START
+void StepNetClient(NetClient *client, GameContext *ctx, unsigned int input);    // UpdateCore() plus what the server needs to follow
+void CloseNetClient(NetClient *client);
+
+#endif // NUKELEER_NET_H
@@ -0,0 +1,166 @@
+#include "NukeleerPack.h"
+
+#include <string.h>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+static const unsigned char *packData = NULL;
+static size_t packSize = 0;
+static const PackEntry *packEntries = NULL;
+static uint32_t packEntryCount = 0;
+
+#if defined(_WIN32)
+static HANDLE packFile = INVALID_HANDLE_VALUE;
+static HANDLE packMapping = NULL;
+#endif
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static bool MapFile(const char *fileName);
+static void UnmapFile(void);
+static bool ValidatePack(void);
+
+//--------------------------------------------------------------------------------------
+// Pack Module Functions Definition
+//--------------------------------------------------------------------------------------
+bool MountAssetPack(const char *fileName)
+{
+    UnmountAssetPack();
+
+    if (!MapFile(fileName)) return false;
+
+    if (!ValidatePack())
+    {
+        UnmountAssetPack();
+        return false;
+    }
+
+    return true;
+}
+
+void UnmountAssetPack(void)
+{
+    if (packData != NULL) UnmapFile();
+
+    packData = NULL;
+    packSize = 0;
+    packEntries = NULL;
+    packEntryCount = 0;
+}
+
+bool IsAssetPackMounted(void)
+{
+    return (packData != NULL);
+}
+
+const PackEntry *FindPackEntry(const char *name)
+{
+    for (uint32_t i = 0; i < packEntryCount; i++)
+    {
+        if (strncmp(packEntries[i].name, name, PACK_MAX_NAME) == 0) return &packEntries[i];
+    }
+
+    return NULL;
+}
+
+const void *GetPackEntryData(const PackEntry *entry)
+{
+    return packData + entry->offset;
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+#if defined(_WIN32)
+static bool MapFile(const char *fileName)
+{
+    packFile = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (packFile == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(packFile, &size);
+
+    packMapping = CreateFileMappingA(packFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (packMapping != NULL) packData = MapViewOfFile(packMapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (packData == NULL)
+    {
+        UnmapFile();
+        return false;
+    }
+
+    packSize = (size_t)size.QuadPart;
+
+    return true;
+}
+
+static void UnmapFile(void)
+{
+    if (packData != NULL) UnmapViewOfFile(packData);
+    if (packMapping != NULL) CloseHandle(packMapping);
+    if (packFile != INVALID_HANDLE_VALUE) CloseHandle(packFile);
+
+    packMapping = NULL;
+    packFile = INVALID_HANDLE_VALUE;
+}
+#else
+static bool MapFile(const char *fileName)
+{
+    int file = open(fileName, O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat info;
+    void *data = MAP_FAILED;
+
+    if ((fstat(file, &info) == 0) && (info.st_size > 0)) data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+    // The mapping stays valid after the descriptor is closed
+    close(file);
+
+    if (data == MAP_FAILED) return false;
+
+    packData = data;
+    packSize = (size_t)info.st_size;
+
+    return true;
+}
+
+static void UnmapFile(void)
+{
+    munmap((void *)packData, packSize);
+}
+#endif
+
+// Reject anything that could make a lookup read outside the mapping
+static bool ValidatePack(void)
+{
+    if (packSize < sizeof(PackHeader)) return false;
+
+    const PackHeader *header = (const PackHeader *)packData;
+
+    if ((memcmp(header->magic, "NKPK", 4) != 0) || (header->version != PACK_FILE_VERSION)) return false;
+    if (header->entryCount > (packSize - sizeof(PackHeader))/sizeof(PackEntry)) return false;
+
+    packEntries = (const PackEntry *)(packData + sizeof(PackHeader));
+    packEntryCount = header->entryCount;
+
+    for (uint32_t i = 0; i < packEntryCount; i++)
+    {
+        if ((packEntries[i].offset > packSize) || (packEntries[i].size > packSize - packEntries[i].offset)) return false;
+        if (memchr(packEntries[i].name, 0, PACK_MAX_NAME) == NULL) return false;
+    }
+
+    return true;
+}
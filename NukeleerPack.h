@@ -0,0 +1,50 @@
+#ifndef NUKELEER_PACK_H
+#define NUKELEER_PACK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define PACK_FILE_NAME          "Nukeleer.pak"
+#define PACK_FILE_VERSION       1
+#define PACK_MAX_NAME           48
+#define PACK_DATA_ALIGNMENT     64
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// Pack layout (native byte order, built on the machine type it ships to):
+// PackHeader, entryCount PackEntry records, then each entry's data aligned to
+// PACK_DATA_ALIGNMENT. Images are stored already decoded, in the raylib pixel
+// format named by the entry, so they can be uploaded straight from the mapping.
+typedef enum PackEntryType { PACK_ENTRY_IMAGE = 1, PACK_ENTRY_FILE = 2 } PackEntryType;
+
+typedef struct PackHeader {
+    char magic[4];                  // "NKPK"
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+} PackHeader;
+
+typedef struct PackEntry {
+    char name[PACK_MAX_NAME];       // Original file name, e.g. "GameScreen.png"
+    uint32_t type;                  // PackEntryType
+    int32_t width;                  // Images only
+    int32_t height;
+    int32_t format;                 // raylib PixelFormat
+    uint64_t offset;                // From the start of the pack
+    uint64_t size;
+} PackEntry;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+bool MountAssetPack(const char *fileName);      // Memory-map a pack, false if missing or invalid
+void UnmountAssetPack(void);
+bool IsAssetPackMounted(void);
+const PackEntry *FindPackEntry(const char *name);
+const void *GetPackEntryData(const PackEntry *entry);
+
+#endif // NUKELEER_PACK_H
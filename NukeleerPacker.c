@@ -0,0 +1,157 @@
+// Offline asset packer: decodes the game's images once and bakes them, together with
+// any other files, into a single pack the game memory-maps at startup.
+//
+// Usage: NukeleerPacker <output.pak> <file> [file...]
+//   PNG files are stored as decoded pixels, everything else is stored as-is.
+
+#include "raylib.h"
+#include "NukeleerPack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct PackSource {
+    PackEntry entry;
+    Image image;                    // Decoded pixels, for PACK_ENTRY_IMAGE
+    unsigned char *fileData;        // Raw bytes, for PACK_ENTRY_FILE
+} PackSource;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static bool LoadSource(PackSource *source, const char *fileName);
+static void UnloadSource(PackSource *source);
+static bool WritePadding(FILE *file, uint64_t *position, uint64_t alignment);
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        printf("usage: %s <output.pak> <file> [file...]\n", argv[0]);
+        return 1;
+    }
+
+    int count = argc - 2;
+    PackSource *sources = calloc(count, sizeof(PackSource));
+    if (sources == NULL) return 1;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!LoadSource(&sources[i], argv[i + 2]))
+        {
+            printf("could not load %s\n", argv[i + 2]);
+            return 1;
+        }
+    }
+
+    // Data starts after the header and entry table, each blob aligned for direct upload
+    uint64_t position = sizeof(PackHeader) + (uint64_t)count*sizeof(PackEntry);
+
+    for (int i = 0; i < count; i++)
+    {
+        position = (position + PACK_DATA_ALIGNMENT - 1)/PACK_DATA_ALIGNMENT*PACK_DATA_ALIGNMENT;
+        sources[i].entry.offset = position;
+        position += sources[i].entry.size;
+    }
+
+    FILE *file = fopen(argv[1], "wb");
+    if (file == NULL)
+    {
+        printf("could not create %s\n", argv[1]);
+        return 1;
+    }
+
+    PackHeader header = { { 'N', 'K', 'P', 'K' }, PACK_FILE_VERSION, (uint32_t)count, 0 };
+    bool success = (fwrite(&header, sizeof(PackHeader), 1, file) == 1);
+
+    for (int i = 0; success && (i < count); i++) success = (fwrite(&sources[i].entry, sizeof(PackEntry), 1, file) == 1);
+
+    position = sizeof(PackHeader) + (uint64_t)count*sizeof(PackEntry);
+
+    for (int i = 0; success && (i < count); i++)
+    {
+        const void *data = (sources[i].entry.type == PACK_ENTRY_IMAGE)? sources[i].image.data : (const void *)sources[i].fileData;
+
+        success = WritePadding(file, &position, PACK_DATA_ALIGNMENT) &&
+                  (fwrite(data, 1, (size_t)sources[i].entry.size, file) == sources[i].entry.size);
+
+        position += sources[i].entry.size;
+
+        printf("%-24s %s %8llu bytes\n", sources[i].entry.name, (sources[i].entry.type == PACK_ENTRY_IMAGE)? "image" : "file ",
+               (unsigned long long)sources[i].entry.size);
+    }
+
+    if (fclose(file) != 0) success = false;
+
+    for (int i = 0; i < count; i++) UnloadSource(&sources[i]);
+    free(sources);
+
+    if (!success)
+    {
+        printf("failed writing %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("%s: %i entries, %llu bytes\n", argv[1], count, (unsigned long long)position);
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------
+// Module Functions Definition
+//--------------------------------------------------------------------------------------
+static bool LoadSource(PackSource *source, const char *fileName)
+{
+    const char *name = GetFileName(fileName);
+
+    if (strlen(name) >= PACK_MAX_NAME) return false;
+
+    strcpy(source->entry.name, name);
+
+    if (IsFileExtension(fileName, ".png"))
+    {
+        source->image = LoadImage(fileName);
+        if (source->image.data == NULL) return false;
+
+        source->entry.type = PACK_ENTRY_IMAGE;
+        source->entry.width = source->image.width;
+        source->entry.height = source->image.height;
+        source->entry.format = source->image.format;
+        source->entry.size = (uint64_t)GetPixelDataSize(source->image.width, source->image.height, source->image.format);
+    }
+    else
+    {
+        int size = 0;
+
+        source->fileData = LoadFileData(fileName, &size);
+        if (source->fileData == NULL) return false;
+
+        source->entry.type = PACK_ENTRY_FILE;
+        source->entry.size = (uint64_t)size;
+    }
+
+    return true;
+}
+
+static void UnloadSource(PackSource *source)
+{
+    if (source->image.data != NULL) UnloadImage(source->image);
+    if (source->fileData != NULL) UnloadFileData(source->fileData);
+}
+
+static bool WritePadding(FILE *file, uint64_t *position, uint64_t alignment)
+{
+    static const unsigned char zeros[PACK_DATA_ALIGNMENT] = { 0 };
+    uint64_t padding = (alignment - (*position%alignment))%alignment;
+
+    *position += padding;
+
+    return (padding == 0) || (fwrite(zeros, 1, (size_t)padding, file) == padding);
+}
@@ -0,0 +1,94 @@
+#include "NukeleerPieces.h"
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static inline uint32_t RotateLeft(uint32_t value, int count);
+static uint32_t NextRandom(PieceStream *stream);
+static Piece GeneratePiece(PieceStream *stream);
+
+//--------------------------------------------------------------------------------------
+// Pieces Module Functions Definition
+//--------------------------------------------------------------------------------------
+void InitPieceStream(PieceStream *stream, unsigned int seed)
+{
+    // Expand the seed with splitmix64, xoshiro must never start from an all-zero state
+    uint64_t mix = seed;
+
+    for (int i = 0; i < 4; i += 2)
+    {
+        mix += 0x9e3779b97f4a7c15ull;
+
+        uint64_t z = mix;
+        z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27))*0x94d049bb133111ebull;
+        z = z ^ (z >> 31);
+
+        stream->state[i] = (uint32_t)z;
+        stream->state[i + 1] = (uint32_t)(z >> 32);
+    }
+
+    stream->head = 0;
+
+    for (int i = 0; i < PIECE_QUEUE_SIZE; i++) stream->queue[i] = GeneratePiece(stream);
+}
+
+Piece NextPiece(PieceStream *stream)
+{
+    Piece piece = stream->queue[stream->head];
+
+    stream->queue[stream->head] = GeneratePiece(stream);
+    stream->head = (stream->head + 1) & (PIECE_QUEUE_SIZE - 1);
+
+    return piece;
+}
+
+Piece PeekPiece(const PieceStream *stream, int ahead)
+{
+    return stream->queue[(stream->head + ahead) & (PIECE_QUEUE_SIZE - 1)];
+}
+
+int GetStreamValue(PieceStream *stream, int min, int max)
+{
+    uint32_t range = (uint32_t)(max - min) + 1;
+
+    // Multiply-shift range reduction, bias is below 2^-29 for the ranges used here
+    return min + (int)(((uint64_t)NextRandom(stream)*range) >> 32);
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+static inline uint32_t RotateLeft(uint32_t value, int count)
+{
+    return (value << count) | (value >> (32 - count));
+}
+
+// xoshiro128** 1.1 (Blackman and Vigna)
+static uint32_t NextRandom(PieceStream *stream)
+{
+    uint32_t *s = stream->state;
+    uint32_t result = RotateLeft(s[1]*5, 7)*9;
+    uint32_t t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = RotateLeft(s[3], 11);
+
+    return result;
+}
+
+// A single barrel in a random cell of the 4x4 spawn area, with its own color
+static Piece GeneratePiece(PieceStream *stream)
+{
+    Piece piece = { 0 };
+
+    piece.x = GetStreamValue(stream, 0, 3);
+    piece.y = GetStreamValue(stream, 0, 3);
+    piece.color = (BarrelColor)GetStreamValue(stream, 0, 2);
+
+    return piece;
+}
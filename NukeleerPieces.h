@@ -0,0 +1,39 @@
+#ifndef NUKELEER_PIECES_H
+#define NUKELEER_PIECES_H
+
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define PIECE_QUEUE_SIZE        8           // Lookahead pieces, must be a power of two
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum BarrelColor { BARREL_RED, BARREL_BLUE, BARREL_YELLOW } BarrelColor;
+
+// A piece is a single barrel somewhere in the 4x4 spawn area
+typedef struct Piece {
+    int x;
+    int y;
+    BarrelColor color;
+} Piece;
+
+// Per-game piece generator: xoshiro128** state plus a ring of upcoming pieces.
+// A plain value type, so search code can copy it to explore futures.
+typedef struct PieceStream {
+    uint32_t state[4];
+    Piece queue[PIECE_QUEUE_SIZE];
+    unsigned int head;                      // Index of the next piece in queue
+} PieceStream;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+void InitPieceStream(PieceStream *stream, unsigned int seed);   // Same seed, same sequence
+Piece NextPiece(PieceStream *stream);                           // Take the next piece, refill the ring
+Piece PeekPiece(const PieceStream *stream, int ahead);          // 0 is the next piece, up to PIECE_QUEUE_SIZE - 1
+int GetStreamValue(PieceStream *stream, int min, int max);      // Uniform in [min, max] from the game's generator
+
+#endif // NUKELEER_PIECES_H
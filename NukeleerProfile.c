@@ -0,0 +1,204 @@
+#include "NukeleerProfile.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ProfileZone {
+    const char *name;
+    int depth;
+    uint64_t frameNs;                       // Accumulated during the current frame
+    float history[PROFILE_HISTORY];         // Milliseconds per frame
+} ProfileZone;
+
+typedef struct ProfileEvent {
+    const char *name;
+    uint64_t start;                         // Nanoseconds since InitProfiler()
+    uint64_t duration;
+    int depth;
+} ProfileEvent;
+
+typedef struct OpenZone {
+    ProfileZone *zone;
+    uint64_t start;
+} OpenZone;
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+static _Thread_local bool profiledThread = false;
+
+static uint64_t profileEpoch = 0;
+static uint64_t frameStart = 0;
+static int frameIndex = 0;                  // Next history slot
+static float frameHistory[PROFILE_HISTORY] = { 0 };
+
+static ProfileZone zones[MAX_PROFILE_ZONES] = { 0 };
+static int zoneCount = 0;
+
+static OpenZone stack[MAX_PROFILE_DEPTH] = { 0 };
+static int stackDepth = 0;
+
+static ProfileEvent events[MAX_PROFILE_EVENTS] = { 0 };
+static uint64_t eventCount = 0;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static uint64_t GetProfileTime(void);
+static ProfileZone *FindZone(const char *name);
+
+//--------------------------------------------------------------------------------------
+// Profile Module Functions Definition
+//--------------------------------------------------------------------------------------
+void InitProfiler(void)
+{
+    profiledThread = true;
+    profileEpoch = GetProfileTime();
+    frameStart = 0;
+}
+
+void ProfileBegin(const char *name)
+{
+    if (!profiledThread) return;
+
+    // Zones nested deeper than the stack are dropped, their End() still pops correctly
+    if (stackDepth < MAX_PROFILE_DEPTH)
+    {
+        stack[stackDepth].zone = FindZone(name);
+        stack[stackDepth].start = GetProfileTime() - profileEpoch;
+    }
+
+    stackDepth++;
+}
+
+void ProfileEnd(void)
+{
+    if (!profiledThread || (stackDepth == 0)) return;
+
+    stackDepth--;
+    if (stackDepth >= MAX_PROFILE_DEPTH) return;
+
+    uint64_t end = GetProfileTime() - profileEpoch;
+    OpenZone *open = &stack[stackDepth];
+
+    if (open->zone == NULL) return;
+
+    open->zone->frameNs += end - open->start;
+
+    events[eventCount & (MAX_PROFILE_EVENTS - 1)] = (ProfileEvent){ open->zone->name, open->start, end - open->start, stackDepth };
+    eventCount++;
+}
+
+void ProfileFrame(void)
+{
+    if (!profiledThread) return;
+
+    uint64_t now = GetProfileTime() - profileEpoch;
+
+    frameHistory[frameIndex] = (frameStart > 0)? (float)((now - frameStart)*1e-6) : 0.0f;
+    frameStart = now;
+
+    for (int i = 0; i < zoneCount; i++)
+    {
+        zones[i].history[frameIndex] = (float)(zones[i].frameNs*1e-6);
+        zones[i].frameNs = 0;
+    }
+
+    frameIndex = (frameIndex + 1)%PROFILE_HISTORY;
+}
+
+int GetProfileZoneStats(ProfileZoneStats *stats, int maxCount)
+{
+    int count = (zoneCount < maxCount)? zoneCount : maxCount;
+    int last = (frameIndex + PROFILE_HISTORY - 1)%PROFILE_HISTORY;
+
+    for (int i = 0; i < count; i++)
+    {
+        float sum = 0.0f;
+        float peak = 0.0f;
+
+        for (int f = 0; f < PROFILE_HISTORY; f++)
+        {
+            sum += zones[i].history[f];
+            if (zones[i].history[f] > peak) peak = zones[i].history[f];
+        }
+
+        stats[i] = (ProfileZoneStats){ zones[i].name, zones[i].depth, zones[i].history[last], sum/PROFILE_HISTORY, peak };
+    }
+
+    return count;
+}
+
+void GetProfileFrameTimes(float *frameMs)
+{
+    for (int i = 0; i < PROFILE_HISTORY; i++) frameMs[i] = frameHistory[(frameIndex + i)%PROFILE_HISTORY];
+}
+
+// One complete ("X") event per zone, timestamps in microseconds
+bool SaveProfileTrace(const char *fileName)
+{
+    FILE *file = fopen(fileName, "w");
+    if (file == NULL) return false;
+
+    uint64_t first = (eventCount > MAX_PROFILE_EVENTS)? eventCount - MAX_PROFILE_EVENTS : 0;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (uint64_t i = first; i < eventCount; i++)
+    {
+        const ProfileEvent *event = &events[i & (MAX_PROFILE_EVENTS - 1)];
+
+        fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}\n", (i > first)? "," : "",
+                event->name, event->start*1e-3, event->duration*1e-3);
+    }
+
+    fprintf(file, "]}\n");
+
+    return (fclose(file) == 0);
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+static uint64_t GetProfileTime(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (uint64_t)(counter.QuadPart/frequency.QuadPart*1000000000ULL + counter.QuadPart%frequency.QuadPart*1000000000ULL/frequency.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec*1000000000ULL + (uint64_t)now.tv_nsec;
+#endif
+}
+
+static ProfileZone *FindZone(const char *name)
+{
+    for (int i = 0; i < zoneCount; i++)
+    {
+        if (zones[i].name == name) return &zones[i];
+    }
+
+    if (zoneCount == MAX_PROFILE_ZONES) return NULL;
+
+    zones[zoneCount].name = name;
+    zones[zoneCount].depth = stackDepth;
+
+    return &zones[zoneCount++];
+}
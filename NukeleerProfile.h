@@ -0,0 +1,50 @@
+#ifndef NUKELEER_PROFILE_H
+#define NUKELEER_PROFILE_H
+
+#include <stdbool.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define PROFILE_HISTORY         240         // Frames kept for the overlay
+#define MAX_PROFILE_ZONES       32
+#define MAX_PROFILE_DEPTH       32
+#define MAX_PROFILE_EVENTS      65536       // Most recent zones kept for the trace, power of two
+
+// Instrumentation points compile to nothing unless NUKELEER_PROFILE is defined, so the
+// rules can be timed in the game build without costing the headless tools anything.
+// Zone names must be string literals, zones are told apart by address.
+#if defined(NUKELEER_PROFILE)
+    #define PROFILE_BEGIN(name)     ProfileBegin(name)
+    #define PROFILE_END()           ProfileEnd()
+    #define PROFILE_FRAME()         ProfileFrame()
+#else
+    #define PROFILE_BEGIN(name)     ((void)0)
+    #define PROFILE_END()           ((void)0)
+    #define PROFILE_FRAME()         ((void)0)
+#endif
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ProfileZoneStats {
+    const char *name;
+    int depth;                  // Nesting level the zone was first seen at
+    float lastMs;               // Time spent in the zone during the last frame
+    float averageMs;            // Over PROFILE_HISTORY frames
+    float peakMs;
+} ProfileZoneStats;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+void InitProfiler(void);        // Only the calling thread is profiled, zones on other threads are ignored
+void ProfileBegin(const char *name);
+void ProfileEnd(void);
+void ProfileFrame(void);        // Frame boundary, closes the per-frame totals
+
+int GetProfileZoneStats(ProfileZoneStats *stats, int maxCount);
+void GetProfileFrameTimes(float *frameMs);                  // PROFILE_HISTORY values, oldest first
+bool SaveProfileTrace(const char *fileName);                // Chrome trace JSON (chrome://tracing, Perfetto)
+
+#endif // NUKELEER_PROFILE_H
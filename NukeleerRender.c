@@ -0,0 +1,169 @@
+#include "NukeleerRender.h"
+#include "NukeleerAssets.h"
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define ATLAS_SLOT_SIZE         (SQUARE_SIZE + 2)       // Room for the outline tile plus a gap
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+static AssetHandle atlasHandle = 0;
+static Texture2D atlas = { 0 };         // Copy of the registered texture, looked up once per load
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void DrawSpriteIntoAtlas(Image *image, const char *fileName, AtlasTile tile);
+
+//--------------------------------------------------------------------------------------
+// Render Module Functions Definition
+//--------------------------------------------------------------------------------------
+// Built once, later calls reuse the registered atlas
+void LoadBoardAtlas(void)
+{
+    if (atlasHandle > 0) return;
+
+    Image image = GenImageColor(TILE_COUNT*ATLAS_SLOT_SIZE, ATLAS_SLOT_SIZE, BLANK);
+
+    DrawSpriteIntoAtlas(&image, "RedBarrell.png", TILE_RED_BARREL);
+    DrawSpriteIntoAtlas(&image, "BlueBarrell.png", TILE_BLUE_BARREL);
+    DrawSpriteIntoAtlas(&image, "YellowBarrell.png", TILE_YELLOW_BARREL);
+
+    // Cell outline, covering the same pixels as the four DrawLine() calls it replaces
+    int outlineX = TILE_OUTLINE*ATLAS_SLOT_SIZE;
+    ImageDrawRectangle(&image, outlineX, 0, SQUARE_SIZE + 1, 1, GRAY);
+    ImageDrawRectangle(&image, outlineX, SQUARE_SIZE, SQUARE_SIZE + 1, 1, GRAY);
+    ImageDrawRectangle(&image, outlineX, 0, 1, SQUARE_SIZE + 1, GRAY);
+    ImageDrawRectangle(&image, outlineX + SQUARE_SIZE, 0, 1, SQUARE_SIZE + 1, GRAY);
+
+    ImageDrawRectangle(&image, TILE_FADE*ATLAS_SLOT_SIZE, 0, SQUARE_SIZE, SQUARE_SIZE, WHITE);
+
+    atlasHandle = AddTextureAsset("board atlas", LoadTextureFromImage(image));
+    atlas = GetTextureAsset(atlasHandle);
+    UnloadImage(image);
+}
+
+void UnloadBoardAtlas(void)
+{
+    UnloadAsset(atlasHandle);
+
+    atlasHandle = 0;
+    atlas = (Texture2D){ 0 };
+}
+
+void DrawAtlasTile(AtlasTile tile, int posX, int posY, Color tint)
+{
+    float size = (tile == TILE_OUTLINE)? SQUARE_SIZE + 1 : SQUARE_SIZE;
+    Rectangle source = { (float)(tile*ATLAS_SLOT_SIZE), 0, size, size };
+
+    DrawTextureRec(atlas, source, (Vector2){ (float)posX, (float)posY }, tint);
+}
+
+// All cells come from the same texture, so raylib's batcher submits the board as one draw call.
+// Empty cells are skipped, their outline comes from DrawBoardOutline().
+// view is the part of the board to draw, in board pixels, placed at posX, posY; only the cells
+// it touches are visited, and rows without a barrel are skipped whole, so the cost follows the
+// view and not the board. Cells on its edges are drawn whole, clip with a scissor if needed.
+// The falling piece is shifted by pieceOffset pixels, for drawing between simulation ticks.
+void DrawBoard(const GameContext *ctx, int posX, int posY, Rectangle view, Vector2 pieceOffset, Color fadingColor)
+{
+    int originX = posX - (int)view.x;
+    int originY = posY - (int)view.y;
+    int firstColumn = (view.x > 0)? (int)view.x/SQUARE_SIZE : 0;
+    int firstRow = (view.y > 0)? (int)view.y/SQUARE_SIZE : 0;
+    int lastColumn = (int)(view.x + view.width - 1)/SQUARE_SIZE;
+    int lastRow = (int)(view.y + view.height - 1)/SQUARE_SIZE;
+
+    if (lastColumn > ctx->width - 1) lastColumn = ctx->width - 1;
+    if (lastRow > ctx->height - 1) lastRow = ctx->height - 1;
+
+    for (int j = firstRow; j <= lastRow; j++)
+    {
+        // A completed row is all FADING and no longer counted as filled
+        if ((ctx->rowFill[j] == 0) && (GRID_CELL(ctx, 1, j) != FADING)) continue;
+
+        for (int i = firstColumn; i <= lastColumn; i++)
+        {
+            int x = originX + i*SQUARE_SIZE;
+            int y = originY + j*SQUARE_SIZE;
+
+            switch (GRID_CELL(ctx, i, j))
+            {
+                case FULL: DrawAtlasTile(GetBarrelTile(GRID_COLOR(ctx, i, j)), x, y, WHITE); break;
+                case FADING: DrawAtlasTile(TILE_FADE, x, y, fadingColor); break;
+                default: break;
+            }
+        }
+    }
+
+    // The active piece is not part of the grid until it locks
+    for (int k = 0; k < ctx->pieceCellCount; k++)
+    {
+        int i = ctx->piecePositionX + ctx->pieceCells[k].x;
+        int j = ctx->piecePositionY + ctx->pieceCells[k].y;
+
+        if ((i < firstColumn - 1) || (i > lastColumn + 1) || (j < firstRow - 1) || (j > lastRow + 1)) continue;
+
+        DrawAtlasTile(GetBarrelTile(ctx->piece.color), originX + i*SQUARE_SIZE + (int)pieceOffset.x, originY + j*SQUARE_SIZE + (int)pieceOffset.y, WHITE);
+    }
+}
+
+// Drawn every frame in board space with the same view as DrawBoard(), so the grid scrolls with
+// the barrels and matches the board size. The tiles share the atlas, so they join the board batch.
+void DrawBoardOutline(const GameContext *ctx, int posX, int posY, Rectangle view)
+{
+    int originX = posX - (int)view.x;
+    int originY = posY - (int)view.y;
+    int firstColumn = (view.x > 0)? (int)view.x/SQUARE_SIZE : 0;
+    int firstRow = (view.y > 0)? (int)view.y/SQUARE_SIZE : 0;
+    int lastColumn = (int)(view.x + view.width - 1)/SQUARE_SIZE;
+    int lastRow = (int)(view.y + view.height - 1)/SQUARE_SIZE;
+
+    // The side walls and the floor are not playable
+    if (firstColumn < 1) firstColumn = 1;
+    if (lastColumn > ctx->width - 2) lastColumn = ctx->width - 2;
+    if (lastRow > ctx->height - 2) lastRow = ctx->height - 2;
+
+    for (int j = firstRow; j <= lastRow; j++)
+    {
+        for (int i = firstColumn; i <= lastColumn; i++)
+        {
+            DrawAtlasTile(TILE_OUTLINE, originX + i*SQUARE_SIZE, originY + j*SQUARE_SIZE, WHITE);
+        }
+    }
+}
+
+void DrawRenderLayer(RenderTexture2D layer, int posX, int posY)
+{
+    // Render textures are stored upside down
+    Rectangle source = { 0, 0, (float)layer.texture.width, -(float)layer.texture.height };
+
+    DrawTextureRec(layer.texture, source, (Vector2){ (float)posX, (float)posY }, WHITE);
+}
+
+AtlasTile GetBarrelTile(BarrelColor color)
+{
+    switch (color)
+    {
+        case BARREL_BLUE: return TILE_BLUE_BARREL;
+        case BARREL_YELLOW: return TILE_YELLOW_BARREL;
+        default: return TILE_RED_BARREL;
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+// Through the registry, so the sprite comes from the pack or the prefetch when there is one
+static void DrawSpriteIntoAtlas(Image *image, const char *fileName, AtlasTile tile)
+{
+    AssetHandle handle = LoadImageAsset(fileName);
+    Image sprite = GetImageAsset(handle);
+    Rectangle source = { 0, 0, (float)sprite.width, (float)sprite.height };
+    Rectangle dest = { (float)(tile*ATLAS_SLOT_SIZE), 0, SQUARE_SIZE, SQUARE_SIZE };
+
+    ImageDraw(image, sprite, source, dest, WHITE);
+    UnloadAsset(handle);
+}
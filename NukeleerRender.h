@@ -0,0 +1,37 @@
+#ifndef NUKELEER_RENDER_H
+#define NUKELEER_RENDER_H
+
+#include "raylib.h"
+#include "NukeleerCore.h"
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define SQUARE_SIZE             30
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// Everything drawn on the playfield lives in one atlas texture, so a whole board is
+// one batch of quads instead of a texture switch or line draw per cell
+typedef enum AtlasTile {
+    TILE_RED_BARREL,
+    TILE_BLUE_BARREL,
+    TILE_YELLOW_BARREL,
+    TILE_OUTLINE,           // Gray grid-cell outline, SQUARE_SIZE + 1 wide to close the far edges
+    TILE_FADE,              // Plain white square, tinted while a line fades
+    TILE_COUNT
+} AtlasTile;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+void LoadBoardAtlas(void);                                      // Pack the barrel sprites and cell tiles
+void UnloadBoardAtlas(void);
+void DrawAtlasTile(AtlasTile tile, int posX, int posY, Color tint);
+void DrawBoard(const GameContext *ctx, int posX, int posY, Rectangle view, Vector2 pieceOffset, Color fadingColor);     // Occupied cells in view only
+void DrawBoardOutline(const GameContext *ctx, int posX, int posY, Rectangle view);     // Outline of the playable cells in view
+void DrawRenderLayer(RenderTexture2D layer, int posX, int posY);
+AtlasTile GetBarrelTile(BarrelColor color);
+
+#endif // NUKELEER_RENDER_H
@@ -0,0 +1,268 @@
+#include "NukeleerReplay.h"
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void WriteVarint(Replay *replay, uint64_t value);
+static bool ReadVarint(const Replay *replay, int *offset, uint64_t *value);
+static void ReadNextChange(ReplayPlayer *player);
+static void PutUint32(unsigned char *bytes, uint32_t value);
+static uint32_t GetUint32(const unsigned char *bytes);
+
+//--------------------------------------------------------------------------------------
+// Replay Module Functions Definition
+//--------------------------------------------------------------------------------------
+void BeginReplayRecording(Replay *replay, unsigned int seed)
+{
+    replay->seed = seed;
+    replay->gridWidth = GRID_HORIZONTAL_SIZE;
+    replay->gridHeight = GRID_VERTICAL_SIZE;
+    replay->tickCount = 0;
+    replay->finalScore = 0;
+    replay->finalHash = 0;
+    replay->size = 0;
+    replay->lastInput = 0;
+    replay->lastChangeTick = 0;
+    replay->failed = false;
+}
+
+void RecordReplayTick(Replay *replay, unsigned int input)
+{
+    input &= 0x0f;
+
+    if (input != replay->lastInput)
+    {
+        WriteVarint(replay, ((uint64_t)(replay->tickCount - replay->lastChangeTick) << 4) | input);
+        replay->lastInput = input;
+        replay->lastChangeTick = replay->tickCount;
+    }
+
+    replay->tickCount++;
+}
+
+void EndReplayRecording(Replay *replay, const GameContext *ctx)
+{
+    replay->gridWidth = ctx->width;
+    replay->gridHeight = ctx->height;
+    replay->finalScore = ctx->score;
+    replay->finalHash = GetGameHash(ctx);
+}
+
+bool SaveReplay(const Replay *replay, const char *fileName)
+{
+    unsigned char header[REPLAY_HEADER_SIZE] = { 'N', 'K', 'R', REPLAY_FILE_VERSION };
+
+    // A stream with ticks missing would only desync on playback
+    if (replay->failed) return false;
+
+    PutUint32(header + 4, replay->seed);
+    PutUint32(header + 8, replay->tickCount);
+    PutUint32(header + 12, (uint32_t)replay->finalScore);
+    PutUint32(header + 16, replay->finalHash);
+    PutUint32(header + 20, (uint32_t)replay->size);
+    PutUint32(header + 24, (uint32_t)replay->gridWidth | ((uint32_t)replay->gridHeight << 16));
+
+    FILE *file = fopen(fileName, "wb");
+    if (file == NULL) return false;
+
+    bool success = (fwrite(header, 1, REPLAY_HEADER_SIZE, file) == REPLAY_HEADER_SIZE) &&
+                   (fwrite(replay->data, 1, replay->size, file) == (size_t)replay->size);
+
+    if (fclose(file) != 0) success = false;
+
+    return success;
+}
+
+bool LoadReplay(Replay *replay, const char *fileName)
+{
+    unsigned char header[REPLAY_HEADER_SIZE] = { 0 };
+
+    memset(replay, 0, sizeof(Replay));
+
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) return false;
+
+    bool success = (fread(header, 1, REPLAY_HEADER_SIZE, file) == REPLAY_HEADER_SIZE) &&
+                   (memcmp(header, "NKR", 3) == 0) && (header[3] == REPLAY_FILE_VERSION);
+
+    if (success)
+    {
+        replay->seed = GetUint32(header + 4);
+        replay->tickCount = GetUint32(header + 8);
+        replay->finalScore = (int)GetUint32(header + 12);
+        replay->finalHash = GetUint32(header + 16);
+        replay->size = (int)GetUint32(header + 20);
+        replay->gridWidth = (int)(GetUint32(header + 24) & 0xffff);
+        replay->gridHeight = (int)(GetUint32(header + 24) >> 16);
+        replay->capacity = replay->size;
+
+        // The core would clamp a board it cannot play, and the replay would never match
+        bool board = (replay->gridWidth >= MIN_GRID_HORIZONTAL_SIZE) && (replay->gridWidth <= MAX_GRID_HORIZONTAL_SIZE) &&
+                     (replay->gridHeight >= MIN_GRID_VERTICAL_SIZE) && (replay->gridHeight <= MAX_GRID_VERTICAL_SIZE);
+
+        replay->data = malloc((replay->size > 0)? replay->size : 1);
+        success = board && (replay->size >= 0) && (replay->data != NULL) &&
+                  (fread(replay->data, 1, replay->size, file) == (size_t)replay->size);
+    }
+
+    fclose(file);
+
+    if (!success) UnloadReplay(replay);
+
+    return success;
+}
+
+void UnloadReplay(Replay *replay)
+{
+    free(replay->data);
+    memset(replay, 0, sizeof(Replay));
+}
+
+void BeginReplayPlayback(ReplayPlayer *player, const Replay *replay)
+{
+    player->replay = replay;
+    player->offset = 0;
+    player->tick = 0;
+    player->nextChangeTick = 0;
+    player->input = 0;
+
+    ReadNextChange(player);
+}
+
+bool GetReplayInput(ReplayPlayer *player, unsigned int *input)
+{
+    if (player->tick >= player->replay->tickCount) return false;
+
+    if (player->tick == player->nextChangeTick)
+    {
+        player->input = player->nextInput;
+        ReadNextChange(player);
+    }
+
+    *input = player->input;
+    player->tick++;
+
+    return true;
+}
+
+// Re-run a whole game as fast as the CPU allows and check it ends the same way
+bool RunReplay(const Replay *replay, GameContext *ctx)
+{
+    ReplayPlayer player = { 0 };
+    unsigned int input = 0;
+
+    if (!InitCoreWithRules(ctx, replay->seed, GetReplayRules(replay))) return false;
+
+    BeginReplayPlayback(&player, replay);
+
+    while (GetReplayInput(&player, &input)) UpdateCore(ctx, input);
+
+    return (ctx->score == replay->finalScore) && (GetGameHash(ctx) == replay->finalHash);
+}
+
+// FNV-1a over everything a replay has to reproduce
+unsigned int GetGameHash(const GameContext *ctx)
+{
+    uint32_t hash = 2166136261u;
+
+    // Column by column, the order the hash had when the grid was stored that way
+    for (int i = 0; i < ctx->width; i++)
+    {
+        for (int j = 0; j < ctx->height; j++)
+        {
+            hash = (hash ^ (uint32_t)GRID_CELL(ctx, i, j))*16777619u;
+            hash = (hash ^ (uint32_t)GRID_COLOR(ctx, i, j))*16777619u;
+        }
+    }
+
+    hash = (hash ^ (uint32_t)ctx->score)*16777619u;
+    hash = (hash ^ (uint32_t)ctx->lines)*16777619u;
+
+    return hash;
+}
+
+RuleSet GetReplayRules(const Replay *replay)
+{
+    RuleSet rules = GetDefaultRules();
+
+    rules.gridWidth = replay->gridWidth;
+    rules.gridHeight = replay->gridHeight;
+
+    return rules;
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+static void WriteVarint(Replay *replay, uint64_t value)
+{
+    if (replay->size + 10 > replay->capacity)
+    {
+        int capacity = (replay->capacity > 0)? replay->capacity*2 : 256;
+        unsigned char *data = realloc(replay->data, capacity);
+
+        if (data == NULL)
+        {
+            replay->failed = true;
+            return;
+        }
+
+        replay->data = data;
+        replay->capacity = capacity;
+    }
+
+    while (value >= 0x80)
+    {
+        replay->data[replay->size++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+
+    replay->data[replay->size++] = (unsigned char)value;
+}
+
+static bool ReadVarint(const Replay *replay, int *offset, uint64_t *value)
+{
+    *value = 0;
+
+    for (int shift = 0; (shift < 64) && (*offset < replay->size); shift += 7)
+    {
+        unsigned char byte = replay->data[(*offset)++];
+
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+
+    return false;
+}
+
+// Queue the next input change, or push it past the end of the replay
+static void ReadNextChange(ReplayPlayer *player)
+{
+    uint64_t value = 0;
+
+    if (ReadVarint(player->replay, &player->offset, &value))
+    {
+        player->nextChangeTick += (unsigned int)(value >> 4);
+        player->nextInput = (unsigned int)(value & 0x0f);
+    }
+    else player->nextChangeTick = UINT_MAX;
+}
+
+static void PutUint32(unsigned char *bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)value;
+    bytes[1] = (unsigned char)(value >> 8);
+    bytes[2] = (unsigned char)(value >> 16);
+    bytes[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t GetUint32(const unsigned char *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
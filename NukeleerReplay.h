@@ -0,0 +1,68 @@
+#ifndef NUKELEER_REPLAY_H
+#define NUKELEER_REPLAY_H
+
+#include "NukeleerCore.h"
+
+#include <stdbool.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define REPLAY_FILE_VERSION     4
+#define REPLAY_HEADER_SIZE      28
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// A recorded game: the piece generator seed plus the input changes, stored as
+// varint((ticks since the previous change << 4) | new input). Holding a key costs
+// nothing, so a game takes a few bytes per second of play.
+//
+// File layout (little-endian): "NKR" + version byte, seed, tick count, final score,
+// final game hash, stream size, board width and height (16 bits each), then the stream bytes.
+typedef struct Replay {
+    unsigned int seed;
+    int gridWidth;
+    int gridHeight;
+    unsigned int tickCount;
+    int finalScore;
+    unsigned int finalHash;
+
+    unsigned char *data;
+    int size;
+    int capacity;
+
+    // Recording state
+    unsigned int lastInput;
+    unsigned int lastChangeTick;
+    bool failed;                // The stream could not grow, ticks are missing and it is not saved
+} Replay;
+
+// Walks a replay's stream one tick at a time
+typedef struct ReplayPlayer {
+    const Replay *replay;
+    int offset;
+    unsigned int tick;
+    unsigned int nextChangeTick;
+    unsigned int nextInput;
+    unsigned int input;
+} ReplayPlayer;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+void BeginReplayRecording(Replay *replay, unsigned int seed);
+void RecordReplayTick(Replay *replay, unsigned int input);          // Call with the input of every UpdateCore()
+void EndReplayRecording(Replay *replay, const GameContext *ctx);    // Stores the board size, final score and hash
+bool SaveReplay(const Replay *replay, const char *fileName);        // Refuses a recording that failed
+bool LoadReplay(Replay *replay, const char *fileName);
+void UnloadReplay(Replay *replay);
+
+void BeginReplayPlayback(ReplayPlayer *player, const Replay *replay);
+bool GetReplayInput(ReplayPlayer *player, unsigned int *input);     // false once every tick was played
+
+bool RunReplay(const Replay *replay, GameContext *ctx);             // Headless, true if the result matches
+unsigned int GetGameHash(const GameContext *ctx);                  // Board, colors, score and lines
+RuleSet GetReplayRules(const Replay *replay);                       // Default rules on the recorded board
+
+#endif // NUKELEER_REPLAY_H
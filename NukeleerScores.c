@@ -0,0 +1,487 @@
+#include "NukeleerScores.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define SCORES_FILE_VERSION     1
+#define SCORES_HEADER_SIZE      4           // "NKS" + version
+#define SCORE_RECORD_SIZE       24          // score, lines, seed, time (8 bytes), CRC-32 of the first 20
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+// Index, only touched by the thread that opened the leaderboard
+static ScoreEntry *entries = NULL;          // Append order, same as the log
+static int *ranking = NULL;                 // Indices into entries, best score first, ties oldest first
+static int *timeOrder = NULL;               // Indices into entries, oldest first, for date range queries
+static int entryCount = 0;
+static int entryCapacity = 0;
+static int droppedBytes = 0;
+
+// Shared with the writer thread
+static FILE *logFile = NULL;
+static long logSize = 0;                    // Header plus every whole record, set at open then writer only
+static bool logTorn = false;                // A failed write may have left part of a batch past logSize
+static pthread_t writerThread;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueReady = PTHREAD_COND_INITIALIZER;
+static ScoreEntry queue[SCORE_QUEUE_SIZE] = { 0 };
+static int queueHead = 0;
+static int queueCount = 0;
+static int pending = 0;                     // Queued plus the batch being written
+static int failedWrites = 0;
+static bool stopWriter = false;
+static bool writerRunning = false;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void *WriteScores(void *arg);        // Writer thread: drains the queue, one sync per batch
+static bool AddToIndex(ScoreEntry entry);
+static int CompareRanking(const void *a, const void *b);
+static int CompareTimeOrder(const void *a, const void *b);
+static int FindRankingSlot(int score);      // First slot holding a lower score
+static int FindTimeSlot(int64_t time);      // First slot holding a later time
+static bool RestoreLog(void);               // Cut a torn batch off the log
+static bool SyncFile(FILE *file);
+static bool TruncateFile(FILE *file, long size);
+static void EncodeRecord(unsigned char *bytes, ScoreEntry entry);
+static bool DecodeRecord(const unsigned char *bytes, ScoreEntry *entry);
+static uint32_t GetCrc32(const unsigned char *bytes, int size);
+static void PutUint32(unsigned char *bytes, uint32_t value);
+static uint32_t GetUint32(const unsigned char *bytes);
+
+//--------------------------------------------------------------------------------------
+// Leaderboard Module Functions Definition
+//--------------------------------------------------------------------------------------
+bool OpenLeaderboard(const char *fileName)
+{
+    unsigned char header[SCORES_HEADER_SIZE] = { 'N', 'K', 'S', SCORES_FILE_VERSION };
+    unsigned char bytes[SCORES_HEADER_SIZE] = { 0 };
+    unsigned char record[SCORE_RECORD_SIZE] = { 0 };
+
+    CloseLeaderboard();
+
+    FILE *file = fopen(fileName, "rb+");
+    if (file == NULL) file = fopen(fileName, "wb+");
+    if (file == NULL) return false;
+
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    long validSize = SCORES_HEADER_SIZE;
+
+    if (fileSize < SCORES_HEADER_SIZE)
+    {
+        // New file, or a crash while the header itself was being written
+        droppedBytes = (int)fileSize;
+
+        if (!TruncateFile(file, 0) || (fseek(file, 0, SEEK_SET) != 0) ||
+            (fwrite(header, 1, SCORES_HEADER_SIZE, file) != SCORES_HEADER_SIZE) || !SyncFile(file))
+        {
+            fclose(file);
+            return false;
+        }
+    }
+    else
+    {
+        // Not ours, or a newer format: leave it alone rather than truncating it
+        if ((fread(bytes, 1, SCORES_HEADER_SIZE, file) != SCORES_HEADER_SIZE) ||
+            (memcmp(bytes, header, SCORES_HEADER_SIZE) != 0))
+        {
+            fclose(file);
+            return false;
+        }
+
+        // Records are only ever appended, so the first bad one marks where a write was torn
+        ScoreEntry entry = { 0 };
+
+        while ((fread(record, 1, SCORE_RECORD_SIZE, file) == SCORE_RECORD_SIZE) && DecodeRecord(record, &entry))
+        {
+            // Out of memory says nothing about the file: fail the open and keep every record
+            if (!AddToIndex(entry))
+            {
+                fclose(file);
+                CloseLeaderboard();
+                return false;
+            }
+
+            validSize += SCORE_RECORD_SIZE;
+        }
+
+        if (fileSize > validSize)
+        {
+            droppedBytes = (int)(fileSize - validSize);
+
+            if (!TruncateFile(file, validSize) || !SyncFile(file))
+            {
+                fclose(file);
+                CloseLeaderboard();
+                return false;
+            }
+        }
+
+        qsort(ranking, entryCount, sizeof(int), CompareRanking);
+        qsort(timeOrder, entryCount, sizeof(int), CompareTimeOrder);
+    }
+
+    // Switching from reading to writing needs a seek, and appends start at the last good record
+    fseek(file, validSize, SEEK_SET);
+
+    logFile = file;
+    logSize = validSize;
+    logTorn = false;
+    stopWriter = false;
+
+    if (pthread_create(&writerThread, NULL, WriteScores, NULL) == 0) writerRunning = true;
+
+    return true;
+}
+
+void CloseLeaderboard(void)
+{
+    if (writerRunning)
+    {
+        pthread_mutex_lock(&queueLock);
+        stopWriter = true;
+        pthread_cond_signal(&queueReady);
+        pthread_mutex_unlock(&queueLock);
+
+        pthread_join(writerThread, NULL);
+        writerRunning = false;
+    }
+
+    if (logFile != NULL) fclose(logFile);
+    logFile = NULL;
+
+    free(entries);
+    free(ranking);
+    free(timeOrder);
+    entries = NULL;
+    ranking = NULL;
+    timeOrder = NULL;
+    entryCount = 0;
+    entryCapacity = 0;
+    droppedBytes = 0;
+
+    queueHead = 0;
+    queueCount = 0;
+    pending = 0;
+    failedWrites = 0;
+}
+
+void SubmitScore(ScoreEntry entry)
+{
+    // The index is updated right away so the next query sees the score, whatever the disk does
+    int slot = FindRankingSlot(entry.score);
+    int timeSlot = FindTimeSlot(entry.time);
+
+    if (AddToIndex(entry))
+    {
+        memmove(ranking + slot + 1, ranking + slot, (entryCount - 1 - slot)*sizeof(int));
+        ranking[slot] = entryCount - 1;
+
+        // Scores normally arrive in time order, so this moves nothing
+        memmove(timeOrder + timeSlot + 1, timeOrder + timeSlot, (entryCount - 1 - timeSlot)*sizeof(int));
+        timeOrder[timeSlot] = entryCount - 1;
+    }
+
+    pthread_mutex_lock(&queueLock);
+
+    if (writerRunning && (queueCount < SCORE_QUEUE_SIZE))
+    {
+        queue[(queueHead + queueCount)%SCORE_QUEUE_SIZE] = entry;
+        queueCount++;
+        pending++;
+        pthread_cond_signal(&queueReady);
+    }
+    else failedWrites++;
+
+    pthread_mutex_unlock(&queueLock);
+}
+
+int GetBestScore(void)
+{
+    return (entryCount > 0)? entries[ranking[0]].score : 0;
+}
+
+int GetTopScores(ScoreEntry *scores, int maxCount)
+{
+    int count = (entryCount < maxCount)? entryCount : maxCount;
+
+    for (int i = 0; i < count; i++) scores[i] = entries[ranking[i]];
+
+    return count;
+}
+
+// Only visits the scores inside the range, found by binary search on the time index, and
+// keeps the best of them by insertion; ties stay earliest first
+int GetTopScoresBetween(int64_t start, int64_t end, ScoreEntry *scores, int maxCount)
+{
+    int count = 0;
+
+    for (int i = FindTimeSlot(start - 1); (i < entryCount) && (entries[timeOrder[i]].time < end); i++)
+    {
+        const ScoreEntry *entry = &entries[timeOrder[i]];
+        int slot = count;
+
+        while ((slot > 0) && (scores[slot - 1].score < entry->score)) slot--;
+
+        if (slot >= maxCount) continue;
+        if (count < maxCount) count++;
+
+        memmove(scores + slot + 1, scores + slot, (count - 1 - slot)*sizeof(ScoreEntry));
+        scores[slot] = *entry;
+    }
+
+    return count;
+}
+
+int GetScoreRank(int score)
+{
+    return FindRankingSlot(score) + 1;
+}
+
+LeaderboardStats GetLeaderboardStats(void)
+{
+    LeaderboardStats stats = { 0 };
+
+    stats.count = entryCount;
+    stats.droppedBytes = droppedBytes;
+
+    pthread_mutex_lock(&queueLock);
+    stats.pending = pending;
+    stats.failedWrites = failedWrites;
+    pthread_mutex_unlock(&queueLock);
+
+    return stats;
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+static void *WriteScores(void *arg)
+{
+    (void)arg;
+
+    ScoreEntry batch[SCORE_QUEUE_SIZE];
+    unsigned char bytes[SCORE_QUEUE_SIZE*SCORE_RECORD_SIZE];
+
+    pthread_mutex_lock(&queueLock);
+
+    for (;;)
+    {
+        while ((queueCount == 0) && !stopWriter) pthread_cond_wait(&queueReady, &queueLock);
+
+        if (queueCount == 0) break;
+
+        // Take everything queued so far; scores submitted during the sync make the next batch
+        int count = queueCount;
+
+        for (int i = 0; i < count; i++) batch[i] = queue[(queueHead + i)%SCORE_QUEUE_SIZE];
+
+        queueHead = (queueHead + count)%SCORE_QUEUE_SIZE;
+        queueCount = 0;
+
+        pthread_mutex_unlock(&queueLock);
+
+        for (int i = 0; i < count; i++) EncodeRecord(bytes + i*SCORE_RECORD_SIZE, batch[i]);
+
+        bool success = RestoreLog() && (fwrite(bytes, SCORE_RECORD_SIZE, count, logFile) == (size_t)count) && SyncFile(logFile);
+
+        // Part of the batch may be on disk. Startup stops reading at the first bad record, so
+        // it must not stay in front of the next batch; if it cannot be cut now, RestoreLog()
+        // tries again before the next write.
+        if (success) logSize += (long)count*SCORE_RECORD_SIZE;
+        else
+        {
+            logTorn = true;
+            RestoreLog();
+        }
+
+        pthread_mutex_lock(&queueLock);
+
+        pending -= count;
+        if (!success) failedWrites += count;
+    }
+
+    pthread_mutex_unlock(&queueLock);
+
+    return NULL;
+}
+
+static bool AddToIndex(ScoreEntry entry)
+{
+    if (entryCount == entryCapacity)
+    {
+        int capacity = (entryCapacity > 0)? entryCapacity*2 : 256;
+        ScoreEntry *newEntries = realloc(entries, capacity*sizeof(ScoreEntry));
+        if (newEntries == NULL) return false;
+        entries = newEntries;
+
+        int *newRanking = realloc(ranking, capacity*sizeof(int));
+        if (newRanking == NULL) return false;
+        ranking = newRanking;
+
+        int *newTimeOrder = realloc(timeOrder, capacity*sizeof(int));
+        if (newTimeOrder == NULL) return false;
+        timeOrder = newTimeOrder;
+
+        entryCapacity = capacity;
+    }
+
+    entries[entryCount] = entry;
+    ranking[entryCount] = entryCount;
+    timeOrder[entryCount] = entryCount;
+    entryCount++;
+
+    return true;
+}
+
+static int CompareRanking(const void *a, const void *b)
+{
+    int indexA = *(const int *)a;
+    int indexB = *(const int *)b;
+
+    if (entries[indexA].score != entries[indexB].score) return (entries[indexA].score > entries[indexB].score)? -1 : 1;
+
+    return indexA - indexB;
+}
+
+static int CompareTimeOrder(const void *a, const void *b)
+{
+    int indexA = *(const int *)a;
+    int indexB = *(const int *)b;
+
+    if (entries[indexA].time != entries[indexB].time) return (entries[indexA].time < entries[indexB].time)? -1 : 1;
+
+    return indexA - indexB;
+}
+
+static int FindRankingSlot(int score)
+{
+    int low = 0;
+    int high = entryCount;
+
+    while (low < high)
+    {
+        int middle = (low + high)/2;
+
+        if (entries[ranking[middle]].score >= score) low = middle + 1;
+        else high = middle;
+    }
+
+    return low;
+}
+
+static int FindTimeSlot(int64_t time)
+{
+    int low = 0;
+    int high = entryCount;
+
+    while (low < high)
+    {
+        int middle = (low + high)/2;
+
+        if (entries[timeOrder[middle]].time <= time) low = middle + 1;
+        else high = middle;
+    }
+
+    return low;
+}
+
+static bool RestoreLog(void)
+{
+    if (!logTorn) return true;
+
+    clearerr(logFile);
+
+    if ((fseek(logFile, logSize, SEEK_SET) != 0) || !TruncateFile(logFile, logSize) || !SyncFile(logFile)) return false;
+
+    logTorn = false;
+
+    return true;
+}
+
+static bool SyncFile(FILE *file)
+{
+    if (fflush(file) != 0) return false;
+
+#if defined(_WIN32)
+    return (_commit(_fileno(file)) == 0);
+#else
+    return (fsync(fileno(file)) == 0);
+#endif
+}
+
+static bool TruncateFile(FILE *file, long size)
+{
+    if (fflush(file) != 0) return false;
+
+#if defined(_WIN32)
+    return (_chsize_s(_fileno(file), size) == 0);
+#else
+    return (ftruncate(fileno(file), size) == 0);
+#endif
+}
+
+static void EncodeRecord(unsigned char *bytes, ScoreEntry entry)
+{
+    PutUint32(bytes, (uint32_t)entry.score);
+    PutUint32(bytes + 4, (uint32_t)entry.lines);
+    PutUint32(bytes + 8, entry.seed);
+    PutUint32(bytes + 12, (uint32_t)((uint64_t)entry.time & 0xffffffff));
+    PutUint32(bytes + 16, (uint32_t)((uint64_t)entry.time >> 32));
+    PutUint32(bytes + 20, GetCrc32(bytes, SCORE_RECORD_SIZE - 4));
+}
+
+static bool DecodeRecord(const unsigned char *bytes, ScoreEntry *entry)
+{
+    if (GetUint32(bytes + 20) != GetCrc32(bytes, SCORE_RECORD_SIZE - 4)) return false;
+
+    entry->score = (int)GetUint32(bytes);
+    entry->lines = (int)GetUint32(bytes + 4);
+    entry->seed = GetUint32(bytes + 8);
+    entry->time = (int64_t)((uint64_t)GetUint32(bytes + 12) | ((uint64_t)GetUint32(bytes + 16) << 32));
+
+    return true;
+}
+
+// CRC-32 (IEEE), bit by bit: records are tiny and only checked at startup
+static uint32_t GetCrc32(const unsigned char *bytes, int size)
+{
+    uint32_t crc = 0xffffffffu;
+
+    for (int i = 0; i < size; i++)
+    {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+    }
+
+    return ~crc;
+}
+
+static void PutUint32(unsigned char *bytes, uint32_t value)
+{
+    bytes[0] = (unsigned char)value;
+    bytes[1] = (unsigned char)(value >> 8);
+    bytes[2] = (unsigned char)(value >> 16);
+    bytes[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t GetUint32(const unsigned char *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
@@ -0,0 +1,48 @@
+#ifndef NUKELEER_SCORES_H
+#define NUKELEER_SCORES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define LEADERBOARD_FILE_NAME   "scores.nks"
+#define SCORE_QUEUE_SIZE        64          // Scores waiting for the writer thread
+#define SECONDS_PER_DAY         86400
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct ScoreEntry {
+    int score;
+    int lines;
+    unsigned int seed;          // Replays are saved as replay_<seed>.nkr
+    int64_t time;               // Seconds since the epoch, when the game ended
+} ScoreEntry;
+
+typedef struct LeaderboardStats {
+    int count;                  // Scores in the index
+    int droppedBytes;           // Torn or corrupt tail cut off at startup
+    int pending;                // Submitted, not yet synced to disk
+    int failedWrites;           // Queue full or write error, kept in memory only
+} LeaderboardStats;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+// Every score is appended to a checksummed log. Opening replays the log into an index
+// sorted by score, and cuts off a last record that a crash left half-written. Submitted
+// scores go into the index right away; a background thread writes them in batches,
+// with one fsync per batch. The index belongs to the thread that opened the leaderboard.
+bool OpenLeaderboard(const char *fileName);     // Missing file is fine, the log starts empty
+void CloseLeaderboard(void);                    // Writes and syncs whatever is still queued
+void SubmitScore(ScoreEntry entry);             // Never waits for the disk
+
+int GetBestScore(void);
+int GetTopScores(ScoreEntry *scores, int maxCount);                            // Best first
+int GetTopScoresBetween(int64_t start, int64_t end, ScoreEntry *scores, int maxCount);  // Scores with start <= time < end
+int GetScoreRank(int score);                    // 1-based place a score of this size would take
+LeaderboardStats GetLeaderboardStats(void);
+
+#endif // NUKELEER_SCORES_H
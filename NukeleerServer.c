@@ -0,0 +1,557 @@
+// Authoritative match server: every client plays its game locally and sends only its
+// input changes; the server replays the same ticks on its own copy of each game, so
+// scores, garbage and the winner never depend on what a client claims. Sessions are
+// ticked at 60 Hz in batches spread over every core.
+//
+// Usage: NukeleerServer [port] [threads] [seconds]       seconds 0 runs until killed
+
+#include "NukeleerCore.h"
+#include "NukeleerBatch.h"
+#include "NukeleerReplay.h"
+#include "NukeleerNet.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#endif
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define MAX_SERVER_CLIENTS      16384
+#define SESSIONS_PER_BATCH      64          // Sessions one worker ticks in a row
+#define SERVER_TICK_TIME        (1.0/60.0)
+#define MAX_TICK_LEAD           60          // Ticks a game may run ahead of its session clock before it waits
+#define MAX_FRAME_BACKLOG       0.25        // Seconds; after a longer stall the clock skips ahead
+#define CLIENT_EVENT_QUEUE      64          // Inputs not yet played; a full queue drops the client
+#define MAX_PENDING_GARBAGE     16          // Garbage sent but not yet confirmed
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef enum ClientState { CLIENT_IDLE, CLIENT_WAITING, CLIENT_PLAYING } ClientState;
+
+// NET_INPUT or NET_GARBAGE_TAKEN, played in order by the session's worker
+typedef struct ClientEvent {
+    int type;
+    uint32_t tick;
+    unsigned int input;
+} ClientEvent;
+
+typedef struct PendingGarbage {
+    int rows;
+    unsigned int seed;
+} PendingGarbage;
+
+typedef struct ServerClient {
+    NetConnection connection;
+    ClientState state;
+    int session;                // Index into the session list while playing
+    int player;
+
+    ClientEvent events[CLIENT_EVENT_QUEUE];
+    int eventHead;
+    int eventCount;
+
+    // Authoritative copy of the client's game
+    GameContext ctx;
+    uint32_t tick;
+    unsigned int input;
+    PendingGarbage garbage[MAX_PENDING_GARBAGE];
+    int garbageHead;
+    int garbageCount;
+} ServerClient;
+
+// One match. Only the worker ticking it touches its players until the frame ends.
+typedef struct Session {
+    ServerClient *players[2];
+    int playerCount;
+    uint32_t frame;             // Session clock, one per server tick
+    unsigned int garbageState;
+    int ticks;                  // Game ticks played this frame
+    bool ended;
+} Session;
+
+typedef struct Server {
+    NetSocket listener;
+    ServerClient **clients;
+    int clientCount;
+    NetPollEntry *pollEntries;
+    ServerClient *waiting;      // Asked for a match, no opponent yet
+
+    Session *sessions;
+    int sessionCount;
+    int sessionCapacity;
+    unsigned int seedState;
+
+    // Statistics since the last report
+    long long matches;
+    long long ticks;
+    long long bytesIn;
+    long long bytesOut;
+    int frames;
+    int dropped;
+    double workTime;
+    double maxWorkTime;
+} Server;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void AcceptClients(Server *server);
+static void ReadClient(Server *server, ServerClient *client);
+static void StartSession(Server *server, ServerClient **players, int playerCount);
+static void TickSessions(GameContext *unused, int batchIndex, void *userData);     // Batch callback
+static void TickSession(Session *session);
+static void AdvancePlayer(Session *session, int player, uint32_t tick);
+static void SendGarbage(Session *session, ServerClient *target, int rows);
+static void SendState(Session *session, int player);
+static void EndSessions(Server *server);
+static void FlushClients(Server *server);
+static void RemoveClosedClients(Server *server);
+static void PrintStats(Server *server, double seconds);
+static double GetServerTime(void);
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    int port = (argc > 1)? atoi(argv[1]) : NET_DEFAULT_PORT;
+    int threads = (argc > 2)? atoi(argv[2]) : 0;
+    double duration = (argc > 3)? atof(argv[3]) : 0.0;
+
+    if (threads <= 0) threads = GetProcessorCount();
+
+    if (!InitNet()) return 1;
+
+    int fileLimit = RaiseOpenFileLimit(MAX_SERVER_CLIENTS + 64);
+
+    Server server = { 0 };
+    server.listener = ListenNet(port, true);
+    server.clients = calloc(MAX_SERVER_CLIENTS, sizeof(ServerClient *));
+    server.pollEntries = calloc(MAX_SERVER_CLIENTS + 1, sizeof(NetPollEntry));
+    server.seedState = (unsigned int)time(NULL);
+
+    if (server.listener == INVALID_NET_SOCKET)
+    {
+        printf("could not listen on port %i\n", port);
+        return 1;
+    }
+
+    if ((server.clients == NULL) || (server.pollEntries == NULL)) return 1;
+
+    printf("listening on 127.0.0.1:%i, %i threads, %i open files\n", port, threads, fileLimit);
+
+    double start = GetServerTime();
+    double nextFrame = start;
+    double nextReport = start + 1.0;
+
+    while ((duration <= 0.0) || (GetServerTime() - start < duration))
+    {
+        double now = GetServerTime();
+        int timeout = (nextFrame > now)? (int)((nextFrame - now)*1000.0) : 0;
+
+        // Entry 0 is the listener, then one per client in list order. Closed clients are
+        // left out, their socket would report readable until it is removed.
+        server.pollEntries[0] = (NetPollEntry){ .fd = server.listener, .events = NET_POLL_IN };
+
+        for (int i = 0; i < server.clientCount; i++)
+        {
+            const NetConnection *connection = &server.clients[i]->connection;
+            server.pollEntries[i + 1] = (NetPollEntry){ .fd = connection->closed? INVALID_NET_SOCKET : connection->socket, .events = NET_POLL_IN };
+        }
+
+        if (PollNet(server.pollEntries, server.clientCount + 1, timeout) > 0)
+        {
+            int polledCount = server.clientCount;
+
+            for (int i = 0; i < polledCount; i++)
+            {
+                if (server.pollEntries[i + 1].revents != 0) ReadClient(&server, server.clients[i]);
+            }
+
+            if (server.pollEntries[0].revents & NET_POLL_IN) AcceptClients(&server);
+        }
+
+        now = GetServerTime();
+        if (now < nextFrame) continue;
+
+        double workStart = now;
+
+        RunBatch((server.sessionCount + SESSIONS_PER_BATCH - 1)/SESSIONS_PER_BATCH, threads, TickSessions, &server);
+        EndSessions(&server);
+        FlushClients(&server);
+        RemoveClosedClients(&server);
+
+        double workTime = GetServerTime() - workStart;
+        server.workTime += workTime;
+        if (workTime > server.maxWorkTime) server.maxWorkTime = workTime;
+        server.frames++;
+
+        nextFrame += SERVER_TICK_TIME;
+        if (now - nextFrame > MAX_FRAME_BACKLOG) nextFrame = now;
+
+        if (now >= nextReport)
+        {
+            PrintStats(&server, now - nextReport + 1.0);
+            nextReport = now + 1.0;
+        }
+    }
+
+    for (int i = 0; i < server.clientCount; i++)
+    {
+        CloseNetConnection(&server.clients[i]->connection);
+        UnloadCore(&server.clients[i]->ctx);
+        free(server.clients[i]);
+    }
+
+    CloseNetSocket(server.listener);
+    free(server.clients);
+    free(server.pollEntries);
+    free(server.sessions);
+    CloseNet();
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------
+// Module Functions Definition
+//--------------------------------------------------------------------------------------
+static void AcceptClients(Server *server)
+{
+    while (server->clientCount < MAX_SERVER_CLIENTS)
+    {
+        NetSocket socket = AcceptNet(server->listener);
+        if (socket == INVALID_NET_SOCKET) break;
+
+        ServerClient *client = calloc(1, sizeof(ServerClient));
+
+        if (client == NULL)
+        {
+            CloseNetSocket(socket);
+            break;
+        }
+
+        InitNetConnection(&client->connection, socket);
+        client->session = -1;
+        server->clients[server->clientCount++] = client;
+    }
+}
+
+// Matchmaking happens here on the main thread; inputs are only queued for the session's worker
+static void ReadClient(Server *server, ServerClient *client)
+{
+    NetMessage message = { 0 };
+    long long bytesIn = client->connection.bytesIn;
+
+    ReceiveNet(&client->connection);
+    server->bytesIn += client->connection.bytesIn - bytesIn;
+
+    while (!client->connection.closed && GetNetMessage(&client->connection, &message))
+    {
+        switch (message.type)
+        {
+            case NET_HELLO:
+            {
+                if (message.fields[0] != NET_PROTOCOL_VERSION) client->connection.closed = true;
+                else if (client->state != CLIENT_IDLE) break;
+                else if (message.fields[1] == 1) StartSession(server, &client, 1);
+                else if ((server->waiting != NULL) && !server->waiting->connection.closed)
+                {
+                    ServerClient *players[2] = { server->waiting, client };
+
+                    server->waiting = NULL;
+                    StartSession(server, players, 2);
+                }
+                else
+                {
+                    client->state = CLIENT_WAITING;
+                    server->waiting = client;
+                }
+            } break;
+            case NET_INPUT:
+            case NET_GARBAGE_TAKEN:
+            {
+                // Inputs still in flight when a match ended are expected, and dropped
+                if (client->state != CLIENT_PLAYING) break;
+
+                if (client->eventCount == CLIENT_EVENT_QUEUE)
+                {
+                    client->connection.closed = true;
+                    break;
+                }
+
+                ClientEvent *event = &client->events[(client->eventHead + client->eventCount)%CLIENT_EVENT_QUEUE];
+                event->type = message.type;
+                event->tick = message.fields[0];
+                event->input = message.fields[1];
+                client->eventCount++;
+            } break;
+            default: client->connection.closed = true; break;
+        }
+    }
+}
+
+static void StartSession(Server *server, ServerClient **players, int playerCount)
+{
+    if (server->sessionCount == server->sessionCapacity)
+    {
+        int capacity = (server->sessionCapacity > 0)? server->sessionCapacity*2 : 256;
+        Session *sessions = realloc(server->sessions, capacity*sizeof(Session));
+
+        if (sessions == NULL)
+        {
+            for (int p = 0; p < playerCount; p++) players[p]->connection.closed = true;
+            return;
+        }
+
+        server->sessions = sessions;
+        server->sessionCapacity = capacity;
+    }
+
+    server->seedState = server->seedState*1103515245u + 12345u;
+    unsigned int seed = server->seedState;
+
+    Session *session = &server->sessions[server->sessionCount];
+    memset(session, 0, sizeof(Session));
+    session->playerCount = playerCount;
+    session->garbageState = seed ^ 0x9e3779b9u;
+
+    for (int p = 0; p < playerCount; p++)
+    {
+        ServerClient *client = players[p];
+        uint32_t fields[3] = { seed, (uint32_t)p, (uint32_t)playerCount };
+
+        session->players[p] = client;
+        client->state = CLIENT_PLAYING;
+        client->session = server->sessionCount;
+        client->player = p;
+        client->eventHead = 0;
+        client->eventCount = 0;
+        client->garbageHead = 0;
+        client->garbageCount = 0;
+        client->tick = 0;
+        client->input = 0;
+
+        if (!InitCore(&client->ctx, seed)) client->connection.closed = true;
+        SendNetMessage(&client->connection, NET_START, fields);
+    }
+
+    server->sessionCount++;
+    server->matches++;
+}
+
+static void TickSessions(GameContext *unused, int batchIndex, void *userData)
+{
+    Server *server = (Server *)userData;
+    int first = batchIndex*SESSIONS_PER_BATCH;
+    int last = first + SESSIONS_PER_BATCH;
+
+    (void)unused;
+    if (last > server->sessionCount) last = server->sessionCount;
+
+    for (int s = first; s < last; s++) TickSession(&server->sessions[s]);
+}
+
+// Play every input a player has sent, as far as the session clock allows, then end the
+// match once someone tops out or leaves
+static void TickSession(Session *session)
+{
+    if (session->ended) return;
+
+    session->frame++;
+    session->ticks = 0;
+
+    for (int p = 0; p < session->playerCount; p++)
+    {
+        ServerClient *client = session->players[p];
+
+        while ((client->eventCount > 0) && !client->connection.closed)
+        {
+            ClientEvent *event = &client->events[client->eventHead];
+
+            if (event->tick > session->frame + MAX_TICK_LEAD) break;
+
+            // Time only moves forward, and garbage is only taken once it was sent
+            if ((event->tick < client->tick) || ((event->type == NET_GARBAGE_TAKEN) && (client->garbageCount == 0)))
+            {
+                client->connection.closed = true;
+                break;
+            }
+
+            AdvancePlayer(session, p, event->tick);
+
+            if (event->type == NET_INPUT) client->input = event->input;
+            else
+            {
+                PendingGarbage *garbage = &client->garbage[client->garbageHead];
+
+                QueueGarbage(&client->ctx, garbage->rows, garbage->seed);
+                client->garbageHead = (client->garbageHead + 1)%MAX_PENDING_GARBAGE;
+                client->garbageCount--;
+            }
+
+            client->eventHead = (client->eventHead + 1)%CLIENT_EVENT_QUEUE;
+            client->eventCount--;
+        }
+    }
+
+    bool lost[2] = { false };
+    int lostCount = 0;
+
+    for (int p = 0; p < session->playerCount; p++)
+    {
+        lost[p] = session->players[p]->connection.closed || session->players[p]->ctx.gameOver;
+        if (lost[p]) lostCount++;
+    }
+
+    if (lostCount == 0) return;
+
+    uint32_t winner[1] = { NET_NO_WINNER };
+    if ((session->playerCount == 2) && (lostCount == 1)) winner[0] = lost[0]? 1 : 0;
+
+    for (int p = 0; p < session->playerCount; p++) SendNetMessage(&session->players[p]->connection, NET_END, winner);
+
+    session->ended = true;
+}
+
+static void AdvancePlayer(Session *session, int player, uint32_t tick)
+{
+    ServerClient *client = session->players[player];
+    ServerClient *opponent = (session->playerCount > 1)? session->players[1 - player] : NULL;
+
+    while ((client->tick < tick) && !client->ctx.gameOver)
+    {
+        int lines = client->ctx.lines;
+
+        UpdateCore(&client->ctx, client->input);
+        client->tick++;
+        session->ticks++;
+
+        if ((opponent != NULL) && (client->ctx.lines > lines)) SendGarbage(session, opponent, client->ctx.lines - lines);
+        if ((client->tick%NET_STATE_TICKS) == 0) SendState(session, player);
+    }
+}
+
+// The rows are raised on the server when the target confirms the tick it raised them at
+static void SendGarbage(Session *session, ServerClient *target, int rows)
+{
+    if (target->garbageCount == MAX_PENDING_GARBAGE)
+    {
+        target->connection.closed = true;
+        return;
+    }
+
+    session->garbageState = session->garbageState*1103515245u + 12345u;
+
+    PendingGarbage *garbage = &target->garbage[(target->garbageHead + target->garbageCount)%MAX_PENDING_GARBAGE];
+    garbage->rows = rows;
+    garbage->seed = session->garbageState;
+    target->garbageCount++;
+
+    uint32_t fields[2] = { (uint32_t)rows, garbage->seed };
+    SendNetMessage(&target->connection, NET_GARBAGE, fields);
+}
+
+static void SendState(Session *session, int player)
+{
+    const ServerClient *client = session->players[player];
+    uint32_t fields[5] = { (uint32_t)player, client->tick, (uint32_t)client->ctx.score, (uint32_t)client->ctx.lines, GetGameHash(&client->ctx) };
+
+    for (int p = 0; p < session->playerCount; p++) SendNetMessage(&session->players[p]->connection, NET_STATE, fields);
+}
+
+// Players of ended matches go back to idle and may ask for another one
+static void EndSessions(Server *server)
+{
+    for (int s = server->sessionCount - 1; s >= 0; s--)
+    {
+        Session *session = &server->sessions[s];
+
+        server->ticks += session->ticks;
+        if (!session->ended) continue;
+
+        for (int p = 0; p < session->playerCount; p++)
+        {
+            session->players[p]->state = CLIENT_IDLE;
+            session->players[p]->session = -1;
+            session->players[p]->eventCount = 0;
+        }
+
+        *session = server->sessions[--server->sessionCount];
+        for (int p = 0; p < session->playerCount; p++) session->players[p]->session = s;
+    }
+}
+
+static void FlushClients(Server *server)
+{
+    for (int i = 0; i < server->clientCount; i++)
+    {
+        NetConnection *connection = &server->clients[i]->connection;
+        long long bytesOut = connection->bytesOut;
+
+        if (connection->outSize > 0) FlushNet(connection);
+        server->bytesOut += connection->bytesOut - bytesOut;
+    }
+}
+
+// A client that left mid-match stays until its session noticed and ended
+static void RemoveClosedClients(Server *server)
+{
+    for (int i = server->clientCount - 1; i >= 0; i--)
+    {
+        ServerClient *client = server->clients[i];
+
+        if (!client->connection.closed || (client->state == CLIENT_PLAYING)) continue;
+
+        if (server->waiting == client) server->waiting = NULL;
+
+        CloseNetConnection(&client->connection);
+        UnloadCore(&client->ctx);
+        free(client);
+
+        server->clients[i] = server->clients[--server->clientCount];
+        server->dropped++;
+    }
+}
+
+static void PrintStats(Server *server, double seconds)
+{
+    printf("clients: %i  sessions: %i  matches: %lld  ticks/s: %.0f  frames: %i  work: %.3f ms avg %.3f ms max  in: %.1f KB/s  out: %.1f KB/s  left: %i\n",
+           server->clientCount, server->sessionCount, server->matches, server->ticks/seconds, server->frames,
+           (server->frames > 0)? server->workTime*1000.0/server->frames : 0.0, server->maxWorkTime*1000.0,
+           server->bytesIn/1024.0/seconds, server->bytesOut/1024.0/seconds, server->dropped);
+    fflush(stdout);
+
+    server->matches = 0;
+    server->ticks = 0;
+    server->bytesIn = 0;
+    server->bytesOut = 0;
+    server->frames = 0;
+    server->dropped = 0;
+    server->workTime = 0.0;
+    server->maxWorkTime = 0.0;
+}
+
+static double GetServerTime(void)
+{
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart/(double)frequency.QuadPart;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + now.tv_nsec*1e-9;
+#endif
+}
@@ -0,0 +1,218 @@
+// Headless simulation runner: plays whole games through the rules core with no
+// window, GL context or audio device, spread across every core, as fast as the
+// CPU allows.
+//
+// Usage: NukeleerSim [games] [seed] [threads]
+//        NukeleerSim --autoplay [games] [seed] [threads] [ms]   Let the autoplayer play, ms per move
+//        NukeleerSim --replay <file.nkr>      Re-run a recorded game and verify it
+
+#include "NukeleerCore.h"
+#include "NukeleerBatch.h"
+#include "NukeleerReplay.h"
+#include "NukeleerAutoplay.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define MAX_GAME_TICKS          1000000     // Safety cap, a game normally ends well before
+#define INPUT_HOLD_TICKS        20          // Ticks a random key combination is held
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct GameResult {
+    int score;
+    int ticks;
+    int decisions;              // Autoplayer statistics, zero otherwise
+    int depthSum;
+    int replans;
+    int overruns;
+    double maxDecisionTime;
+} GameResult;
+
+typedef struct SimJob {
+    unsigned int seed;
+    bool autoplay;
+    double budget;
+    GameResult *results;
+} SimJob;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static int VerifyReplay(const char *fileName);
+static unsigned int GetRandomInput(unsigned int *state);
+static void PlayGame(GameContext *ctx, int gameIndex, void *userData);
+static double GetWallTime(void);
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    if ((argc > 2) && (strcmp(argv[1], "--replay") == 0)) return VerifyReplay(argv[2]);
+
+    bool autoplay = (argc > 1) && (strcmp(argv[1], "--autoplay") == 0);
+
+    if (autoplay)
+    {
+        argc--;
+        argv++;
+    }
+
+    int games = (argc > 1)? atoi(argv[1]) : 1000;
+    unsigned int seed = (argc > 2)? (unsigned int)strtoul(argv[2], NULL, 10) : 1;
+    int threads = (argc > 3)? atoi(argv[3]) : 0;
+
+    if (games <= 0) return 0;
+    if (threads <= 0) threads = GetProcessorCount();
+
+    SimJob job = { 0 };
+    job.seed = seed;
+    job.autoplay = autoplay;
+    job.budget = (autoplay && (argc > 4))? atof(argv[4])/1000.0 : AUTOPLAY_BUDGET;
+    job.results = calloc(games, sizeof(GameResult));
+
+    if (job.results == NULL) return 1;
+
+    double start = GetWallTime();
+
+    RunBatch(games, threads, PlayGame, &job);
+
+    double seconds = GetWallTime() - start;
+    if (seconds <= 0.0) seconds = 1e-9;
+
+    long long totalTicks = 0;
+    long long totalScore = 0;
+    long long decisions = 0;
+    long long depthSum = 0;
+    long long replans = 0;
+    long long overruns = 0;
+    double maxDecisionTime = 0.0;
+
+    for (int g = 0; g < games; g++)
+    {
+        totalTicks += job.results[g].ticks;
+        totalScore += job.results[g].score;
+        decisions += job.results[g].decisions;
+        depthSum += job.results[g].depthSum;
+        replans += job.results[g].replans;
+        overruns += job.results[g].overruns;
+        if (job.results[g].maxDecisionTime > maxDecisionTime) maxDecisionTime = job.results[g].maxDecisionTime;
+    }
+
+    printf("games: %i\n", games);
+    printf("threads: %i\n", threads);
+    printf("ticks: %lld\n", totalTicks);
+    printf("average score: %.2f\n", (double)totalScore/games);
+    printf("games/s: %.1f\n", games/seconds);
+    printf("ticks/s: %.0f\n", totalTicks/seconds);
+
+    if (autoplay && (decisions > 0))
+    {
+        printf("decisions: %lld (%lld replanned)\n", decisions, replans);
+        printf("average depth: %.2f\n", (double)depthSum/decisions);
+        printf("max decision: %.3f ms (budget %.3f ms)\n", maxDecisionTime*1000.0, job.budget*1000.0);
+        if (job.budget > 0.0) printf("over budget: %lld decisions (%.2f%%)\n", overruns, 100.0*overruns/decisions);
+    }
+
+    free(job.results);
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------
+// Module Functions Definition
+//--------------------------------------------------------------------------------------
+
+// Play a replay back headless and compare the final score and board
+static int VerifyReplay(const char *fileName)
+{
+    Replay replay = { 0 };
+    GameContext ctx = { 0 };
+
+    if (!LoadReplay(&replay, fileName))
+    {
+        printf("could not load replay: %s\n", fileName);
+        return 1;
+    }
+
+    double start = GetWallTime();
+    bool match = RunReplay(&replay, &ctx);
+    double seconds = GetWallTime() - start;
+
+    printf("seed: %u\n", replay.seed);
+    printf("ticks: %u (%.1f s of play in %.3f ms)\n", replay.tickCount, replay.tickCount/60.0, seconds*1000.0);
+    printf("stream: %i bytes (%.2f bytes/s of play)\n", replay.size, (replay.tickCount > 0)? replay.size*60.0/replay.tickCount : 0.0);
+    printf("score: %i (recorded %i)\n", ctx.score, replay.finalScore);
+    printf("result: %s\n", match? "match" : "MISMATCH");
+
+    UnloadReplay(&replay);
+    UnloadCore(&ctx);
+
+    return match? 0 : 2;
+}
+
+// Pick a held key combination, roughly what a button-mashing player would do
+static unsigned int GetRandomInput(unsigned int *state)
+{
+    static const unsigned int choices[] = {
+        0, INPUT_LEFT, INPUT_RIGHT, INPUT_DOWN, INPUT_LEFT | INPUT_DOWN, INPUT_RIGHT | INPUT_DOWN
+    };
+
+    *state = *state*1103515245u + 12345u;
+
+    return choices[((*state >> 16) & 0x7fff)%(sizeof(choices)/sizeof(choices[0]))];
+}
+
+// Play one game to the end; seeds depend only on the game index, never on the thread
+static void PlayGame(GameContext *ctx, int gameIndex, void *userData)
+{
+    SimJob *job = (SimJob *)userData;
+    unsigned int gameSeed = job->seed + (unsigned int)gameIndex*2654435761u;
+    unsigned int inputState = ~gameSeed;
+    unsigned int input = 0;
+    int ticks = 0;
+    Autoplayer ai = { 0 };
+
+    if (job->autoplay && !InitAutoplayer(&ai, job->budget)) return;
+
+    InitCore(ctx, gameSeed);
+
+    for (ticks = 0; ticks < MAX_GAME_TICKS; ticks++)
+    {
+        if (job->autoplay) input = GetAutoplayInput(&ai, ctx);
+        else if ((ticks%INPUT_HOLD_TICKS) == 0) input = GetRandomInput(&inputState);
+
+        UpdateCore(ctx, input);
+
+        if (ctx->gameOver) break;
+    }
+
+    job->results[gameIndex].score = ctx->score;
+    job->results[gameIndex].ticks = ticks;
+
+    if (job->autoplay)
+    {
+        job->results[gameIndex].decisions = ai.decisions;
+        job->results[gameIndex].depthSum = ai.depthSum;
+        job->results[gameIndex].replans = ai.replans;
+        job->results[gameIndex].overruns = ai.overruns;
+        job->results[gameIndex].maxDecisionTime = ai.maxDecisionTime;
+
+        CloseAutoplayer(&ai);
+    }
+}
+
+static double GetWallTime(void)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+
+    return (double)now.tv_sec + now.tv_nsec*1e-9;
+}
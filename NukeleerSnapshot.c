@@ -0,0 +1,535 @@
+#include "NukeleerSnapshot.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+// Snapshot layout: kind byte, varint sequence, then
+//   keyframe: varint width, varint height, every field, then (varint run, cell byte) pairs
+//             covering the board row by row
+//   delta:    field mask byte, the fields in the mask, then (varint gap, varint run - 1,
+//             cell byte) for each run of changed cells holding the same new value
+// Fields are zigzag varints of the difference to the previous snapshot (to zero in a keyframe).
+#define SNAPSHOT_KEYFRAME       1
+#define SNAPSHOT_DELTA          2
+
+#define SNAPSHOT_SCORE          0x01        // score
+#define SNAPSHOT_LINES          0x02        // lines, level
+#define SNAPSHOT_STATUS         0x04        // flags, fade counter
+#define SNAPSHOT_PIECE          0x08        // piece position
+#define SNAPSHOT_SHAPE          0x10        // piece color and cells
+#define SNAPSHOT_NEXT           0x20        // incoming piece
+#define SNAPSHOT_CELLS          0x40        // cell runs follow
+#define SNAPSHOT_FIELDS         0x3f
+
+#define SNAPSHOT_FLAG_PIECE_ACTIVE      0x01
+#define SNAPSHOT_FLAG_LINE_TO_DELETE    0x02
+#define SNAPSHOT_FLAG_GAME_OVER         0x04
+#define SNAPSHOT_FLAG_GAME_OVER_TRIGGERED 0x08
+
+#define SNAPSHOT_HEADER_SIZE    160         // Upper bound for everything but the cells
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct SnapshotReader {
+    const unsigned char *data;
+    int size;
+    int offset;
+    bool failed;                // Ran past the end or read an invalid value
+} SnapshotReader;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static bool ReserveSnapshot(SnapshotEncoder *encoder, int width, int height);
+static SnapshotState GetSnapshotState(const GameContext *ctx);
+static unsigned int GetChangedFields(const SnapshotState *state, const SnapshotState *previous);
+static unsigned char PackCell(const GameContext *ctx, int index);
+static int WriteKeyframe(SnapshotEncoder *encoder, const GameContext *ctx, const SnapshotState *state);
+static int WriteDelta(SnapshotEncoder *encoder, const GameContext *ctx, const SnapshotState *state);    // -1 when a keyframe is smaller
+static unsigned char *WriteFields(unsigned char *out, unsigned int mask, const SnapshotState *state, const SnapshotState *previous);
+static bool ReadFields(SnapshotReader *reader, unsigned int mask, SnapshotState *state);
+static void SetViewState(GameContext *view, const SnapshotState *state);
+static bool SetViewCell(GameContext *view, int index, unsigned char cell);
+static unsigned char *WriteVarint(unsigned char *out, uint32_t value);
+static unsigned char *WriteSigned(unsigned char *out, int value);
+static uint32_t ReadVarint(SnapshotReader *reader);
+static int ReadSigned(SnapshotReader *reader);
+static int ReadByte(SnapshotReader *reader);
+
+//--------------------------------------------------------------------------------------
+// Snapshot Module Functions Definition
+//--------------------------------------------------------------------------------------
+int EncodeSnapshot(SnapshotEncoder *encoder, const GameContext *ctx)
+{
+    bool keyframe = encoder->keyframeWanted || (encoder->cells == NULL) || (encoder->width != ctx->width) ||
+                    (encoder->height != ctx->height) || (encoder->sinceKeyframe >= SNAPSHOT_KEYFRAME_TICKS);
+
+    if (!ReserveSnapshot(encoder, ctx->width, ctx->height)) return 0;
+
+    SnapshotState state = GetSnapshotState(ctx);
+
+    encoder->size = keyframe? -1 : WriteDelta(encoder, ctx, &state);
+    if (encoder->size < 0) encoder->size = WriteKeyframe(encoder, ctx, &state);
+
+    encoder->state = state;
+    encoder->stackTop = ctx->stackTop;
+    encoder->sequence++;
+
+    return encoder->size;
+}
+
+void RequestKeyframe(SnapshotEncoder *encoder)
+{
+    encoder->keyframeWanted = true;
+}
+
+void UnloadSnapshotEncoder(SnapshotEncoder *encoder)
+{
+    free(encoder->cells);
+    free(encoder->data);
+    memset(encoder, 0, sizeof(SnapshotEncoder));
+}
+
+bool IsSnapshotKeyframe(const unsigned char *data, int size)
+{
+    return (size > 0) && (data[0] == SNAPSHOT_KEYFRAME);
+}
+
+bool DecodeSnapshot(SnapshotDecoder *decoder, GameContext *view, const unsigned char *data, int size)
+{
+    SnapshotReader reader = { data, size, 0, false };
+    int kind = ReadByte(&reader);
+    uint32_t sequence = ReadVarint(&reader);
+
+    if (reader.failed) return false;
+
+    if (kind == SNAPSHOT_KEYFRAME)
+    {
+        int width = (int)ReadVarint(&reader);
+        int height = (int)ReadVarint(&reader);
+        SnapshotState state = { 0 };
+
+        decoder->synced = false;
+
+        if (reader.failed || (width < MIN_GRID_HORIZONTAL_SIZE) || (width > MAX_GRID_HORIZONTAL_SIZE) ||
+            (height < MIN_GRID_VERTICAL_SIZE) || (height > MAX_GRID_VERTICAL_SIZE)) return false;
+
+        if ((view->grid == NULL) || (view->width != width) || (view->height != height))
+        {
+            RuleSet rules = GetDefaultRules();
+            rules.gridWidth = width;
+            rules.gridHeight = height;
+
+            if (!InitCoreWithRules(view, 0, rules)) return false;
+        }
+
+        if (!ReadFields(&reader, SNAPSHOT_FIELDS, &state)) return false;
+
+        memset(view->grid, 0, width*height*sizeof(GridSquare));
+        memset(view->rowFill, 0, height*sizeof(int));
+
+        for (int index = 0; index < width*height; )
+        {
+            int run = (int)ReadVarint(&reader);
+            int cell = ReadByte(&reader);
+
+            if (reader.failed || (run <= 0) || (run > width*height - index)) return false;
+
+            for (int k = 0; k < run; k++)
+            {
+                if (!SetViewCell(view, index + k, (unsigned char)cell)) return false;
+            }
+
+            index += run;
+        }
+
+        SetViewState(view, &state);
+        decoder->synced = true;
+        decoder->keyframes++;
+    }
+    else if (kind == SNAPSHOT_DELTA)
+    {
+        // A lost delta leaves the board wrong until the next keyframe, so wait for it
+        if (!decoder->synced || (sequence != decoder->sequence + 1))
+        {
+            decoder->synced = false;
+            decoder->skipped++;
+            return false;
+        }
+
+        int mask = ReadByte(&reader);
+        SnapshotState state = GetSnapshotState(view);
+
+        if (reader.failed || !ReadFields(&reader, (unsigned int)mask, &state)) return false;
+
+        if (mask & SNAPSHOT_CELLS)
+        {
+            int index = 0;
+
+            while (!reader.failed && (reader.offset < reader.size))
+            {
+                index += (int)ReadVarint(&reader);
+                int run = (int)ReadVarint(&reader) + 1;
+                int cell = ReadByte(&reader);
+
+                if ((index < 0) || (run > view->width*view->height - index)) reader.failed = true;
+
+                for (int k = 0; !reader.failed && (k < run); k++) reader.failed = !SetViewCell(view, index + k, (unsigned char)cell);
+                index += run;
+            }
+
+            if (reader.failed)
+            {
+                decoder->synced = false;
+                return false;
+            }
+        }
+
+        SetViewState(view, &state);
+        decoder->deltas++;
+    }
+    else return false;
+
+    decoder->sequence = sequence;
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+static bool ReserveSnapshot(SnapshotEncoder *encoder, int width, int height)
+{
+    int cells = width*height;
+
+    if (cells > encoder->cellCapacity)
+    {
+        unsigned char *buffer = realloc(encoder->cells, cells);
+        unsigned char *data = realloc(encoder->data, SNAPSHOT_HEADER_SIZE + 2*cells);
+
+        if (buffer != NULL) encoder->cells = buffer;
+        if (data != NULL) encoder->data = data;
+        if ((buffer == NULL) || (data == NULL)) return false;
+
+        encoder->cellCapacity = cells;
+        encoder->capacity = SNAPSHOT_HEADER_SIZE + 2*cells;
+    }
+
+    return true;
+}
+
+static SnapshotState GetSnapshotState(const GameContext *ctx)
+{
+    SnapshotState state = { 0 };
+
+    state.score = ctx->score;
+    state.lines = ctx->lines;
+    state.level = ctx->level;
+    state.flags = (ctx->pieceActive? SNAPSHOT_FLAG_PIECE_ACTIVE : 0) | (ctx->lineToDelete? SNAPSHOT_FLAG_LINE_TO_DELETE : 0) |
+                  (ctx->gameOver? SNAPSHOT_FLAG_GAME_OVER : 0) | (ctx->gameOverTriggered? SNAPSHOT_FLAG_GAME_OVER_TRIGGERED : 0);
+    state.fadeLineCounter = ctx->fadeLineCounter;
+    state.piecePositionX = ctx->piecePositionX;
+    state.piecePositionY = ctx->piecePositionY;
+    state.pieceColor = ctx->piece.color;
+    state.pieceCellCount = ctx->pieceCellCount;
+    memcpy(state.pieceCells, ctx->pieceCells, ctx->pieceCellCount*sizeof(PieceCell));
+    state.incoming = PeekPiece(&ctx->pieces, 0);
+
+    return state;
+}
+
+static unsigned int GetChangedFields(const SnapshotState *state, const SnapshotState *previous)
+{
+    unsigned int mask = 0;
+
+    if (state->score != previous->score) mask |= SNAPSHOT_SCORE;
+    if ((state->lines != previous->lines) || (state->level != previous->level)) mask |= SNAPSHOT_LINES;
+    if ((state->flags != previous->flags) || (state->fadeLineCounter != previous->fadeLineCounter)) mask |= SNAPSHOT_STATUS;
+    if ((state->piecePositionX != previous->piecePositionX) || (state->piecePositionY != previous->piecePositionY)) mask |= SNAPSHOT_PIECE;
+    if ((state->pieceColor != previous->pieceColor) || (state->pieceCellCount != previous->pieceCellCount) ||
+        (memcmp(state->pieceCells, previous->pieceCells, state->pieceCellCount*sizeof(PieceCell)) != 0)) mask |= SNAPSHOT_SHAPE;
+    if ((state->incoming.x != previous->incoming.x) || (state->incoming.y != previous->incoming.y) ||
+        (state->incoming.color != previous->incoming.color)) mask |= SNAPSHOT_NEXT;
+
+    return mask;
+}
+
+// The color only matters for a barrel, leaving it out elsewhere makes longer runs
+static unsigned char PackCell(const GameContext *ctx, int index)
+{
+    GridSquare square = ctx->grid[index];
+
+    return (unsigned char)(square | ((square == FULL)? (ctx->gridColors[index] << 3) : 0));
+}
+
+static int WriteKeyframe(SnapshotEncoder *encoder, const GameContext *ctx, const SnapshotState *state)
+{
+    static const SnapshotState zero = { 0 };
+    unsigned char *out = encoder->data;
+    int cells = ctx->width*ctx->height;
+
+    *out++ = SNAPSHOT_KEYFRAME;
+    out = WriteVarint(out, encoder->sequence);
+    out = WriteVarint(out, (uint32_t)ctx->width);
+    out = WriteVarint(out, (uint32_t)ctx->height);
+    out = WriteFields(out, SNAPSHOT_FIELDS, state, &zero);
+
+    for (int index = 0; index < cells; index++) encoder->cells[index] = PackCell(ctx, index);
+
+    for (int index = 0; index < cells; )
+    {
+        int run = 1;
+        while ((index + run < cells) && (encoder->cells[index + run] == encoder->cells[index])) run++;
+
+        out = WriteVarint(out, (uint32_t)run);
+        *out++ = encoder->cells[index];
+        index += run;
+    }
+
+    encoder->width = ctx->width;
+    encoder->height = ctx->height;
+    encoder->sinceKeyframe = 0;
+    encoder->keyframeWanted = false;
+
+    return (int)(out - encoder->data);
+}
+
+// Only rows at or below the higher of the two stack tops can differ, the rest are empty in both
+static int WriteDelta(SnapshotEncoder *encoder, const GameContext *ctx, const SnapshotState *state)
+{
+    unsigned char *out = encoder->data;
+    int cells = ctx->width*ctx->height;
+    int firstRow = (encoder->stackTop < ctx->stackTop)? encoder->stackTop : ctx->stackTop;
+
+    *out++ = SNAPSHOT_DELTA;
+    out = WriteVarint(out, encoder->sequence);
+
+    unsigned char *mask = out++;
+    *mask = (unsigned char)GetChangedFields(state, &encoder->state);
+    out = WriteFields(out, *mask, state, &encoder->state);
+
+    unsigned char *cellsStart = out;
+    int previousEnd = 0;
+
+    for (int index = firstRow*ctx->width; index < cells; index++)
+    {
+        unsigned char cell = PackCell(ctx, index);
+        if (cell == encoder->cells[index]) continue;
+
+        int run = 1;
+        encoder->cells[index] = cell;
+
+        while ((index + run < cells) && (PackCell(ctx, index + run) == cell) && (encoder->cells[index + run] != cell))
+        {
+            encoder->cells[index + run] = cell;
+            run++;
+        }
+
+        out = WriteVarint(out, (uint32_t)(index - previousEnd));
+        out = WriteVarint(out, (uint32_t)(run - 1));
+        *out++ = cell;
+
+        // Cleared lines move most of the stack; then the whole board is cheaper
+        if (out - cellsStart > cells/2) return -1;
+
+        index += run - 1;
+        previousEnd = index + 1;
+    }
+
+    if (out != cellsStart) *mask |= SNAPSHOT_CELLS;
+    encoder->sinceKeyframe++;
+
+    return (int)(out - encoder->data);
+}
+
+static unsigned char *WriteFields(unsigned char *out, unsigned int mask, const SnapshotState *state, const SnapshotState *previous)
+{
+    if (mask & SNAPSHOT_SCORE) out = WriteSigned(out, state->score - previous->score);
+
+    if (mask & SNAPSHOT_LINES)
+    {
+        out = WriteSigned(out, state->lines - previous->lines);
+        out = WriteSigned(out, state->level - previous->level);
+    }
+
+    if (mask & SNAPSHOT_STATUS)
+    {
+        *out++ = (unsigned char)state->flags;
+        out = WriteSigned(out, state->fadeLineCounter - previous->fadeLineCounter);
+    }
+
+    if (mask & SNAPSHOT_PIECE)
+    {
+        out = WriteSigned(out, state->piecePositionX - previous->piecePositionX);
+        out = WriteSigned(out, state->piecePositionY - previous->piecePositionY);
+    }
+
+    if (mask & SNAPSHOT_SHAPE)
+    {
+        *out++ = (unsigned char)(state->pieceColor | (state->pieceCellCount << 4));
+
+        for (int k = 0; k < state->pieceCellCount; k++)
+        {
+            out = WriteSigned(out, state->pieceCells[k].x);
+            out = WriteSigned(out, state->pieceCells[k].y);
+        }
+    }
+
+    if (mask & SNAPSHOT_NEXT)
+    {
+        *out++ = (unsigned char)state->incoming.color;
+        out = WriteSigned(out, state->incoming.x);
+        out = WriteSigned(out, state->incoming.y);
+    }
+
+    return out;
+}
+
+static bool ReadFields(SnapshotReader *reader, unsigned int mask, SnapshotState *state)
+{
+    if (mask & SNAPSHOT_SCORE) state->score += ReadSigned(reader);
+
+    if (mask & SNAPSHOT_LINES)
+    {
+        state->lines += ReadSigned(reader);
+        state->level += ReadSigned(reader);
+    }
+
+    if (mask & SNAPSHOT_STATUS)
+    {
+        state->flags = (unsigned int)ReadByte(reader);
+        state->fadeLineCounter += ReadSigned(reader);
+    }
+
+    if (mask & SNAPSHOT_PIECE)
+    {
+        state->piecePositionX += ReadSigned(reader);
+        state->piecePositionY += ReadSigned(reader);
+    }
+
+    if (mask & SNAPSHOT_SHAPE)
+    {
+        int shape = ReadByte(reader);
+
+        state->pieceColor = shape & 0x0f;
+        state->pieceCellCount = shape >> 4;
+        if ((state->pieceColor > BARREL_YELLOW) || (state->pieceCellCount > MAX_PIECE_CELLS)) reader->failed = true;
+
+        for (int k = 0; !reader->failed && (k < state->pieceCellCount); k++)
+        {
+            state->pieceCells[k].x = ReadSigned(reader);
+            state->pieceCells[k].y = ReadSigned(reader);
+        }
+    }
+
+    if (mask & SNAPSHOT_NEXT)
+    {
+        int color = ReadByte(reader);
+
+        state->incoming.color = (BarrelColor)color;
+        state->incoming.x = ReadSigned(reader);
+        state->incoming.y = ReadSigned(reader);
+        if (color > BARREL_YELLOW) reader->failed = true;
+    }
+
+    return !reader->failed;
+}
+
+static void SetViewState(GameContext *view, const SnapshotState *state)
+{
+    view->score = state->score;
+    view->lines = state->lines;
+    view->level = state->level;
+    view->pieceActive = (state->flags & SNAPSHOT_FLAG_PIECE_ACTIVE) != 0;
+    view->lineToDelete = (state->flags & SNAPSHOT_FLAG_LINE_TO_DELETE) != 0;
+    view->gameOver = (state->flags & SNAPSHOT_FLAG_GAME_OVER) != 0;
+    view->gameOverTriggered = (state->flags & SNAPSHOT_FLAG_GAME_OVER_TRIGGERED) != 0;
+    view->fadeLineCounter = state->fadeLineCounter;
+    view->piecePositionX = state->piecePositionX;
+    view->piecePositionY = state->piecePositionY;
+    view->piece.color = (BarrelColor)state->pieceColor;
+    view->pieceCellCount = state->pieceCellCount;
+    memcpy(view->pieceCells, state->pieceCells, state->pieceCellCount*sizeof(PieceCell));
+
+    // Only the next piece is ever shown
+    view->pieces.head = 0;
+    view->pieces.queue[0] = state->incoming;
+}
+
+// Keeps rowFill right, the board drawing skips rows without barrels
+static bool SetViewCell(GameContext *view, int index, unsigned char cell)
+{
+    GridSquare square = (GridSquare)(cell & 0x07);
+    int color = cell >> 3;
+
+    if ((square > FADING) || (color > BARREL_YELLOW)) return false;
+
+    int row = index/view->width;
+
+    if (view->grid[index] == FULL) view->rowFill[row]--;
+    if (square == FULL) view->rowFill[row]++;
+
+    view->grid[index] = square;
+    view->gridColors[index] = (BarrelColor)color;
+
+    return true;
+}
+
+static unsigned char *WriteVarint(unsigned char *out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        *out++ = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+
+    *out++ = (unsigned char)value;
+
+    return out;
+}
+
+// Zigzag, so small negative differences stay one byte
+static unsigned char *WriteSigned(unsigned char *out, int value)
+{
+    return WriteVarint(out, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+static uint32_t ReadVarint(SnapshotReader *reader)
+{
+    uint32_t value = 0;
+
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        int byte = ReadByte(reader);
+        if (reader->failed) return 0;
+
+        value |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+
+    reader->failed = true;
+
+    return 0;
+}
+
+static int ReadSigned(SnapshotReader *reader)
+{
+    uint32_t value = ReadVarint(reader);
+
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+static int ReadByte(SnapshotReader *reader)
+{
+    if (reader->offset >= reader->size)
+    {
+        reader->failed = true;
+        return 0;
+    }
+
+    return reader->data[reader->offset++];
+}
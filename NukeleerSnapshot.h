@@ -0,0 +1,72 @@
+#ifndef NUKELEER_SNAPSHOT_H
+#define NUKELEER_SNAPSHOT_H
+
+#include "NukeleerCore.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define SNAPSHOT_KEYFRAME_TICKS 120         // A viewer joining late waits at most this many snapshots
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// What a spectator needs to draw a game, besides the board cells
+typedef struct SnapshotState {
+    int score;
+    int lines;
+    int level;
+    unsigned int flags;         // SNAPSHOT_FLAG_* bits, see NukeleerSnapshot.c
+    int fadeLineCounter;
+    int piecePositionX;
+    int piecePositionY;
+    int pieceColor;
+    int pieceCellCount;
+    PieceCell pieceCells[MAX_PIECE_CELLS];
+    Piece incoming;
+} SnapshotState;
+
+// Turns a game into a stream of snapshots, one per call: a keyframe with the whole board
+// (run-length coded) every SNAPSHOT_KEYFRAME_TICKS, and in between only the cells and
+// fields that changed since the last one, varint coded. A steady game costs a few bytes
+// per tick. Keeps its own copy of the board as last sent.
+typedef struct SnapshotEncoder {
+    int width;
+    int height;
+    unsigned char *cells;       // One byte per cell: square | color << 3
+    int cellCapacity;
+    int stackTop;               // Rows above both this and the game's stack are unchanged
+    SnapshotState state;
+    uint32_t sequence;
+    int sinceKeyframe;
+    bool keyframeWanted;
+
+    unsigned char *data;        // Last snapshot
+    int size;
+    int capacity;
+} SnapshotEncoder;
+
+// Applies snapshots to a view context. Until the first keyframe, and after a gap in the
+// sequence, deltas are skipped. A view is for drawing only, UpdateCore() must not run on it.
+typedef struct SnapshotDecoder {
+    bool synced;
+    uint32_t sequence;
+    int keyframes;
+    int deltas;
+    int skipped;
+} SnapshotDecoder;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+int EncodeSnapshot(SnapshotEncoder *encoder, const GameContext *ctx);  // Into encoder->data, returns the size (0 out of memory)
+void RequestKeyframe(SnapshotEncoder *encoder);                         // The next snapshot is a keyframe, e.g. a new game started
+void UnloadSnapshotEncoder(SnapshotEncoder *encoder);
+bool IsSnapshotKeyframe(const unsigned char *data, int size);
+
+bool DecodeSnapshot(SnapshotDecoder *decoder, GameContext *view, const unsigned char *data, int size);  // False if skipped or malformed
+
+#endif // NUKELEER_SNAPSHOT_H
@@ -0,0 +1,460 @@
+#include "NukeleerTelemetry.h"
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define TELEMETRY_FILE_VERSION  1
+#define TELEMETRY_HEADER_SIZE   4           // "NKT" + version
+#define BLOCK_HEADER_MAX_SIZE   20          // Four varints: source, dropped, count, payload size
+#define EVENT_MAX_SIZE          26          // Tick delta, type and four fields, all varints
+
+// The producer's and the consumer's fields must not share a cache line
+_Static_assert(offsetof(TelemetryRing, tail) == 64, "TelemetryRing producer fields must fill one cache line");
+_Static_assert(offsetof(TelemetryRing, events) == 128, "TelemetryRing consumer fields must fill one cache line");
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+// Ring list and statistics, shared with the drainer thread
+static pthread_mutex_t ringsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t drainWake = PTHREAD_COND_INITIALIZER;
+static TelemetryRing *rings[MAX_TELEMETRY_RINGS] = { 0 };
+static int ringCount = 0;
+static int nextSource = 0;
+static TelemetryStats stats = { 0 };
+static long long freedDropped = 0;          // Dropped by rings already freed
+static bool stopDrainer = false;
+static bool drainerRunning = false;
+
+// Drainer thread only, once it runs
+static pthread_t drainerThread;
+static FILE *logFile = NULL;
+static char logName[256] = { 0 };
+static long logSize = 0;
+static unsigned char *payload = NULL;       // One block being packed, TELEMETRY_RING_SIZE events at most
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void *DrainTelemetry(void *arg);     // Drainer thread: wakes every TELEMETRY_FLUSH_TIME
+static void DrainRings(void);
+static void WriteBlock(const unsigned char *header, int headerSize, const unsigned char *data, int size);
+static bool OpenLogFile(void);              // Rotates the current log out, then starts a new one
+static void RotateLogs(void);
+static int PutVarint(unsigned char *bytes, uint32_t value);
+static int GetVarint(const unsigned char *bytes, int size, uint32_t *value);   // Bytes read, 0 if truncated
+static uint32_t Zigzag(int32_t value);
+static int32_t Unzigzag(uint32_t value);
+
+//--------------------------------------------------------------------------------------
+// Telemetry Module Functions Definition
+//--------------------------------------------------------------------------------------
+bool OpenTelemetry(const char *fileName)
+{
+    CloseTelemetry();
+
+    snprintf(logName, sizeof(logName), "%s", fileName);
+
+    payload = malloc(TELEMETRY_RING_SIZE*EVENT_MAX_SIZE);
+    if ((payload == NULL) || !OpenLogFile())
+    {
+        free(payload);
+        payload = NULL;
+        return false;
+    }
+
+    memset(&stats, 0, sizeof(stats));
+    freedDropped = 0;
+    stopDrainer = false;
+
+    if (pthread_create(&drainerThread, NULL, DrainTelemetry, NULL) != 0)
+    {
+        fclose(logFile);
+        logFile = NULL;
+        free(payload);
+        payload = NULL;
+        return false;
+    }
+
+    drainerRunning = true;
+
+    return true;
+}
+
+void CloseTelemetry(void)
+{
+    if (!drainerRunning) return;
+
+    pthread_mutex_lock(&ringsLock);
+    stopDrainer = true;
+    pthread_cond_signal(&drainWake);
+    pthread_mutex_unlock(&ringsLock);
+
+    pthread_join(drainerThread, NULL);
+    drainerRunning = false;
+
+    // The game is done with its rings by now, attached or not
+    for (int i = 0; i < ringCount; i++)
+    {
+        freedDropped += atomic_load_explicit(&rings[i]->dropped, memory_order_relaxed);
+        free(rings[i]);
+    }
+
+    ringCount = 0;
+
+    fclose(logFile);
+    logFile = NULL;
+    free(payload);
+    payload = NULL;
+}
+
+TelemetryRing *AttachTelemetry(void)
+{
+    TelemetryRing *ring = NULL;
+
+    pthread_mutex_lock(&ringsLock);
+
+    if (drainerRunning && (ringCount < MAX_TELEMETRY_RINGS))
+    {
+        ring = calloc(1, sizeof(TelemetryRing));
+
+        if (ring != NULL)
+        {
+            ring->source = nextSource++;
+            rings[ringCount++] = ring;
+        }
+    }
+
+    pthread_mutex_unlock(&ringsLock);
+
+    return ring;
+}
+
+void DetachTelemetry(TelemetryRing *ring)
+{
+    if (ring != NULL) atomic_store_explicit(&ring->detached, true, memory_order_release);
+}
+
+TelemetryStats GetTelemetryStats(void)
+{
+    pthread_mutex_lock(&ringsLock);
+
+    TelemetryStats result = stats;
+
+    result.dropped = freedDropped;
+    for (int i = 0; i < ringCount; i++) result.dropped += atomic_load_explicit(&rings[i]->dropped, memory_order_relaxed);
+
+    pthread_mutex_unlock(&ringsLock);
+
+    return result;
+}
+
+int ReadTelemetryFile(const char *fileName, void (*callback)(int source, const TelemetryEvent *event, void *user), void *user)
+{
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL) return -1;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    unsigned char *data = (size > 0)? malloc(size) : NULL;
+
+    if ((data == NULL) || (fread(data, 1, size, file) != (size_t)size) || (size < TELEMETRY_HEADER_SIZE) ||
+        (memcmp(data, "NKT", 3) != 0) || (data[3] != TELEMETRY_FILE_VERSION))
+    {
+        free(data);
+        fclose(file);
+        return -1;
+    }
+
+    fclose(file);
+
+    int events = 0;
+    long offset = TELEMETRY_HEADER_SIZE;
+
+    while (offset < size)
+    {
+        uint32_t header[4] = { 0 };     // source, dropped, count, payload size
+        long position = offset;
+        bool complete = true;
+
+        for (int i = 0; (i < 4) && complete; i++)
+        {
+            int read = GetVarint(data + position, (int)(size - position), &header[i]);
+
+            if (read == 0) complete = false;
+            position += read;
+        }
+
+        // A block torn by a crash is the last one
+        if (!complete || (header[3] > (uint32_t)(size - position))) break;
+
+        const unsigned char *bytes = data + position;
+        int remaining = (int)header[3];
+        int32_t tick = 0;
+
+        for (uint32_t k = 0; k < header[2]; k++)
+        {
+            uint32_t fields[6] = { 0 };     // tick delta, type, x, y, extra, value
+
+            for (int i = 0; (i < 6) && complete; i++)
+            {
+                int read = GetVarint(bytes, remaining, &fields[i]);
+
+                if (read == 0) complete = false;
+                bytes += read;
+                remaining -= read;
+            }
+
+            if (!complete) break;
+
+            tick += Unzigzag(fields[0]);
+
+            TelemetryEvent event = { (uint32_t)tick, (uint16_t)fields[1], (int16_t)Unzigzag(fields[2]), (int16_t)Unzigzag(fields[3]),
+                                     (int16_t)Unzigzag(fields[4]), Unzigzag(fields[5]) };
+
+            if (callback != NULL) callback((int)header[0], &event, user);
+            events++;
+        }
+
+        if (!complete) break;
+
+        offset = position + header[3];
+    }
+
+    free(data);
+
+    return events;
+}
+
+//--------------------------------------------------------------------------------------
+// Additional module functions
+//--------------------------------------------------------------------------------------
+static void *DrainTelemetry(void *arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&ringsLock);
+
+    while (!stopDrainer)
+    {
+        struct timespec wake;
+        timespec_get(&wake, TIME_UTC);
+
+        long long nanoseconds = wake.tv_nsec + (long long)(TELEMETRY_FLUSH_TIME*1e9);
+        wake.tv_sec += (time_t)(nanoseconds/1000000000);
+        wake.tv_nsec = (long)(nanoseconds%1000000000);
+
+        pthread_cond_timedwait(&drainWake, &ringsLock, &wake);
+
+        pthread_mutex_unlock(&ringsLock);
+        DrainRings();
+        pthread_mutex_lock(&ringsLock);
+    }
+
+    pthread_mutex_unlock(&ringsLock);
+
+    // Whatever the game emitted before it closed
+    DrainRings();
+
+    return NULL;
+}
+
+// One block per ring that has events. The lock is only held to walk the ring list; the
+// events are read without it, the game thread keeps writing meanwhile.
+static void DrainRings(void)
+{
+    TelemetryRing *drained[MAX_TELEMETRY_RINGS] = { 0 };
+
+    pthread_mutex_lock(&ringsLock);
+    int count = ringCount;
+    memcpy(drained, rings, count*sizeof(TelemetryRing *));
+    pthread_mutex_unlock(&ringsLock);
+
+    for (int r = 0; r < count; r++)
+    {
+        TelemetryRing *ring = drained[r];
+
+        // Read detached first: once it is set, head no longer moves
+        bool detached = atomic_load_explicit(&ring->detached, memory_order_acquire);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+
+        if (head != tail)
+        {
+            int size = 0;
+            uint32_t previousTick = 0;
+
+            for (uint32_t k = tail; k != head; k++)
+            {
+                const TelemetryEvent *event = &ring->events[k & (TELEMETRY_RING_SIZE - 1)];
+
+                // A new game starts the ticks over, so the delta may be negative
+                size += PutVarint(payload + size, Zigzag((int32_t)(event->tick - previousTick)));
+                size += PutVarint(payload + size, event->type);
+                size += PutVarint(payload + size, Zigzag(event->x));
+                size += PutVarint(payload + size, Zigzag(event->y));
+                size += PutVarint(payload + size, Zigzag(event->extra));
+                size += PutVarint(payload + size, Zigzag(event->value));
+                previousTick = event->tick;
+            }
+
+            // The slots are free again as soon as they are packed
+            atomic_store_explicit(&ring->tail, head, memory_order_release);
+
+            unsigned char header[BLOCK_HEADER_MAX_SIZE] = { 0 };
+            int headerSize = 0;
+
+            headerSize += PutVarint(header + headerSize, (uint32_t)ring->source);
+            headerSize += PutVarint(header + headerSize, dropped);
+            headerSize += PutVarint(header + headerSize, head - tail);
+            headerSize += PutVarint(header + headerSize, (uint32_t)size);
+
+            WriteBlock(header, headerSize, payload, size);
+
+            pthread_mutex_lock(&ringsLock);
+            stats.events += head - tail;
+            stats.rawBytes += (long long)(head - tail)*sizeof(TelemetryEvent);
+            pthread_mutex_unlock(&ringsLock);
+        }
+
+        if (detached)
+        {
+            pthread_mutex_lock(&ringsLock);
+
+            for (int i = 0; i < ringCount; i++)
+            {
+                if (rings[i] == ring)
+                {
+                    rings[i] = rings[--ringCount];
+                    break;
+                }
+            }
+
+            freedDropped += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+            pthread_mutex_unlock(&ringsLock);
+
+            free(ring);
+        }
+    }
+
+    if (logFile != NULL) fflush(logFile);
+}
+
+static void WriteBlock(const unsigned char *header, int headerSize, const unsigned char *data, int size)
+{
+    if ((logFile != NULL) && (logSize + headerSize + size > TELEMETRY_FILE_SIZE))
+    {
+        fclose(logFile);
+        logFile = NULL;
+
+        if (OpenLogFile())
+        {
+            pthread_mutex_lock(&ringsLock);
+            stats.rotations++;
+            pthread_mutex_unlock(&ringsLock);
+        }
+    }
+
+    bool written = (logFile != NULL) && (fwrite(header, 1, headerSize, logFile) == (size_t)headerSize) &&
+                   (fwrite(data, 1, size, logFile) == (size_t)size);
+
+    pthread_mutex_lock(&ringsLock);
+    if (written) stats.bytes += headerSize + size;
+    else stats.failedWrites++;
+    pthread_mutex_unlock(&ringsLock);
+
+    if (written) logSize += headerSize + size;
+}
+
+static bool OpenLogFile(void)
+{
+    unsigned char header[TELEMETRY_HEADER_SIZE] = { 'N', 'K', 'T', TELEMETRY_FILE_VERSION };
+
+    RotateLogs();
+
+    logFile = fopen(logName, "wb");
+    if (logFile == NULL) return false;
+
+    if (fwrite(header, 1, TELEMETRY_HEADER_SIZE, logFile) != TELEMETRY_HEADER_SIZE)
+    {
+        fclose(logFile);
+        logFile = NULL;
+        return false;
+    }
+
+    logSize = TELEMETRY_HEADER_SIZE;
+
+    return true;
+}
+
+// <name> becomes <name>.1, <name>.1 becomes <name>.2 and so on; the oldest is deleted
+static void RotateLogs(void)
+{
+    char from[272] = { 0 };
+    char to[272] = { 0 };
+
+    snprintf(to, sizeof(to), "%s.%i", logName, TELEMETRY_KEEP_FILES);
+    remove(to);
+
+    for (int i = TELEMETRY_KEEP_FILES - 1; i >= 0; i--)
+    {
+        if (i == 0) snprintf(from, sizeof(from), "%s", logName);
+        else snprintf(from, sizeof(from), "%s.%i", logName, i);
+
+        snprintf(to, sizeof(to), "%s.%i", logName, i + 1);
+        rename(from, to);
+    }
+}
+
+static int PutVarint(unsigned char *bytes, uint32_t value)
+{
+    int size = 0;
+
+    while (value >= 0x80)
+    {
+        bytes[size++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+
+    bytes[size++] = (unsigned char)value;
+
+    return size;
+}
+
+static int GetVarint(const unsigned char *bytes, int size, uint32_t *value)
+{
+    uint32_t result = 0;
+
+    for (int i = 0; (i < size) && (i < 5); i++)
+    {
+        result |= (uint32_t)(bytes[i] & 0x7f) << (7*i);
+
+        if ((bytes[i] & 0x80) == 0)
+        {
+            *value = result;
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+static uint32_t Zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t Unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
@@ -0,0 +1,105 @@
+#ifndef NUKELEER_TELEMETRY_H
+#define NUKELEER_TELEMETRY_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define TELEMETRY_FILE_NAME     "telemetry.nkt"
+#define TELEMETRY_RING_SIZE     4096        // Events a game can emit between two drains, power of two
+#define TELEMETRY_FLUSH_TIME    0.25        // Seconds between drains
+#define TELEMETRY_FILE_SIZE     (4 << 20)   // Bytes before the log is rotated
+#define TELEMETRY_KEEP_FILES    8           // Rotated logs kept as <name>.1 (newest) to <name>.8
+#define MAX_TELEMETRY_RINGS     64
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+// What the fields of an event hold, by type
+typedef enum TelemetryType {
+    TELEMETRY_GAME_START = 1,   // x, y: board size; value: seed
+    TELEMETRY_LOCK,             // x, y: cell the barrel locked in; extra: color; value: lock score
+    TELEMETRY_SLIDE,            // x, y: cell the slide ended in; extra: -1 left, 1 right; value: cells slid
+    TELEMETRY_LINE_CLEAR,       // x: lines deleted; y: total lines; value: score gained
+    TELEMETRY_SAME_COLOR,       // x, y: cell touching its own color; extra: color; value: penalty
+    TELEMETRY_GAME_OVER,        // x: lines; extra: TelemetryCause; value: final score
+    TELEMETRY_TYPE_COUNT
+} TelemetryType;
+
+typedef enum TelemetryCause { TELEMETRY_CAUSE_TOPOUT, TELEMETRY_CAUSE_SAME_COLOR, TELEMETRY_CAUSE_GARBAGE } TelemetryCause;
+
+typedef struct TelemetryEvent {
+    uint32_t tick;              // UpdateCore() calls since the game started
+    uint16_t type;
+    int16_t x;
+    int16_t y;
+    int16_t extra;
+    int32_t value;
+} TelemetryEvent;
+
+// Single producer, single consumer: the thread ticking one game writes, the drainer thread
+// reads. The producer's and the consumer's counters sit on their own cache lines, and the
+// producer only reads tail again when its cached copy says the ring is full.
+typedef struct TelemetryRing {
+    _Atomic uint32_t head;      // Game thread: next slot to write
+    uint32_t cachedTail;
+    _Atomic uint32_t dropped;   // Game thread: events lost to a full ring
+    char producerPadding[52];
+
+    _Atomic uint32_t tail;      // Drainer: next slot to read
+    int source;                 // Game id in the log
+    _Atomic bool detached;      // Freed by the drainer once empty
+    char consumerPadding[52];
+
+    TelemetryEvent events[TELEMETRY_RING_SIZE];
+} TelemetryRing;
+
+typedef struct TelemetryStats {
+    long long events;           // Written to the log
+    long long dropped;          // Lost to full rings
+    long long rawBytes;         // Size of those events as fixed records
+    long long bytes;            // Written to the log, after packing
+    int rotations;
+    int failedWrites;
+} TelemetryStats;
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration
+//------------------------------------------------------------------------------------
+// Game events go into a ring per game and never wait: when the ring is full the event is
+// counted as dropped. A background thread drains every ring a few times a second and
+// appends the events to a log as packed blocks (delta-coded ticks, zigzag varint fields),
+// rotating the log by size. A log left from an earlier run is rotated out on open.
+bool OpenTelemetry(const char *fileName);
+void CloseTelemetry(void);                      // Drains whatever is still in the rings, then frees them all
+TelemetryRing *AttachTelemetry(void);           // A ring for one game (GameContext.telemetry), NULL if closed or full
+void DetachTelemetry(TelemetryRing *ring);      // No more events; freed once drained
+TelemetryStats GetTelemetryStats(void);
+
+// Reads a log back, stopping at a block a crash left half-written. Returns the events read, -1 if not a log
+int ReadTelemetryFile(const char *fileName, void (*callback)(int source, const TelemetryEvent *event, void *user), void *user);
+
+// A few nanoseconds on the game thread: a slot store and a release store, no locks
+static inline void EmitTelemetry(TelemetryRing *ring, TelemetryEvent event)
+{
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (head - ring->cachedTail >= TELEMETRY_RING_SIZE)
+    {
+        ring->cachedTail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+        if (head - ring->cachedTail >= TELEMETRY_RING_SIZE)
+        {
+            atomic_store_explicit(&ring->dropped, atomic_load_explicit(&ring->dropped, memory_order_relaxed) + 1, memory_order_relaxed);
+            return;
+        }
+    }
+
+    ring->events[head & (TELEMETRY_RING_SIZE - 1)] = event;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+#endif // NUKELEER_TELEMETRY_H
@@ -0,0 +1,60 @@
+// Prints telemetry logs as CSV, one event per line, for spreadsheets and analytics
+// scripts; a per-type count goes to stderr.
+//
+// Usage: NukeleerTelemetryDump telemetry.nkt [telemetry.nkt.1 ...]
+
+#include "NukeleerTelemetry.h"
+
+#include <stdio.h>
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+static const char *typeNames[TELEMETRY_TYPE_COUNT] = { "unknown", "game_start", "lock", "slide", "line_clear", "same_color", "game_over" };
+static long long typeCounts[TELEMETRY_TYPE_COUNT] = { 0 };
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static void PrintEvent(int source, const TelemetryEvent *event, void *user);
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: NukeleerTelemetryDump file.nkt [file.nkt ...]\n");
+        return 1;
+    }
+
+    int failed = 0;
+
+    printf("file,source,tick,type,x,y,extra,value\n");
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (ReadTelemetryFile(argv[i], PrintEvent, argv[i]) < 0)
+        {
+            fprintf(stderr, "%s: not a telemetry log\n", argv[i]);
+            failed++;
+        }
+    }
+
+    for (int type = 1; type < TELEMETRY_TYPE_COUNT; type++) fprintf(stderr, "%-12s %lld\n", typeNames[type], typeCounts[type]);
+
+    return (failed == 0)? 0 : 2;
+}
+
+//--------------------------------------------------------------------------------------
+// Module Functions Definition
+//--------------------------------------------------------------------------------------
+static void PrintEvent(int source, const TelemetryEvent *event, void *user)
+{
+    int type = (event->type < TELEMETRY_TYPE_COUNT)? event->type : 0;
+
+    typeCounts[type]++;
+
+    printf("%s,%i,%u,%s,%i,%i,%i,%i\n", (const char *)user, source, event->tick, typeNames[type], event->x, event->y, event->extra, event->value);
+}
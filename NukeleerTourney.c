@@ -0,0 +1,385 @@
+// Rule tuning harness: plays the same seeded games under every rule variant listed in a
+// file, spread across every core, and reports score and game length distributions with
+// 95% confidence intervals. All variants share the seeds, so the difference to the first
+// variant is measured game by game and is much tighter than the raw intervals.
+//
+// Usage: NukeleerTourney <variants.txt> [games] [seed] [threads] [player]
+//        player: autoplayer milliseconds per move (default 0, one piece ahead),
+//                or "random" for the button masher of NukeleerSim
+//
+// Variants file, one per line; constants not listed keep their GetDefaultRules() value:
+//
+//     baseline
+//     cheap-locks     lockScoreBase=0 lockScoreDivisor=8
+//     fast-gravity    startGravity=10 gravityDecay=2 minGravity=2     # comments are fine
+
+#include "NukeleerCore.h"
+#include "NukeleerBatch.h"
+#include "NukeleerAutoplay.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//----------------------------------------------------------------------------------
+// Some Defines
+//----------------------------------------------------------------------------------
+#define MAX_VARIANTS            1024
+#define MAX_VARIANT_NAME        32
+#define MAX_LINE_LENGTH         1024
+#define MAX_GAME_TICKS          216000      // An hour of play, longer games are cut off and counted
+#define INPUT_HOLD_TICKS        20          // Ticks a random key combination is held
+#define CONFIDENCE_Z            1.96        // 95% interval, normal approximation
+
+//----------------------------------------------------------------------------------
+// Types and Structures Definition
+//----------------------------------------------------------------------------------
+typedef struct Variant {
+    char name[MAX_VARIANT_NAME];
+    RuleSet rules;
+} Variant;
+
+// A RuleSet member that can be set from the variants file
+typedef struct RuleField {
+    const char *name;
+    size_t offset;
+    int min;
+    int max;
+} RuleField;
+
+typedef struct GameResult {
+    int score;
+    int ticks;
+    int lines;
+} GameResult;
+
+typedef struct TourneyJob {
+    const Variant *variants;
+    int gamesPerVariant;
+    unsigned int seed;
+    bool randomPlayer;
+    double budget;
+    GameResult *results;        // gamesPerVariant slots per variant, in variant order
+} TourneyJob;
+
+// Mean and half-width of its confidence interval
+typedef struct Estimate {
+    double mean;
+    double error;
+} Estimate;
+
+//------------------------------------------------------------------------------------
+// Global Variables Declaration
+//------------------------------------------------------------------------------------
+static const RuleField ruleFields[] = {
+    { "gridWidth", offsetof(RuleSet, gridWidth), MIN_GRID_HORIZONTAL_SIZE, MAX_GRID_HORIZONTAL_SIZE },
+    { "gridHeight", offsetof(RuleSet, gridHeight), MIN_GRID_VERTICAL_SIZE, MAX_GRID_VERTICAL_SIZE },
+    { "lineScoreBase", offsetof(RuleSet, lineScoreBase), INT_MIN, INT_MAX },
+    { "lineScorePerLine", offsetof(RuleSet, lineScorePerLine), INT_MIN, INT_MAX },
+    { "lockScoreBase", offsetof(RuleSet, lockScoreBase), INT_MIN, INT_MAX },
+    { "lockScorePivot", offsetof(RuleSet, lockScorePivot), INT_MIN, INT_MAX },
+    { "lockScoreDivisor", offsetof(RuleSet, lockScoreDivisor), 1, INT_MAX },
+    { "sameColorPenalty", offsetof(RuleSet, sameColorPenalty), INT_MIN, INT_MAX },
+    { "startGravity", offsetof(RuleSet, startGravity), 1, INT_MAX },
+    { "gravityDecay", offsetof(RuleSet, gravityDecay), 0, INT_MAX },
+    { "minGravity", offsetof(RuleSet, minGravity), 1, INT_MAX },
+};
+
+//------------------------------------------------------------------------------------
+// Module Functions Declaration (local)
+//------------------------------------------------------------------------------------
+static int LoadVariants(const char *fileName, Variant *variants, int maxCount);
+static bool SetRuleField(RuleSet *rules, const char *assignment);
+static void PlayGame(GameContext *ctx, int gameIndex, void *userData);
+static unsigned int GetRandomInput(unsigned int *state);
+static void PrintReport(const TourneyJob *job, int variantCount);
+static Estimate GetEstimate(const double *values, int count);
+static double GetPercentile(const int *sorted, int count, int percent);
+static int CompareInts(const void *a, const void *b);
+static double GetWallTime(void);
+
+//------------------------------------------------------------------------------------
+// Program main entry point
+//------------------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: NukeleerTourney <variants.txt> [games] [seed] [threads] [ms | random]\n");
+        return 1;
+    }
+
+    static Variant variants[MAX_VARIANTS] = { 0 };
+    int variantCount = LoadVariants(argv[1], variants, MAX_VARIANTS);
+
+    if (variantCount <= 0) return 1;
+
+    int games = (argc > 2)? atoi(argv[2]) : 100;
+    unsigned int seed = (argc > 3)? (unsigned int)strtoul(argv[3], NULL, 10) : 1;
+    int threads = (argc > 4)? atoi(argv[4]) : 0;
+
+    if (games <= 0) return 0;
+    if (threads <= 0) threads = GetProcessorCount();
+
+    TourneyJob job = { 0 };
+    job.variants = variants;
+    job.gamesPerVariant = games;
+    job.seed = seed;
+    job.randomPlayer = (argc > 5) && (strcmp(argv[5], "random") == 0);
+    job.budget = ((argc > 5) && !job.randomPlayer)? atof(argv[5])/1000.0 : 0.0;
+
+    // The autoplayer only plays the default board, elsewhere it would send no input at all
+    for (int v = 0; (v < variantCount) && !job.randomPlayer; v++)
+    {
+        if ((variants[v].rules.gridWidth != GRID_HORIZONTAL_SIZE) || (variants[v].rules.gridHeight != GRID_VERTICAL_SIZE))
+        {
+            printf("%s: a %ix%i board needs the random player, the autoplayer only plays %ix%i\n", variants[v].name,
+                   variants[v].rules.gridWidth, variants[v].rules.gridHeight, GRID_HORIZONTAL_SIZE, GRID_VERTICAL_SIZE);
+            return 1;
+        }
+    }
+
+    job.results = calloc((size_t)variantCount*games, sizeof(GameResult));
+
+    if (job.results == NULL) return 1;
+
+    double start = GetWallTime();
+
+    RunBatch(variantCount*games, threads, PlayGame, &job);
+
+    double seconds = GetWallTime() - start;
+
+    PrintReport(&job, variantCount);
+
+    printf("\n%i variants x %i games on %i threads in %.1f s (%.1f games/s), player: ", variantCount, games, threads,
+           seconds, variantCount*games/((seconds > 0.0)? seconds : 1e-9));
+
+    if (job.randomPlayer) printf("random\n");
+    else printf("autoplay %.2f ms\n", job.budget*1000.0);
+
+    free(job.results);
+
+    return 0;
+}
+
+//--------------------------------------------------------------------------------------
+// Module Functions Definition
+//--------------------------------------------------------------------------------------
+
+// Returns the number of variants, or -1 after printing what is wrong with the file
+static int LoadVariants(const char *fileName, Variant *variants, int maxCount)
+{
+    FILE *file = fopen(fileName, "r");
+    char line[MAX_LINE_LENGTH];
+    int count = 0;
+    int lineNumber = 0;
+
+    if (file == NULL)
+    {
+        printf("could not open variants file: %s\n", fileName);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        lineNumber++;
+
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        char *token = strtok(line, " \t\r\n");
+        if (token == NULL) continue;
+
+        if (count == maxCount)
+        {
+            printf("%s:%i: more than %i variants\n", fileName, lineNumber, maxCount);
+            fclose(file);
+            return -1;
+        }
+
+        Variant *variant = &variants[count++];
+
+        snprintf(variant->name, sizeof(variant->name), "%s", token);
+        variant->rules = GetDefaultRules();
+
+        while ((token = strtok(NULL, " \t\r\n")) != NULL)
+        {
+            if (!SetRuleField(&variant->rules, token))
+            {
+                printf("%s:%i: bad constant '%s'\n", fileName, lineNumber, token);
+                fclose(file);
+                return -1;
+            }
+        }
+    }
+
+    fclose(file);
+
+    if (count == 0) printf("no variants in %s\n", fileName);
+
+    return count;
+}
+
+// Apply one name=value pair
+static bool SetRuleField(RuleSet *rules, const char *assignment)
+{
+    const char *equals = strchr(assignment, '=');
+    if (equals == NULL) return false;
+
+    for (int i = 0; i < (int)(sizeof(ruleFields)/sizeof(ruleFields[0])); i++)
+    {
+        if ((strlen(ruleFields[i].name) != (size_t)(equals - assignment)) ||
+            (strncmp(ruleFields[i].name, assignment, equals - assignment) != 0)) continue;
+
+        char *end = NULL;
+        long value = strtol(equals + 1, &end, 10);
+
+        if ((end == equals + 1) || (*end != '\0') || (value < ruleFields[i].min) || (value > ruleFields[i].max)) return false;
+
+        *(int *)((char *)rules + ruleFields[i].offset) = (int)value;
+
+        return true;
+    }
+
+    return false;
+}
+
+// Game g of every variant uses the same seed, so the variants face the same pieces
+static void PlayGame(GameContext *ctx, int gameIndex, void *userData)
+{
+    TourneyJob *job = (TourneyJob *)userData;
+    const Variant *variant = &job->variants[gameIndex/job->gamesPerVariant];
+    unsigned int gameSeed = job->seed + (unsigned int)(gameIndex%job->gamesPerVariant)*2654435761u;
+    unsigned int inputState = ~gameSeed;
+    unsigned int input = 0;
+    int ticks = 0;
+    Autoplayer ai = { 0 };
+
+    if (!job->randomPlayer && !InitAutoplayer(&ai, job->budget)) return;
+
+    InitCoreWithRules(ctx, gameSeed, variant->rules);
+
+    for (ticks = 0; ticks < MAX_GAME_TICKS; ticks++)
+    {
+        if (!job->randomPlayer) input = GetAutoplayInput(&ai, ctx);
+        else if ((ticks%INPUT_HOLD_TICKS) == 0) input = GetRandomInput(&inputState);
+
+        UpdateCore(ctx, input);
+
+        if (ctx->gameOver) break;
+    }
+
+    if (!job->randomPlayer) CloseAutoplayer(&ai);
+
+    job->results[gameIndex].score = ctx->score;
+    job->results[gameIndex].ticks = ticks;
+    job->results[gameIndex].lines = ctx->lines;
+}
+
+// Same masher as NukeleerSim
+static unsigned int GetRandomInput(unsigned int *state)
+{
+    static const unsigned int choices[] = {
+        0, INPUT_LEFT, INPUT_RIGHT, INPUT_DOWN, INPUT_LEFT | INPUT_DOWN, INPUT_RIGHT | INPUT_DOWN
+    };
+
+    *state = *state*1103515245u + 12345u;
+
+    return choices[((*state >> 16) & 0x7fff)%(sizeof(choices)/sizeof(choices[0]))];
+}
+
+static void PrintReport(const TourneyJob *job, int variantCount)
+{
+    int games = job->gamesPerVariant;
+    int *sorted = malloc(games*sizeof(int));
+    double *values = malloc(games*sizeof(double));
+
+    if ((sorted == NULL) || (values == NULL))
+    {
+        free(sorted);
+        free(values);
+        return;
+    }
+
+    printf("%-*s %9s %8s %7s %7s %7s %9s %8s %8s %7s %7s %6s\n", MAX_VARIANT_NAME - 8, "variant", "score", "+-95%", "p10", "p50", "p90",
+           "vs first", "+-95%", "minutes", "+-95%", "lines", "capped");
+
+    for (int v = 0; v < variantCount; v++)
+    {
+        const GameResult *results = &job->results[v*games];
+        const GameResult *first = &job->results[0];
+        int capped = 0;
+        double lines = 0.0;
+
+        for (int g = 0; g < games; g++)
+        {
+            sorted[g] = results[g].score;
+            values[g] = results[g].score;
+            lines += results[g].lines;
+            if (results[g].ticks >= MAX_GAME_TICKS) capped++;
+        }
+
+        Estimate score = GetEstimate(values, games);
+
+        qsort(sorted, games, sizeof(int), CompareInts);
+
+        for (int g = 0; g < games; g++) values[g] = results[g].score - first[g].score;
+        Estimate difference = GetEstimate(values, games);
+
+        for (int g = 0; g < games; g++) values[g] = results[g].ticks/3600.0;
+        Estimate minutes = GetEstimate(values, games);
+
+        printf("%-*s %9.1f %8.1f %7.0f %7.0f %7.0f %+9.1f %8.1f %8.2f %7.2f %7.1f %6i\n", MAX_VARIANT_NAME - 8, job->variants[v].name,
+               score.mean, score.error, GetPercentile(sorted, games, 10), GetPercentile(sorted, games, 50), GetPercentile(sorted, games, 90),
+               difference.mean, difference.error, minutes.mean, minutes.error, lines/games, capped);
+    }
+
+    free(sorted);
+    free(values);
+}
+
+// Sample mean with a normal-approximation interval, fine from a few dozen games up
+static Estimate GetEstimate(const double *values, int count)
+{
+    Estimate estimate = { 0 };
+    double sum = 0.0;
+    double squares = 0.0;
+
+    for (int i = 0; i < count; i++) sum += values[i];
+    estimate.mean = sum/count;
+
+    if (count < 2) return estimate;
+
+    for (int i = 0; i < count; i++) squares += (values[i] - estimate.mean)*(values[i] - estimate.mean);
+    estimate.error = CONFIDENCE_Z*sqrt(squares/(count - 1)/count);
+
+    return estimate;
+}
+
+// Nearest-rank percentile of an ascending array
+static double GetPercentile(const int *sorted, int count, int percent)
+{
+    int rank = (percent*count + 99)/100;
+
+    return sorted[(rank > 0)? rank - 1 : 0];
+}
+
+static int CompareInts(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double GetWallTime(void)
+{
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+
+    return (double)now.tv_sec + now.tv_nsec*1e-9;
+}